@@ -0,0 +1,241 @@
+#ifndef LEVIN_DETAILS_BUCKET_BUILDER_H
+#define LEVIN_DETAILS_BUCKET_BUILDER_H
+
+#include <stdint.h>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include "levin_logger.h"
+#include "bin_writer.h"
+#include "parallel_utils.h"
+
+namespace levin {
+
+// @brief append-only array of fixed size blocks, grows without reallocation and copy of elements
+// so peak memory of building stays ~1x of elements, instead of ~3x of a vector doubling its capacity
+template <class T>
+class ChunkedArray {
+public:
+    static const size_t BLOCK_SHIFT = 16;
+    static const size_t BLOCK_SIZE = 1UL << BLOCK_SHIFT;
+    static const size_t BLOCK_MASK = BLOCK_SIZE - 1;
+
+    ChunkedArray() {}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T& operator[](size_t idx) { return _blocks[idx >> BLOCK_SHIFT][idx & BLOCK_MASK]; }
+    const T& operator[](size_t idx) const { return _blocks[idx >> BLOCK_SHIFT][idx & BLOCK_MASK]; }
+
+    void push_back(const T &value) {
+        if ((_size & BLOCK_MASK) == 0) {
+            _blocks.emplace_back(new T[BLOCK_SIZE]);
+        }
+        (*this)[_size++] = value;
+    }
+    // @brief append n elements, copied block by block
+    void append(const T *data, size_t n) {
+        while (n > 0) {
+            if ((_size & BLOCK_MASK) == 0) {
+                _blocks.emplace_back(new T[BLOCK_SIZE]);
+            }
+            size_t len = std::min(n, BLOCK_SIZE - (_size & BLOCK_MASK));
+            std::copy(data, data + len, &(*this)[_size]);
+            _size += len;
+            data += len;
+            n -= len;
+        }
+    }
+    void clear() {
+        _blocks.clear();
+        _size = 0;
+    }
+
+    // @brief sort elements in [begin, end), in place if within one block
+    template <class Compare>
+    void sort(size_t begin, size_t end, Compare comp) {
+        if (end - begin < 2) {
+            return;
+        }
+        if ((begin >> BLOCK_SHIFT) == ((end - 1) >> BLOCK_SHIFT)) {
+            std::sort(&(*this)[begin], &(*this)[end - 1] + 1, comp);
+            return;
+        }
+        std::vector<T> range;
+        range.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            range.push_back((*this)[i]);
+        }
+        std::sort(range.begin(), range.end(), comp);
+        for (size_t i = begin; i < end; ++i) {
+            (*this)[i] = range[i - begin];
+        }
+    }
+
+    // @brief write elements [begin, end) at binfile offset, block by block
+    bool write(BinWriter &writer, off_t offset, size_t begin, size_t end) const {
+        while (begin < end) {
+            size_t len = std::min(end - begin, BLOCK_SIZE - (begin & BLOCK_MASK));
+            if (!writer.write(&(*this)[begin], sizeof(T) * len, offset)) {
+                return false;
+            }
+            offset += sizeof(T) * len;
+            begin += len;
+        }
+        return true;
+    }
+    // @brief write pair elements [begin, end) in split layout(see SplitRecords), gathered block by block:
+    // first of element i at keys_offset + i * sizeof(first), second at values_offset + i * sizeof(second)
+    bool write_split(BinWriter &writer, off_t keys_offset, off_t values_offset, size_t begin, size_t end) const {
+        typedef typename T::first_type first_type;
+        typedef typename T::second_type second_type;
+        std::vector<first_type> firsts;
+        std::vector<second_type> seconds;
+        while (begin < end) {
+            size_t len = std::min(end - begin, BLOCK_SIZE - (begin & BLOCK_MASK));
+            const T *block = &(*this)[begin];
+            firsts.resize(len);
+            seconds.resize(len);
+            for (size_t i = 0; i < len; ++i) {
+                firsts[i] = block[i].first;
+                seconds[i] = block[i].second;
+            }
+            if (!writer.write(firsts.data(), sizeof(first_type) * len, keys_offset + sizeof(first_type) * begin) ||
+                    !writer.write(seconds.data(), sizeof(second_type) * len,
+                        values_offset + sizeof(second_type) * begin)) {
+                return false;
+            }
+            begin += len;
+        }
+        return true;
+    }
+
+private:
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+private:
+    std::vector<std::unique_ptr<T[]> > _blocks;
+    size_t _size = 0;
+};
+
+// @brief gaps of split records(see SplitRecords) of n pairs at records_offset zero filled:
+// between keys and values, and after values up to n pairs, so binfile is the same whatever writer
+// retval succ: true fail: false
+template <class Key, class Value>
+bool WriteSplitPadding(BinWriter &writer, off_t records_offset, size_t n) {
+    static const char zeros[4096] = {0};
+    size_t values_offset = SplitRecords<Key, Value>::ValuesOffset(n);
+    const size_t gaps[2][2] = {
+        {n * sizeof(Key), values_offset},
+        {values_offset + n * sizeof(Value), n * sizeof(std::pair<Key, Value>)}};
+    for (auto &gap : gaps) {
+        for (size_t pos = gap[0]; pos < gap[1]; pos += sizeof(zeros)) {
+            if (!writer.write(zeros, std::min(sizeof(zeros), gap[1] - pos), records_offset + pos)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// @brief permute records from begin into bucket order in place(American flag sort)
+// every record swapped straight into its bucket, so no per-bucket vector and no second copy of records
+// bucket_of: bucket index in [0, bucket_num) of a record, called about twice per record
+// counts: number of records per bucket
+template <class T, class BucketOf, class Count>
+void PermuteBuckets(ChunkedArray<T> &records, size_t begin, size_t bucket_num,
+        BucketOf bucket_of, const Count *counts) {
+    std::vector<size_t> heads(bucket_num);
+    size_t offset = begin;
+    for (size_t b = 0; b < bucket_num; ++b) {
+        heads[b] = offset;
+        offset += counts[b];
+    }
+    // buckets before b are filled, records in [heads[b], tail) of bucket b NOT placed yet
+    size_t tail = begin;
+    for (size_t b = 0; b < bucket_num; ++b) {
+        tail += counts[b];
+        while (heads[b] < tail) {
+            T record = records[heads[b]];
+            size_t dest = bucket_of(record);
+            while (dest != b) {
+                std::swap(record, records[heads[dest]++]);
+                dest = bucket_of(record);
+            }
+            records[heads[b]++] = record;
+        }
+    }
+}
+
+// @brief called after buckets [bucket_begin, bucket_end) partitioned, whose records start from record_begin
+// retval succ: true fail: false
+typedef std::function<bool(size_t bucket_begin, size_t bucket_end, size_t record_begin)> PartitionDone;
+
+// @brief partition records into bucket order in place and sort records of each bucket, by a pool of threads
+// records are first permuted into partitions of contiguous bucket ranges(radix by bucket),
+// then each partition is permuted into its buckets and sorted by one thread, and passed to done,
+// eg. to write its buckets at their final positions while other partitions are still sorted
+// layout of records is the same whatever thread_num
+// counts: number of records per bucket
+// retval succ: true fail: false, done failed
+template <class T, class BucketOf, class Compare>
+bool PartitionBuckets(ChunkedArray<T> &records, size_t bucket_count, BucketOf bucket_of, Compare comp,
+        uint32_t thread_num, std::vector<uint32_t> &counts, const PartitionDone &done) {
+    const size_t size = records.size();
+    counts.assign(bucket_count, 0);
+    if (bucket_count == 0) {
+        return done(0, 0, 0);
+    }
+    // partitions several times of threads, balanced on skewed buckets
+    size_t part_num = (thread_num <= 1 ? 1 : std::min<size_t>(bucket_count, thread_num * 4UL));
+    size_t part_width = (bucket_count + part_num - 1) / part_num;
+    part_num = (bucket_count + part_width - 1) / part_width;
+    std::vector<size_t> part_begins(part_num + 1, 0);
+    if (part_num > 1) {
+        auto part_of = [&bucket_of, part_width](const T &record) { return bucket_of(record) / part_width; };
+        // histogram of partitions counted by ranges of records
+        size_t range_num = thread_num;
+        size_t range_len = (size + range_num - 1) / range_num;
+        std::vector<std::vector<size_t> > histograms(range_num, std::vector<size_t>(part_num, 0));
+        ParallelRun(range_num, thread_num, [&](size_t r) {
+            for (size_t i = r * range_len; i < std::min(size, (r + 1) * range_len); ++i) {
+                ++histograms[r][part_of(records[i])];
+            }
+            return true;
+        });
+        std::vector<size_t> part_counts(part_num, 0);
+        for (size_t p = 0; p < part_num; ++p) {
+            for (size_t r = 0; r < range_num; ++r) {
+                part_counts[p] += histograms[r][p];
+            }
+            part_begins[p + 1] = part_begins[p] + part_counts[p];
+        }
+        PermuteBuckets(records, 0, part_num, part_of, part_counts.data());
+    } else {
+        part_begins[1] = size;
+    }
+    return ParallelRun(part_num, thread_num, [&](size_t p) {
+        size_t bucket_begin = p * part_width;
+        size_t bucket_end = std::min(bucket_count, bucket_begin + part_width);
+        size_t begin = part_begins[p];
+        size_t end = part_begins[p + 1];
+        for (size_t i = begin; i < end; ++i) {
+            ++counts[bucket_of(records[i])];
+        }
+        PermuteBuckets(records, begin, bucket_end - bucket_begin,
+                [&bucket_of, bucket_begin](const T &record) { return bucket_of(record) - bucket_begin; },
+                counts.data() + bucket_begin);
+        size_t pos = begin;
+        for (size_t b = bucket_begin; b < bucket_end; ++b) {
+            records.sort(pos, pos + counts[b], comp);
+            pos += counts[b];
+        }
+        return done(bucket_begin, bucket_end, begin);
+    });
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_DETAILS_BUCKET_BUILDER_H
@@ -0,0 +1,43 @@
+#ifndef LEVIN_DETAILS_FLAT_HASHMAP_H
+#define LEVIN_DETAILS_FLAT_HASHMAP_H
+
+#include <stdexcept>
+#include <utility>
+#include "flat_hashtable.hpp"
+
+namespace levin {
+
+template <class Key, class Value>
+struct FlatSelectFirst {
+    const Key& operator()(const std::pair<Key, Value> &slot) const { return slot.first; }
+};
+
+// @brief customized flat hashmap which MUST be inplacement new at allocated address
+// slot: pair<key, value> kept inline in groups, see FlatHashTable
+template <class Key, class Value, class Hash = std::hash<Key>, class Pred = std::equal_to<Key> >
+class FlatHashMap : public FlatHashTable<Key, std::pair<Key, Value>, FlatSelectFirst<Key, Value>, Hash, Pred> {
+public:
+    typedef FlatHashTable<Key, std::pair<Key, Value>, FlatSelectFirst<Key, Value>, Hash, Pred> table_type;
+    typedef Value mapped_type;
+
+    FlatHashMap() : table_type() {
+    }
+
+    // @brief throws out_of_range if key does not exist, as std unordered_map
+    const Value& at(const Key& k) const {
+        typename table_type::size_type pos = this->find_pos(k);
+        if (pos == this->capacity()) {
+            throw std::out_of_range("FlatHashMap::at key NOT found");
+        }
+        return this->slot(pos).second;
+    }
+};
+
+template <class Key, class Value, class Hash, class Pred>
+inline size_t container_memsize(const FlatHashMap<Key, Value, Hash, Pred> *object) {
+    return container_memsize(static_cast<const typename FlatHashMap<Key, Value, Hash, Pred>::table_type*>(object));
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_DETAILS_FLAT_HASHMAP_H
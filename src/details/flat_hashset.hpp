@@ -0,0 +1,31 @@
+#ifndef LEVIN_DETAILS_FLAT_HASHSET_H
+#define LEVIN_DETAILS_FLAT_HASHSET_H
+
+#include "flat_hashtable.hpp"
+
+namespace levin {
+
+template <class Key>
+struct FlatIdentity {
+    const Key& operator()(const Key &slot) const { return slot; }
+};
+
+// @brief customized flat hashset which MUST be inplacement new at allocated address
+// slot: key kept inline in groups, see FlatHashTable
+template <class Key, class Hash = std::hash<Key>, class Pred = std::equal_to<Key> >
+class FlatHashSet : public FlatHashTable<Key, Key, FlatIdentity<Key>, Hash, Pred> {
+public:
+    typedef FlatHashTable<Key, Key, FlatIdentity<Key>, Hash, Pred> table_type;
+
+    FlatHashSet() : table_type() {
+    }
+};
+
+template <class Key, class Hash, class Pred>
+inline size_t container_memsize(const FlatHashSet<Key, Hash, Pred> *object) {
+    return container_memsize(static_cast<const typename FlatHashSet<Key, Hash, Pred>::table_type*>(object));
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_DETAILS_FLAT_HASHSET_H
@@ -0,0 +1,287 @@
+#ifndef LEVIN_DETAILS_FLAT_HASHTABLE_H
+#define LEVIN_DETAILS_FLAT_HASHTABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <new>
+#include <sstream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "shared_utils.h"
+
+namespace levin {
+
+// @brief control byte of slot, one per slot, kept ahead of slots in group
+// empty: sign bit set; full: low 7 bits of hash(tag) with sign bit clear
+// container is immutable, so no tombstone
+static const int8_t FLAT_CTRL_EMPTY = -128;
+static const size_t FLAT_GROUP_WIDTH = 16;
+static const uint64_t FLAT_TAG_BITS = 7;
+static const uint64_t FLAT_TAG_MASK = (1UL << FLAT_TAG_BITS) - 1;
+// @brief group prefetched as a whole when probed, if NOT larger than this
+static const size_t FLAT_PREFETCH_BYTES = 512;
+
+// @brief bitmask of slots in group whose control byte equals tag, bit i for slot i
+LEVIN_INLINE uint32_t FlatGroupMatch(const int8_t *ctrl, int8_t tag) {
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < FLAT_GROUP_WIDTH; ++i) {
+        mask |= (uint32_t)(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+// @brief bitmask of empty slots in group
+LEVIN_INLINE uint32_t FlatGroupMatchEmpty(const int8_t *ctrl) {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < FLAT_GROUP_WIDTH; ++i) {
+        mask |= (uint32_t)(ctrl[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+template <class Table>
+class FlatHashIterator;
+
+// @brief open addressing hash table(swiss table style) which MUST be inplacement new at allocated address
+// slots kept inline in groups of 16, each group led by 16 control bytes probed by one SIMD compare,
+// so a hit touches the group only, instead of bucket header followed by bucket array
+// group of hash reduced by multiply-shift(no division), groups probed linearly; immutable, built once by Build
+// layout: [ _size | _group_count | group 0 | group 1 | ... ]
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+class FlatHashTable {
+public:
+    // @brief typedefs
+    typedef Key                           key_type;
+    typedef Slot                          value_type;
+    typedef size_t                        size_type;
+    typedef FlatHashIterator<FlatHashTable> iterator;
+    typedef FlatHashIterator<FlatHashTable> const_iterator;
+    struct Group {
+        int8_t ctrl[FLAT_GROUP_WIDTH];
+        Slot slots[FLAT_GROUP_WIDTH];
+    };
+
+    // @breif constructor&destructor
+    FlatHashTable() : _size(0), _group_count(1) {
+    }
+    ~FlatHashTable() { /* do NOT delete[] */ }
+
+    // @brief debugging
+    std::string layout() const;
+
+    // @brief Capacity
+    bool empty() const { return _size == 0; }
+    size_type size() const { return _size; }
+    size_type group_count() const { return _group_count; }
+    size_type capacity() const { return group_count() * FLAT_GROUP_WIDTH; }
+    double load_factor() const { return (double)_size / capacity(); }
+
+    // @brief Element lookup
+    const_iterator find(const Key& k) const { return const_iterator(this, find_pos(k)); }
+    size_type count(const Key& k) const { return (find_pos(k) == capacity() ? 0 : 1); }
+    // @brief slot position of key, capacity() if NOT found
+    size_type find_pos(const Key& k) const;
+
+    // @brief Iterators
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // @brief Slots(no range check)
+    const Group* groups() const { return (const Group*)(this + 1); }
+    bool is_full(size_type pos) const {
+        return groups()[pos / FLAT_GROUP_WIDTH].ctrl[pos % FLAT_GROUP_WIDTH] >= 0;
+    }
+    const Slot& slot(size_type pos) const {
+        return groups()[pos / FLAT_GROUP_WIDTH].slots[pos % FLAT_GROUP_WIDTH];
+    }
+
+    bool operator ==(const FlatHashTable &other) const;
+    bool operator !=(const FlatHashTable &other) const { return !(*this == other); }
+
+    // @brief groups of n slots at max load factor 4/5, with 1 empty slot at least to end probing
+    static size_type GroupCount(size_type n) {
+        size_type need = n + n / 4 + 1;
+        return (need + FLAT_GROUP_WIDTH - 1) / FLAT_GROUP_WIDTH;
+    }
+    // @brief memory size of container of n slots
+    static size_t Memsize(size_type n) {
+        return sizeof(FlatHashTable) + GroupCount(n) * sizeof(Group);
+    }
+    // @brief container of n slots [first, last) built at buf of Memsize(n) bytes zero filled
+    // slots of duplicated key dropped except the first one
+    template <class Iter>
+    static void Build(char *buf, size_type n, Iter first, Iter last);
+
+private:
+    FlatHashTable(const FlatHashTable&) = delete;
+    FlatHashTable(FlatHashTable&&) = delete;
+    FlatHashTable& operator =(const FlatHashTable&) = delete;
+    FlatHashTable& operator =(FlatHashTable&&) = delete;
+
+    // @brief insert slot while building, retval false if key exists
+    bool _insert(const Slot &slot);
+    // @brief group of hash: high bits of hash scaled into [0, _group_count)
+    size_type _group_of(uint64_t hash) const {
+        return FastRange64(hash, _group_count);
+    }
+
+private:
+    size_type _size = 0;
+    size_type _group_count = 1;
+};
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+LEVIN_INLINE typename FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::size_type
+FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::find_pos(const Key& k) const {
+    uint64_t hash = HashMix64(Hash()(k));
+    int8_t tag = hash & FLAT_TAG_MASK;
+    size_type g = _group_of(hash);
+    const Group *groups = this->groups();
+    KeyOf key_of;
+    Pred pred;
+    while (true) {
+        const Group &group = groups[g];
+        // slot lines fetched along with control bytes, instead of after matched
+        if (sizeof(Group) <= FLAT_PREFETCH_BYTES) {
+            for (size_t line = 0; line < sizeof(Group); line += 64) {
+                __builtin_prefetch((const char*)&group + line);
+            }
+        }
+        for (uint32_t match = FlatGroupMatch(group.ctrl, tag); match != 0; match &= match - 1) {
+            uint32_t i = __builtin_ctz(match);
+            if (pred(key_of(group.slots[i]), k)) {
+                return g * FLAT_GROUP_WIDTH + i;
+            }
+        }
+        // empty slot found: key would be placed here or before while building
+        if (FlatGroupMatchEmpty(group.ctrl) != 0) {
+            return capacity();
+        }
+        g = (g + 1 == _group_count ? 0 : g + 1);
+    }
+}
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+bool FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::_insert(const Slot &slot) {
+    KeyOf key_of;
+    uint64_t hash = HashMix64(Hash()(key_of(slot)));
+    if (find_pos(key_of(slot)) != capacity()) {
+        return false;
+    }
+    Group *groups = (Group*)(this + 1);
+    size_type g = _group_of(hash);
+    while (true) {
+        uint32_t empty = FlatGroupMatchEmpty(groups[g].ctrl);
+        if (empty != 0) {
+            uint32_t i = __builtin_ctz(empty);
+            groups[g].ctrl[i] = hash & FLAT_TAG_MASK;
+            new (&groups[g].slots[i]) Slot(slot);
+            ++_size;
+            return true;
+        }
+        g = (g + 1 == _group_count ? 0 : g + 1);
+    }
+}
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+template <class Iter>
+void FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::Build(char *buf, size_type n, Iter first, Iter last) {
+    FlatHashTable *table = new (buf) FlatHashTable();
+    size_type group_count = GroupCount(n);
+    table->_group_count = group_count;
+    Group *groups = (Group*)(table + 1);
+    for (size_type g = 0; g < group_count; ++g) {
+        memset(groups[g].ctrl, FLAT_CTRL_EMPTY, sizeof(groups[g].ctrl));
+    }
+    for (; first != last && table->_size < n; ++first) {
+        table->_insert(Slot(*first));
+    }
+}
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+bool FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::operator ==(const FlatHashTable &other) const {
+    if (_size != other._size || _group_count != other._group_count) {
+        return false;
+    }
+    for (size_type pos = 0; pos < capacity(); ++pos) {
+        if (is_full(pos) != other.is_full(pos) || (is_full(pos) && !(slot(pos) == other.slot(pos)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+std::string FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::layout() const {
+    std::stringstream ss;
+    ss << "FlatHashTable this=[" << (void*)this << "]" << std::endl
+       << "[" << (void*)&_size << "]\t\t_size=" << _size << std::endl
+       << "[" << (void*)&_group_count << "]\t\t_group_count=" << _group_count << std::endl
+       << "[" << (void*)groups() << "]\t\tgroups=" << group_count()
+       << ", group size=" << sizeof(Group) << ", load factor=" << load_factor();
+    return ss.str();
+}
+
+template <class Key, class Slot, class KeyOf, class Hash, class Pred>
+inline size_t container_memsize(const FlatHashTable<Key, Slot, KeyOf, Hash, Pred> *object) {
+    return sizeof(*object) + object->group_count() *
+            sizeof(typename FlatHashTable<Key, Slot, KeyOf, Hash, Pred>::Group);
+}
+
+// @brief forward iterator over full slots, in slot order
+template <class Table>
+class FlatHashIterator {
+public:
+    typedef typename Table::value_type value_type;
+    typedef typename Table::size_type  size_type;
+
+    FlatHashIterator() : _table(nullptr), _pos(0) {
+    }
+    FlatHashIterator(const Table *table, size_type pos) : _table(table), _pos(pos) {
+        _skip_empty();
+    }
+    const value_type& operator*() const { return _table->slot(_pos); }
+    const value_type* operator->() const { return &_table->slot(_pos); }
+    FlatHashIterator& operator++() {
+        ++_pos;
+        _skip_empty();
+        return *this;
+    }
+    FlatHashIterator operator++(int) {
+        FlatHashIterator it = *this;
+        ++(*this);
+        return it;
+    }
+    bool operator==(const FlatHashIterator &other) const {
+        return _table == other._table && _pos == other._pos;
+    }
+    bool operator!=(const FlatHashIterator &other) const { return !(*this == other); }
+
+private:
+    void _skip_empty() {
+        size_type capacity = _table->capacity();
+        while (_pos < capacity && !_table->is_full(_pos)) {
+            ++_pos;
+        }
+    }
+
+private:
+    const Table *_table;
+    size_type _pos;
+};  // class FlatHashIterator
+
+}  // namespace levin
+
+#endif  // LEVIN_DETAILS_FLAT_HASHTABLE_H
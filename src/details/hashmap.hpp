@@ -49,8 +49,25 @@ public:
     bool operator ==(const HashMap<Key, Value, Hash> &other) const;
     bool operator !=(const HashMap<Key, Value, Hash> &other) const { return !(*this == other); }
 
+    // @brief bucket of key by hash % bucket count, binfile of BucketReduce::Mod only
     iterator find(const Key& key);
+    // @brief bucket of key by reducer matching the reduction recorded in binfile
+    // layout: of bucket records recorded in binfile, pair of split record synthesized by iterator
+    iterator find(const Key& key, const BucketReducer &reducer, BucketLayout layout = BucketLayout::Pair);
+    // @brief value of key in memory region, nullptr if NOT found
+    const Value* find_value(const Key& key, const BucketReducer &reducer, BucketLayout layout) const;
+    // @brief n keys found group by group(FIND_BATCH_GROUP): bucket headers of group prefetched,
+    // then bucket records(keys only of split layout), then searched, so cache misses of a group overlapped
+    // values[i]: value of keys[i], nullptr if NOT found; retval number of keys found
+    size_type find_batch(const Key *keys, size_type n, const BucketReducer &reducer, const Value **values,
+            BucketLayout layout = BucketLayout::Pair) const;
+    // @brief bucket header of key prefetched, hint for find of key later
+    void prefetch(const Key& key, const BucketReducer &reducer) const {
+        __builtin_prefetch(&_datas[reducer(Hash()(key))]);
+    }
     iterator begin();
+    // @brief iteration of split layout, in the same order as pair layout
+    iterator begin(BucketLayout layout);
     iterator end();
     const_iterator begin() const;
     const_iterator end() const;
@@ -63,6 +80,16 @@ public:
     // If key does not match the key of any element in the container, the function throws an out_of_range exception.
     const Value& at (const Key& key);
 private:
+    iterator _find_in(size_type bucket_idx, const Key& key);
+    // @brief position of key in bucket, -1 if NOT found
+    int32_t _search(const bucket_type &bucket, const Key& key, BucketLayout layout) const;
+    // @brief split layout: record of bucket position it is it - _records(), its value _split_values()[record]
+    const value_type* _records() const { return _datas[0].data(); }
+    const Value* _split_values() const { return SplitRecords<Key, Value>::Values(_records(), _size); }
+    const Key* _split_keys(const bucket_type &bucket) const {
+        return SplitRecords<Key, Value>::Keys(_records()) + (bucket.data() - _records());
+    }
+
     HashMap(const HashMap<Key, Value, Hash>&) = delete;
     HashMap(HashMap<Key, Value, Hash>&&) = delete;
     HashMap<Key, Value, Hash>& operator =(const HashMap<Key, Value, Hash>&) = delete;
@@ -91,6 +118,13 @@ typename HashMap<Key, Value, Hash>::iterator HashMap<Key, Value, Hash>::begin()
     return HashIterator<Key, Value>(0, _datas[0].begin(), this);
 }
 template <class Key, class Value, class Hash>
+typename HashMap<Key, Value, Hash>::iterator HashMap<Key, Value, Hash>::begin(BucketLayout layout) {
+    if (layout == BucketLayout::Split) {
+        return HashIterator<Key, Value>(0, _datas[0].begin(), this, _records(), _split_values());
+    }
+    return begin();
+}
+template <class Key, class Value, class Hash>
 typename HashMap<Key, Value, Hash>::const_iterator HashMap<Key, Value, Hash>::begin() const {
     return HashIterator<Key, Value>(0, _datas[0].begin(), this);
 }
@@ -106,7 +140,46 @@ typename HashMap<Key, Value, Hash>::const_iterator HashMap<Key, Value, Hash>::en
 
 template <class Key, class Value, class Hash>
 typename HashMap<Key, Value, Hash>::iterator HashMap<Key, Value, Hash>::find(const Key& key) {
-    uint32_t bucket_idx = Hash()(key) % _bucket_size;
+    return _find_in(Hash()(key) % _bucket_size, key);
+}
+
+template <class Key, class Value, class Hash>
+typename HashMap<Key, Value, Hash>::iterator HashMap<Key, Value, Hash>::find(
+        const Key& key, const BucketReducer &reducer, BucketLayout layout) {
+    if (layout == BucketLayout::Split) {
+        auto &bucket = _datas[reducer(Hash()(key))];
+        int32_t pos = _search(bucket, key, layout);
+        if (pos >= 0) {
+            return HashIterator<Key, Value>(pos, bucket.begin() + pos, this, _records(), _split_values());
+        }
+        return end();
+    }
+    return _find_in(reducer(Hash()(key)), key);
+}
+
+template <class Key, class Value, class Hash>
+const Value* HashMap<Key, Value, Hash>::find_value(
+        const Key& key, const BucketReducer &reducer, BucketLayout layout) const {
+    auto &bucket = _datas[reducer(Hash()(key))];
+    int32_t pos = _search(bucket, key, layout);
+    if (pos < 0) {
+        return nullptr;
+    }
+    return (layout == BucketLayout::Split ? &_split_values()[bucket.data() + pos - _records()] :
+            &bucket[pos].second);
+}
+
+template <class Key, class Value, class Hash>
+int32_t HashMap<Key, Value, Hash>::_search(const bucket_type &bucket, const Key& key, BucketLayout layout) const {
+    int32_t pos = (layout == BucketLayout::Split ?
+            binary_search(_split_keys(bucket), (int)bucket.size() - 1, key) :
+            binary_search(bucket.data(), (int)bucket.size() - 1, key));
+    return (pos >= 0 && pos < bucket.size() ? pos : -1);
+}
+
+template <class Key, class Value, class Hash>
+typename HashMap<Key, Value, Hash>::iterator HashMap<Key, Value, Hash>::_find_in(
+        size_type bucket_idx, const Key& key) {
     auto &bucket = _datas[bucket_idx];
     int32_t pos = binary_search(&bucket[0], bucket.size() - 1, key);
     if (pos >= 0 && pos < bucket.size() && bucket[pos].first == key) {
@@ -130,6 +203,41 @@ const Value& HashMap<Key, Value, Hash>::at(const Key& key) {
     return find(key)->second;
 }
 
+template <class Key, class Value, class Hash>
+typename HashMap<Key, Value, Hash>::size_type HashMap<Key, Value, Hash>::find_batch(
+        const Key *keys, size_type n, const BucketReducer &reducer, const Value **values,
+        BucketLayout layout) const {
+    const bucket_type *buckets[FIND_BATCH_GROUP];
+    const bool split = (layout == BucketLayout::Split);
+    const Value *split_values = (split ? _split_values() : nullptr);
+    size_type found = 0;
+    for (size_type begin = 0; begin < n; begin += FIND_BATCH_GROUP) {
+        size_type group = std::min(FIND_BATCH_GROUP, n - begin);
+        for (size_type i = 0; i < group; ++i) {
+            buckets[i] = &_datas[reducer(Hash()(keys[begin + i]))];
+            __builtin_prefetch(buckets[i]);
+        }
+        for (size_type i = 0; i < group; ++i) {
+            if (split) {
+                PrefetchRange(_split_keys(*buckets[i]), buckets[i]->size() * sizeof(Key));
+            } else {
+                PrefetchRange(buckets[i]->data(), buckets[i]->size() * sizeof(value_type));
+            }
+        }
+        for (size_type i = 0; i < group; ++i) {
+            const bucket_type &bucket = *buckets[i];
+            int32_t pos = _search(bucket, keys[begin + i], layout);
+            if (pos >= 0) {
+                values[begin + i] = (split ? &split_values[bucket.data() + pos - _records()] : &bucket[pos].second);
+                ++found;
+            } else {
+                values[begin + i] = nullptr;
+            }
+        }
+    }
+    return found;
+}
+
 template <class Key, class Value, class Hash>
 void HashMap<Key, Value, Hash>::swap(HashMap<Key, Value, Hash> &other) {
     std::swap(_size, other._size);
@@ -169,25 +277,33 @@ public:
         _it = typename HashMap<Key, Value>::bucket_type::iterator();
         _hashmap = nullptr;
     }
+    // @brief records/values: split layout, pair of record synthesized on access; nullptr: pair layout
     HashIterator(int32_t pos,
             typename HashMap<Key, Value>::bucket_type::iterator vit,
-            const HashMap<Key, Value>* hashmap) :
+            const HashMap<Key, Value>* hashmap,
+            const typename HashMap<Key, Value>::value_type* records = nullptr,
+            const Value* values = nullptr) :
          _pos(pos),
          _it(vit),
-         _hashmap(hashmap) {
+         _hashmap(hashmap),
+         _records(records),
+         _values(values) {
     }
     ~HashIterator() {}
     const typename HashMap<Key, Value>::value_type& operator*() const {
-        if (_pos == -1) {
-            throw std::out_of_range("accessed position out of range");
-        }
-        return *_it;
+        return *operator->();
     }
     const typename HashMap<Key, Value>::value_type* operator->() const {
         if (_pos == -1) {
             throw std::out_of_range("accessed position out of range");
         }
-        return _it;
+        if (_records == nullptr) {
+            return _it;
+        }
+        size_t record = _it - _records;
+        _kvpair.first = SplitRecords<Key, Value>::Keys(_records)[record];
+        _kvpair.second = _values[record];
+        return &_kvpair;
     }
     bool operator==(const HashIterator& hsit) const {
         return (_hashmap == hsit._hashmap) && (_it == hsit._it);
@@ -203,6 +319,9 @@ private:
     int32_t _pos;
     typename HashMap<Key, Value>::bucket_type::iterator _it;
     const HashMap<Key, Value>* _hashmap;
+    const typename HashMap<Key, Value>::value_type* _records = nullptr;
+    const Value* _values = nullptr;
+    mutable typename HashMap<Key, Value>::value_type _kvpair;
 };  // class HashIterator
 
 }  // namespace levin
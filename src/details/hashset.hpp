@@ -36,8 +36,21 @@ public:
     size_type size() const { return _size; }
 
     // @brief Element lookup
-    const_iterator find(const Key& k) const;
+    // @brief bucket of key by hash % bucket count, binfile of BucketReduce::Mod only
+    const_iterator find(const Key& k) const { return _find_in(Hash()(k) % _bucket_count, k); }
+    // @brief bucket of key by reducer matching the reduction recorded in binfile
+    const_iterator find(const Key& k, const BucketReducer &reducer) const {
+        return _find_in(reducer(Hash()(k)), k);
+    }
     size_type count(const Key& k) const { return (find(k) == cend() ? 0 : 1); }
+    // @brief n keys found group by group(FIND_BATCH_GROUP): bucket headers of group prefetched,
+    // then bucket keys, then searched, so cache misses of a group overlapped instead of serial
+    // results[i]: key found of keys[i], nullptr if NOT found; retval number of keys found
+    size_type find_batch(const Key *keys, size_type n, const BucketReducer &reducer, const Key **results) const;
+    // @brief bucket header of key prefetched, hint for find of key later
+    void prefetch(const Key& k, const BucketReducer &reducer) const {
+        __builtin_prefetch(&_datas[reducer(Hash()(k))]);
+    }
 
     // @brief Buckets
     size_type bucket_count() const { return _bucket_count; }
@@ -58,6 +71,8 @@ public:
     bool operator !=(const HashSet<Key, Hash, Pred> &other) const { return !(*this == other); }
 
 private:
+    const_iterator _find_in(size_type bucket_idx, const Key& k) const;
+
     HashSet(const HashSet<Key, Hash, Pred>&) = delete;
     HashSet(HashSet<Key, Hash, Pred>&&) = delete;
     HashSet<Key, Hash, Pred>& operator =(const HashSet<Key, Hash, Pred>&) = delete;
@@ -70,9 +85,9 @@ private:
 };
 
 template <class Key, class Hash, class Pred>
-LEVIN_INLINE typename HashSet<Key, Hash, Pred>::const_iterator HashSet<Key, Hash, Pred>::find(
-        const Key& k) const {
-    const auto &bucket = _datas[Hash()(k) % _bucket_count];
+LEVIN_INLINE typename HashSet<Key, Hash, Pred>::const_iterator HashSet<Key, Hash, Pred>::_find_in(
+        size_type bucket_idx, const Key& k) const {
+    const auto &bucket = _datas[bucket_idx];
     Pred pred;
     for (const auto &item : bucket) {
         if (pred(item, k)) {
@@ -82,6 +97,35 @@ LEVIN_INLINE typename HashSet<Key, Hash, Pred>::const_iterator HashSet<Key, Hash
     return cend();
 }
 
+template <class Key, class Hash, class Pred>
+typename HashSet<Key, Hash, Pred>::size_type HashSet<Key, Hash, Pred>::find_batch(
+        const Key *keys, size_type n, const BucketReducer &reducer, const Key **results) const {
+    const bucket_type *buckets[FIND_BATCH_GROUP];
+    size_type found = 0;
+    for (size_type begin = 0; begin < n; begin += FIND_BATCH_GROUP) {
+        size_type group = std::min(FIND_BATCH_GROUP, n - begin);
+        for (size_type i = 0; i < group; ++i) {
+            buckets[i] = &_datas[reducer(Hash()(keys[begin + i]))];
+            __builtin_prefetch(buckets[i]);
+        }
+        for (size_type i = 0; i < group; ++i) {
+            PrefetchRange(buckets[i]->data(), buckets[i]->size() * sizeof(value_type));
+        }
+        Pred pred;
+        for (size_type i = 0; i < group; ++i) {
+            results[begin + i] = nullptr;
+            for (const auto &item : *buckets[i]) {
+                if (pred(item, keys[begin + i])) {
+                    results[begin + i] = &item;
+                    ++found;
+                    break;
+                }
+            }
+        }
+    }
+    return found;
+}
+
 template <class Key, class Hash, class Pred>
 void HashSet<Key, Hash, Pred>::swap(HashSet<Key, Hash, Pred> &other) {
     std::swap(_size, other._size);
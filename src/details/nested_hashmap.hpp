@@ -59,8 +59,23 @@ public:
         return !(*this == other);
     }
 
+    // @brief bucket of key by hash % bucket count, binfile of BucketReduce::Mod only
     iterator find(const Key& key);
+    // @brief bucket of key by reducer matching the reduction recorded in binfile
+    // layout: of index records recorded in binfile, split into keys and value array positions
+    iterator find(const Key& key, const BucketReducer &reducer, BucketLayout layout = BucketLayout::Pair);
+    // @brief n keys found group by group(FIND_BATCH_GROUP): index bucket headers of group prefetched,
+    // then index records(keys only of split layout), then searched and value array headers prefetched for caller
+    // arrays[i]: value array of keys[i], nullptr if NOT found; retval number of keys found
+    size_type find_batch(const Key *keys, size_type n, const BucketReducer &reducer,
+            const data_array_type **arrays, BucketLayout layout = BucketLayout::Pair);
+    // @brief index bucket header of key prefetched, hint for find of key later
+    void prefetch(const Key& key, const BucketReducer &reducer) const {
+        __builtin_prefetch(&_index_datas[reducer(Hash()(key))]);
+    }
     iterator begin();
+    // @brief iteration of split layout, in the same order as pair layout
+    iterator begin(BucketLayout layout);
     iterator end();
     const_iterator begin() const;
     const_iterator end() const;
@@ -73,6 +88,16 @@ public:
                 (void *)((char *)&_index_datas + _index_size + sizeof(index_impl_type)));
     }
 private:
+    iterator _find_in(size_type bucket_idx, const Key& key);
+    // @brief position of key in index bucket, -1 if NOT found
+    int32_t _search(const index_bucket_type &bucket, const Key& key, BucketLayout layout) const;
+    // @brief split layout: index record of bucket position it is it - _records()
+    const index_value_type* _records() const { return _index_datas[0].data(); }
+    const size_t* _split_positions() const { return SplitRecords<Key, size_t>::Values(_records(), _size); }
+    const Key* _split_keys(const index_bucket_type &bucket) const {
+        return SplitRecords<Key, size_t>::Keys(_records()) + (bucket.data() - _records());
+    }
+
     NestedHashMap(const NestedHashMap<Key, Value, Hash>&) = delete;
     NestedHashMap(NestedHashMap<Key, Value, Hash>&&) = delete;
     NestedHashMap<Key, Value, Hash>& operator=(const NestedHashMap<Key, Value, Hash>&) = delete;
@@ -109,6 +134,15 @@ typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Has
             _index_datas[_index_datas.size()-1].end(), data_array(), this);
 }
 template <class Key, class Value, class Hash>
+typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Hash>::begin(BucketLayout layout) {
+    if (layout == BucketLayout::Split) {
+        return NHashIterator<Key, Value>(
+                0, _index_datas[0].begin(),
+                _index_datas[_index_datas.size()-1].end(), data_array(), this, _records(), _split_positions());
+    }
+    return begin();
+}
+template <class Key, class Value, class Hash>
 typename NestedHashMap<Key, Value, Hash>::const_iterator NestedHashMap<Key, Value, Hash>::begin() const {
     return NHashIterator<Key, Value>(
             0, _index_datas[0].begin(),
@@ -131,7 +165,37 @@ typename NestedHashMap<Key, Value, Hash>::const_iterator NestedHashMap<Key, Valu
 
 template <class Key, class Value, class Hash>
 typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Hash>::find(const Key& key) {
-    uint32_t bucket_idx = Hash()(key) % _bucket_size;
+    return _find_in(Hash()(key) % _bucket_size, key);
+}
+
+template <class Key, class Value, class Hash>
+typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Hash>::find(
+        const Key& key, const BucketReducer &reducer, BucketLayout layout) {
+    if (layout == BucketLayout::Split) {
+        auto &bucket = _index_datas[reducer(Hash()(key))];
+        int32_t pos = _search(bucket, key, layout);
+        if (pos >= 0) {
+            return NHashIterator<Key, Value>(
+                    pos, bucket.begin() + pos,
+                    _index_datas[_index_datas.size()-1].end(), data_array(), this, _records(), _split_positions());
+        }
+        return end();
+    }
+    return _find_in(reducer(Hash()(key)), key);
+}
+
+template <class Key, class Value, class Hash>
+int32_t NestedHashMap<Key, Value, Hash>::_search(
+        const index_bucket_type &bucket, const Key& key, BucketLayout layout) const {
+    int32_t pos = (layout == BucketLayout::Split ?
+            binary_search(_split_keys(bucket), (int)bucket.size() - 1, key) :
+            binary_search(bucket.data(), (int)bucket.size() - 1, key));
+    return (pos >= 0 && pos < bucket.size() ? pos : -1);
+}
+
+template <class Key, class Value, class Hash>
+typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Hash>::_find_in(
+        size_type bucket_idx, const Key& key) {
     auto &bucket = _index_datas[bucket_idx];
     int32_t pos = binary_search(&bucket[0], bucket.size() - 1, key);
     if (pos >= 0 && pos < bucket.size() && bucket[pos].first == key) {
@@ -142,6 +206,44 @@ typename NestedHashMap<Key, Value, Hash>::iterator NestedHashMap<Key, Value, Has
     return end();
 }
 
+template <class Key, class Value, class Hash>
+typename NestedHashMap<Key, Value, Hash>::size_type NestedHashMap<Key, Value, Hash>::find_batch(
+        const Key *keys, size_type n, const BucketReducer &reducer, const data_array_type **arrays,
+        BucketLayout layout) {
+    const index_bucket_type *buckets[FIND_BATCH_GROUP];
+    const data_impl_type &array = *data_array();
+    const bool split = (layout == BucketLayout::Split);
+    const size_t *split_positions = (split ? _split_positions() : nullptr);
+    size_type found = 0;
+    for (size_type begin = 0; begin < n; begin += FIND_BATCH_GROUP) {
+        size_type group = std::min(FIND_BATCH_GROUP, n - begin);
+        for (size_type i = 0; i < group; ++i) {
+            buckets[i] = &_index_datas[reducer(Hash()(keys[begin + i]))];
+            __builtin_prefetch(buckets[i]);
+        }
+        for (size_type i = 0; i < group; ++i) {
+            if (split) {
+                PrefetchRange(_split_keys(*buckets[i]), buckets[i]->size() * sizeof(Key));
+            } else {
+                PrefetchRange(buckets[i]->data(), buckets[i]->size() * sizeof(index_value_type));
+            }
+        }
+        for (size_type i = 0; i < group; ++i) {
+            const index_bucket_type &bucket = *buckets[i];
+            int32_t pos = _search(bucket, keys[begin + i], layout);
+            if (pos >= 0) {
+                arrays[begin + i] = &array[split ?
+                        split_positions[bucket.data() + pos - _records()] : bucket[pos].second];
+                __builtin_prefetch(arrays[begin + i]);
+                ++found;
+            } else {
+                arrays[begin + i] = nullptr;
+            }
+        }
+    }
+    return found;
+}
+
 template <class Key, class Value, class Hash>
 void NestedHashMap<Key, Value, Hash>::swap(NestedHashMap<Key, Value, Hash> &other) {
     std::swap(_size, other._size);
@@ -196,14 +298,17 @@ public:
             typename NestedHashMap<Key, Value>::index_bucket_type::iterator vit,
             typename NestedHashMap<Key, Value>::index_bucket_type::iterator endit,
             typename NestedHashMap<Key, Value>::data_impl_type* array,
-            const NestedHashMap<Key, Value>* hashmap) :
+            const NestedHashMap<Key, Value>* hashmap,
+            const typename NestedHashMap<Key, Value>::index_value_type* records = nullptr,
+            const size_t* positions = nullptr) :
             _pos(pos),
             _it(vit),
             _endit(endit),
             _array(array),
-            _hashmap(hashmap) {
-                _kvpair.first = _it->first;
-                _kvpair.second = &((*_array)[_it->second]);
+            _hashmap(hashmap),
+            _records(records),
+            _positions(positions) {
+                _load();
     }
     ~NHashIterator() {}
     const typename NestedHashMap<Key, Value>::value_type& operator*() const {
@@ -227,22 +332,38 @@ public:
     NHashIterator<Key, Value>& operator++();
 
 private:
+    // @brief pair of record at _it, from key&position split apart if _records NOT nullptr
+    void _load();
+
     int32_t _pos;
     typename NestedHashMap<Key, Value>::index_bucket_type::iterator _it;
     typename NestedHashMap<Key, Value>::index_bucket_type::iterator _endit;
     typename NestedHashMap<Key, Value>::value_type _kvpair;
     typename NestedHashMap<Key, Value>::data_impl_type* _array = nullptr;
     const NestedHashMap<Key, Value>* _hashmap = nullptr;
+    const typename NestedHashMap<Key, Value>::index_value_type* _records = nullptr;
+    const size_t* _positions = nullptr;
 };
 
 template<class Key, class Value>
 NHashIterator<Key, Value>& NHashIterator<Key, Value>::operator++() {
     ++_it;
     if (_it != _endit) {
+        _load();
+    }
+    return *this;
+}
+
+template<class Key, class Value>
+void NHashIterator<Key, Value>::_load() {
+    if (_records == nullptr) {
         _kvpair.first = _it->first;
         _kvpair.second = &((*_array)[_it->second]);
+    } else if (_it != _endit) {
+        size_t record = _it - _records;
+        _kvpair.first = SplitRecords<Key, size_t>::Keys(_records)[record];
+        _kvpair.second = &((*_array)[_positions[record]]);
     }
-    return *this;
 }
 
 }  // namespace levin
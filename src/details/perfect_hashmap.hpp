@@ -0,0 +1,340 @@
+#ifndef LEVIN_DETAILS_PERFECT_HASHMAP_H
+#define LEVIN_DETAILS_PERFECT_HASHMAP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "shared_utils.h"
+
+namespace levin {
+
+// @brief keys partitioned by hash, minimal perfect hash(PTHash style) of each partition built independently
+// average keys per partition, small enough for pilot search in cache and partitions built by threads
+static const uint64_t PERFECT_PARTITION_KEYS = 1UL << 16;
+// @brief average keys per bucket, pilot of 16 bits per bucket: 16/6 bits per key
+static const uint64_t PERFECT_BUCKET_KEYS = 6;
+// @brief table of partition 1% larger than keys, positions out of keys remapped to free ones
+static const uint64_t PERFECT_TABLE_SLACK = 100;
+static const uint64_t PERFECT_MAX_PILOT = 65535;
+// @brief skewed buckets: 60% of keys into 30% of buckets, large buckets placed first while table empty
+static const uint64_t PERFECT_DENSE_THRESHOLD = 0x9999999999999999UL;
+static const uint64_t PERFECT_SEED_BUCKET = 0x5bd1e9955bd1e995UL;
+static const uint64_t PERFECT_SEED_POS = 0x9e3779b97f4a7c15UL;
+static const uint64_t PERFECT_SEED_PILOT = 0xc2b2ae3d27d4eb4fUL;
+
+// @brief descriptor of partition: keys [key_begin, key_begin + size) of value array
+struct PerfectPartition {
+    uint64_t key_begin;
+    uint64_t pilot_begin;
+    uint64_t free_begin;
+    uint64_t size;
+};
+
+// @brief hashes of key by which it is placed, fixed by binfile layout
+struct PerfectKeyHash {
+    uint64_t hash;      // partition
+    uint64_t bucket;    // bucket in partition
+    uint64_t pos;       // position in table of partition with pilot, and fingerprint in low bits
+
+    explicit PerfectKeyHash(uint64_t h) :
+            hash(h),
+            bucket(HashMix64(h ^ PERFECT_SEED_BUCKET)),
+            pos(HashMix64(h ^ PERFECT_SEED_POS)) {
+    }
+    static uint64_t BucketCount(uint64_t size) {
+        return size / PERFECT_BUCKET_KEYS + 1;
+    }
+    static uint64_t TableSize(uint64_t size) {
+        return size + size / PERFECT_TABLE_SLACK + 1;
+    }
+    LEVIN_INLINE uint64_t bucket_of(uint64_t bucket_count) const {
+        uint64_t dense = (bucket_count * 3 + 9) / 10;
+        uint64_t x = (bucket >> 32) | (bucket << 32);
+        return (bucket < PERFECT_DENSE_THRESHOLD || dense == bucket_count ?
+                FastRange64(x, dense) : dense + FastRange64(x, bucket_count - dense));
+    }
+    LEVIN_INLINE uint64_t pos_of(uint64_t pilot, uint64_t table_size) const {
+        // mixed after pilot applied: positions of keys in the same bucket NOT correlated
+        return FastRange64(HashMix64(pos ^ (pilot * PERFECT_SEED_PILOT)), table_size);
+    }
+};
+
+// @brief customized minimal perfect hashmap which MUST be inplacement new at allocated address
+// keys NOT stored: value of key found by pilot of its bucket, at most one remap, exactly one value access
+// fingerprint of key kept per value if fingerprint bits > 0, to reject most absent keys;
+// without fingerprint, an absent key is mapped to the value of some key
+// layout: [ this | partitions | pilots(uint16) | free slots(uint32) | fingerprints | values ]
+template <class Key, class Value, class Hash = std::hash<Key> >
+class PerfectHashMap {
+public:
+    // @brief typedefs
+    typedef Key    key_type;
+    typedef Value  mapped_type;
+    typedef Value  value_type;
+    typedef size_t size_type;
+    typedef const Value* const_iterator;
+
+    // @breif constructor&destructor
+    PerfectHashMap() : _size(0), _partition_count(0), _pilot_count(0), _free_count(0), _fingerprint_bits(0) {
+    }
+    PerfectHashMap(size_type size, size_type partition_count, size_type pilot_count, size_type free_count,
+            uint32_t fingerprint_bits) :
+            _size(size),
+            _partition_count(partition_count),
+            _pilot_count(pilot_count),
+            _free_count(free_count),
+            _fingerprint_bits(fingerprint_bits) {
+    }
+    ~PerfectHashMap() { /* do NOT delete[] */ }
+
+    // @brief debugging
+    std::string layout() const;
+
+    // @brief Capacity
+    bool empty() const { return _size == 0; }
+    size_type size() const { return _size; }
+    size_type partition_count() const { return _partition_count; }
+    uint32_t fingerprint_bits() const { return _fingerprint_bits; }
+    // @brief index memory(partitions, pilots and free slots) in bits per key, fingerprints excluded
+    double bits_per_key() const {
+        return (_size == 0 ? 0 : 8.0 * (fingerprints_offset() - sizeof(*this)) / _size);
+    }
+
+    // @brief Element lookup
+    // @brief value of key, nullptr if key rejected by fingerprint
+    const Value* find(const Key& k) const;
+    size_type count(const Key& k) const { return (find(k) == nullptr ? 0 : 1); }
+    // @brief throws out_of_range if key rejected by fingerprint
+    const Value& at(const Key& k) const {
+        const Value *value = find(k);
+        if (value == nullptr) {
+            throw std::out_of_range("PerfectHashMap::at key NOT found");
+        }
+        return *value;
+    }
+    // @brief index of key in value array, in [0, size) for any key
+    size_type index(const Key& k) const;
+
+    // @brief Iterators over values, in order of index(keys NOT stored)
+    const_iterator begin() const { return values(); }
+    const_iterator end() const { return values() + _size; }
+
+    // @brief layout of arrays following this
+    static size_t Align(size_t size) { return (size + 7) & ~7UL; }
+    size_t pilots_offset() const { return sizeof(*this) + sizeof(PerfectPartition) * _partition_count; }
+    size_t free_offset() const { return pilots_offset() + Align(sizeof(uint16_t) * _pilot_count); }
+    size_t fingerprints_offset() const { return free_offset() + Align(sizeof(uint32_t) * _free_count); }
+    size_t values_offset() const { return fingerprints_offset() + Align(_fingerprint_bits / 8 * _size); }
+    size_t memsize() const { return values_offset() + sizeof(Value) * _size; }
+
+    const PerfectPartition* partitions() const { return (const PerfectPartition*)(this + 1); }
+    const uint16_t* pilots() const { return (const uint16_t*)((const char*)this + pilots_offset()); }
+    const uint32_t* free_slots() const { return (const uint32_t*)((const char*)this + free_offset()); }
+    const char* fingerprints() const { return (const char*)this + fingerprints_offset(); }
+    const Value* values() const { return (const Value*)((const char*)this + values_offset()); }
+
+    bool operator ==(const PerfectHashMap &other) const;
+    bool operator !=(const PerfectHashMap &other) const { return !(*this == other); }
+
+    // @brief hash of key placed by, fingerprint bits 8/16/32 or 0 without fingerprint
+    static uint64_t KeyHash(const Key& k) { return HashMix64(Hash()(k)); }
+    static bool ValidFingerprintBits(uint32_t bits) { return bits == 0 || bits == 8 || bits == 16 || bits == 32; }
+    static uint32_t Fingerprint(const PerfectKeyHash &kh) { return (uint32_t)kh.pos; }
+
+    // @brief pilots of partition of size keys, and index in partition of each key
+    // hashes: distinct hashes of keys; free: TableSize(size) - size slots
+    // retval succ: true fail: false, bucket NOT placed by any pilot (Never throws)
+    static bool BuildPartition(const std::vector<uint64_t> &hashes, std::vector<uint16_t> &pilots,
+            std::vector<uint32_t> &free, std::vector<uint32_t> &indexes);
+
+private:
+    PerfectHashMap(const PerfectHashMap&) = delete;
+    PerfectHashMap(PerfectHashMap&&) = delete;
+    PerfectHashMap& operator =(const PerfectHashMap&) = delete;
+    PerfectHashMap& operator =(PerfectHashMap&&) = delete;
+
+    size_type _index(const PerfectKeyHash &kh) const;
+
+private:
+    size_type _size = 0;
+    size_type _partition_count = 0;
+    size_type _pilot_count = 0;
+    size_type _free_count = 0;
+    uint32_t _fingerprint_bits = 0;
+    uint32_t _reserved = 0;
+};
+
+template <class Key, class Value, class Hash>
+LEVIN_INLINE typename PerfectHashMap<Key, Value, Hash>::size_type
+PerfectHashMap<Key, Value, Hash>::_index(const PerfectKeyHash &kh) const {
+    const PerfectPartition &part = partitions()[FastRange64(kh.hash, _partition_count)];
+    uint64_t bucket = kh.bucket_of(PerfectKeyHash::BucketCount(part.size));
+    uint64_t pos = kh.pos_of(pilots()[part.pilot_begin + bucket], PerfectKeyHash::TableSize(part.size));
+    if (pos >= part.size) {
+        pos = free_slots()[part.free_begin + pos - part.size];
+    }
+    return part.key_begin + pos;
+}
+
+template <class Key, class Value, class Hash>
+typename PerfectHashMap<Key, Value, Hash>::size_type PerfectHashMap<Key, Value, Hash>::index(const Key& k) const {
+    return (_size == 0 ? 0 : _index(PerfectKeyHash(KeyHash(k))));
+}
+
+template <class Key, class Value, class Hash>
+LEVIN_INLINE const Value* PerfectHashMap<Key, Value, Hash>::find(const Key& k) const {
+    if (_size == 0) {
+        return nullptr;
+    }
+    PerfectKeyHash kh(KeyHash(k));
+    size_type idx = _index(kh);
+    uint32_t fp = Fingerprint(kh);
+    switch (_fingerprint_bits) {
+    case 8:
+        if (((const uint8_t*)fingerprints())[idx] != (uint8_t)fp) {
+            return nullptr;
+        }
+        break;
+    case 16:
+        if (((const uint16_t*)fingerprints())[idx] != (uint16_t)fp) {
+            return nullptr;
+        }
+        break;
+    case 32:
+        if (((const uint32_t*)fingerprints())[idx] != fp) {
+            return nullptr;
+        }
+        break;
+    default:
+        break;
+    }
+    return values() + idx;
+}
+
+template <class Key, class Value, class Hash>
+bool PerfectHashMap<Key, Value, Hash>::BuildPartition(const std::vector<uint64_t> &hashes,
+        std::vector<uint16_t> &pilots, std::vector<uint32_t> &free, std::vector<uint32_t> &indexes) {
+    const uint64_t size = hashes.size();
+    const uint64_t bucket_count = PerfectKeyHash::BucketCount(size);
+    const uint64_t table_size = PerfectKeyHash::TableSize(size);
+    // keys grouped by bucket(counting sort)
+    std::vector<PerfectKeyHash> khs;
+    khs.reserve(size);
+    std::vector<uint32_t> bucket_begins(bucket_count + 1, 0);
+    std::vector<uint32_t> buckets(size);
+    for (uint64_t i = 0; i < size; ++i) {
+        khs.push_back(PerfectKeyHash(hashes[i]));
+        ++bucket_begins[khs[i].bucket_of(bucket_count) + 1];
+    }
+    uint32_t max_bucket_size = 0;
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        max_bucket_size = std::max(max_bucket_size, bucket_begins[b + 1]);
+        bucket_begins[b + 1] += bucket_begins[b];
+    }
+    {
+        std::vector<uint32_t> heads(bucket_begins.begin(), bucket_begins.end() - 1);
+        for (uint64_t i = 0; i < size; ++i) {
+            buckets[heads[khs[i].bucket_of(bucket_count)]++] = i;
+        }
+    }
+    // buckets placed by size descending(counting sort)
+    std::vector<uint32_t> size_begins(max_bucket_size + 2, 0);
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        ++size_begins[max_bucket_size - (bucket_begins[b + 1] - bucket_begins[b]) + 1];
+    }
+    for (uint32_t s = 0; s <= max_bucket_size; ++s) {
+        size_begins[s + 1] += size_begins[s];
+    }
+    std::vector<uint32_t> order(bucket_count);
+    for (uint64_t b = 0; b < bucket_count; ++b) {
+        order[size_begins[max_bucket_size - (bucket_begins[b + 1] - bucket_begins[b])]++] = b;
+    }
+    // pilot of bucket: first one placing all its keys to free positions
+    std::vector<uint64_t> taken((table_size + 63) / 64, 0);
+    std::vector<uint64_t> positions(max_bucket_size);
+    std::vector<uint32_t> slots(size);
+    pilots.assign(bucket_count, 0);
+    for (uint64_t b : order) {
+        uint32_t begin = bucket_begins[b];
+        uint32_t len = bucket_begins[b + 1] - begin;
+        if (len == 0) {
+            break;
+        }
+        uint64_t pilot = 0;
+        for (; pilot <= PERFECT_MAX_PILOT; ++pilot) {
+            uint32_t j = 0;
+            for (; j < len; ++j) {
+                uint64_t pos = khs[buckets[begin + j]].pos_of(pilot, table_size);
+                if ((taken[pos >> 6] >> (pos & 63)) & 1) {
+                    break;
+                }
+                if (std::find(positions.begin(), positions.begin() + j, pos) != positions.begin() + j) {
+                    break;
+                }
+                positions[j] = pos;
+            }
+            if (j == len) {
+                break;
+            }
+        }
+        if (pilot > PERFECT_MAX_PILOT) {
+            return false;
+        }
+        pilots[b] = pilot;
+        for (uint32_t j = 0; j < len; ++j) {
+            taken[positions[j] >> 6] |= 1UL << (positions[j] & 63);
+            slots[buckets[begin + j]] = positions[j];
+        }
+    }
+    // taken positions out of keys remapped to free positions in keys, in order
+    free.assign(table_size - size, 0);
+    uint64_t next = 0;
+    for (uint64_t pos = size; pos < table_size; ++pos) {
+        if ((taken[pos >> 6] >> (pos & 63)) & 1) {
+            while ((taken[next >> 6] >> (next & 63)) & 1) {
+                ++next;
+            }
+            free[pos - size] = next++;
+        }
+    }
+    indexes.resize(size);
+    for (uint64_t i = 0; i < size; ++i) {
+        indexes[i] = (slots[i] < size ? slots[i] : free[slots[i] - size]);
+    }
+    return true;
+}
+
+template <class Key, class Value, class Hash>
+bool PerfectHashMap<Key, Value, Hash>::operator ==(const PerfectHashMap &other) const {
+    if (_size != other._size || _partition_count != other._partition_count ||
+            _pilot_count != other._pilot_count || _free_count != other._free_count ||
+            _fingerprint_bits != other._fingerprint_bits) {
+        return false;
+    }
+    return memcmp(this + 1, &other + 1, memsize() - sizeof(*this)) == 0;
+}
+
+template <class Key, class Value, class Hash>
+std::string PerfectHashMap<Key, Value, Hash>::layout() const {
+    std::stringstream ss;
+    ss << "PerfectHashMap this=[" << (void*)this << "]" << std::endl
+       << "[" << (void*)&_size << "]\t\t_size=" << _size << std::endl
+       << "[" << (void*)&_partition_count << "]\t\t_partition_count=" << _partition_count << std::endl
+       << "[" << (void*)&_pilot_count << "]\t\t_pilot_count=" << _pilot_count << std::endl
+       << "[" << (void*)&_free_count << "]\t\t_free_count=" << _free_count << std::endl
+       << "[" << (void*)&_fingerprint_bits << "]\t\t_fingerprint_bits=" << _fingerprint_bits << std::endl
+       << "[" << (void*)values() << "]\t\tvalues, index bits per key=" << bits_per_key();
+    return ss.str();
+}
+
+template <class Key, class Value, class Hash>
+inline size_t container_memsize(const PerfectHashMap<Key, Value, Hash> *object) {
+    return object->memsize();
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_DETAILS_PERFECT_HASHMAP_H
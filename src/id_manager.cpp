@@ -1,6 +1,7 @@
 #include "id_manager.h"
 #include <iostream>
 #include "xsi_shm.hpp"
+#include "shm_catalog.h"
 
 namespace levin {
 
@@ -40,6 +41,23 @@ bool IdManager::DeRegister(const int id) {
     return true;
 }
 
+void IdManager::Refresh(const int id, const std::string &name) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto id_it = _id_map.find(id);
+    if (id_it != _id_map.end()) {
+        _shm_map.erase(id_it->second);
+        _id_map.erase(id_it);
+    }
+    auto shm_it = _shm_map.find(name);
+    if (shm_it != _shm_map.end()) {
+        _id_map.erase(shm_it->second);
+        _shm_map.erase(shm_it);
+    }
+    _id_map.emplace(std::make_pair(id, name));
+    _shm_map.emplace(std::make_pair(name, id));
+    LEVIN_CDEBUG_LOG("Refresh. id=%d, name=%s", id, name.c_str());
+}
+
 bool IdManager::insertWithLock(const int id, const std::string &name) {
     std::lock_guard<std::mutex> guard(_mutex);
     if (_id_map.find(id) != _id_map.end() || _shm_map.find(name) != _shm_map.end()) {
@@ -73,6 +91,28 @@ bool IdManager::GetId(const std::string &name, int &id) const {
 }
 
 bool IdManager::get_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_attach) {
+    ShmCatalog &catalog = ShmCatalog::GetInstance();
+    std::vector<CatalogEntry> entries;
+    if (!catalog.List(entries)) {
+        return scan_all_shmid(shmid_info, no_attach);
+    }
+    shmid_info.clear();
+    for (const auto &entry : entries) {
+        struct shmid_ds shm_segment;
+        // removed out of levin(eg. ipcrm), or marked destroyed and waiting for detach
+        if (::shmctl(entry.shmid, IPC_STAT, &shm_segment) == -1 || (shm_segment.shm_perm.mode & SHM_DEST)) {
+            std::cout << "stale catalog entry, erase. shmid=" << entry.shmid << ", path=" << entry.path << std::endl;
+            catalog.Erase(entry.path, entry.shmid);
+            continue;
+        }
+        if (!no_attach || shm_segment.shm_nattch == 0) {
+            shmid_info.emplace_back(entry.path, entry.shmid, entry.group, entry.appid);
+        }
+    }
+    return true;
+}
+
+bool IdManager::scan_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_attach) {
     static const std::string LEVIN_PATTERN = "levin";
     struct shmid_ds shm_info;
     int max_id = ::shmctl(0, SHM_INFO, &shm_info);
@@ -84,6 +124,10 @@ bool IdManager::get_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_at
             std::cout << "stat shm failed, ignore. id=" << id << std::endl;
             continue;
         }
+        // catalog is NOT a container
+        if (shm_segment.shm_perm.__key == ShmCatalog::CATALOG_KEY) {
+            continue;
+        }
         if (!no_attach || shm_segment.shm_nattch == 0) {
             shmid_vec.emplace_back(shm_id);
         }
@@ -19,6 +19,8 @@ public:
     bool Register(const int id, const std::string &name);
     bool DeRegister(const int id);
     bool GetId(const std::string &name, int &id) const;
+    // @brief register id of name, stale mapping of id or name replaced
+    void Refresh(const int id, const std::string &name);
 
     static IdManager& GetInstance() {
         static IdManager instance;
@@ -26,7 +28,10 @@ public:
     }
 
     // @brief get_all_shmid maybe called before main(). logger by stdout
+    // levin shm listed by catalog, stated without attach; scan all segments if catalog unavailable
     static bool get_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_attach);
+    // @brief scan all segments by SHM_STAT, attach each one to read its meta
+    static bool scan_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_attach);
 
 private:
     // @brief This constructor does nothing more than ensure that instance is init before main()
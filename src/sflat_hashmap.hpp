@@ -0,0 +1,170 @@
+#ifndef LEVIN_SHARED_FLAT_HASHMAP_H
+#define LEVIN_SHARED_FLAT_HASHMAP_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+#include "details/flat_hashmap.hpp"
+#include "shared_base.hpp"
+
+namespace levin {
+
+// @brief immutable open addressing hashmap, slots probed by SIMD over groups of control bytes
+// built by Dump(or Build) and loaded the same as SharedHashMap, lookup touches one group for a hit
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Pred = std::equal_to<Key>,
+          class Mem = levin::SharedMemory,
+          class CheckFunc = levin::IntegrityChecker>
+class SharedFlatHashMap : public SharedBase {
+public:
+    typedef FlatHashMap<Key, Value, Hash, Pred>     container_type;
+    typedef typename container_type::key_type       key_type;
+    typedef typename container_type::mapped_type    mapped_type;
+    typedef typename container_type::value_type     value_type;
+    typedef typename container_type::size_type      size_type;
+    typedef typename container_type::const_iterator iterator;
+    typedef typename container_type::const_iterator const_iterator;
+
+    SharedFlatHashMap(const std::string &name, const std::string group = "default", const int id = 1) :
+            SharedBase(name, group, id, CheckFunc()),
+            _object(nullptr) {
+    }
+
+    virtual int Init() override {
+        return _init<container_type, Mem>(_object);
+    }
+
+    virtual int Load() override {
+        return _load<container_type>(_object);
+    }
+
+    // @brief build container straight into memory region from map, instead of Init&Load of binfile
+    // name is key of memory region(NOT read), region of the same name published before is replaced
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    template <class T,
+              typename = typename std::enable_if<
+                  std::is_same<typename T::key_type, Key>::value &&
+                  std::is_same<typename T::mapped_type, Value>::value>::type>
+    int Build(const T &map);
+
+    virtual bool Export(const std::string &file) override;
+
+    // @brief T is ordered/unordered KV mapper type
+    // which SHOULD has the same Key&Value type with expected SharedFlatHashMap
+    template <class T,
+              typename = typename std::enable_if<
+                  std::is_same<typename T::key_type, Key>::value &&
+                  std::is_same<typename T::mapped_type, Value>::value>::type>
+    static bool Dump(const std::string &file, const T &map);
+    // @brief pairs of duplicated key dropped except the first one
+    static bool Dump(const std::string &file, const std::vector<std::pair<Key, Value> > &vec);
+    // @brief write binfile image of n pairs [first, last) by writer
+    // name: binfile or container name for log
+    template <class Iter>
+    static bool write(const std::string &name, BinWriter &writer, size_type n, Iter first, Iter last);
+
+    bool empty() const { return _object->empty(); }
+    size_t size() const { return _object->size(); }
+    size_t capacity() const { return _object->capacity(); }
+    size_t group_count() const { return _object->group_count(); }
+    double load_factor() const { return _object->load_factor(); }
+    const_iterator find(const Key &key) const { return _object->find(key); }
+    size_t count(const Key &key) const { return _object->count(key); }
+    const_iterator begin() const { return _object->begin(); }
+    const_iterator end() const { return _object->end(); }
+    const_iterator cbegin() const { return _object->cbegin(); }
+    const_iterator cend() const { return _object->cend(); }
+    // @brief mybe THROW
+    // Levin flat hashmap will throw out_of_range if key does not exist, just as at
+    const Value& operator[](const Key &key) const { return _object->at(key); }
+    const Value& at(const Key &key) const { return _object->at(key); }
+
+    std::string layout() const;
+
+private:
+    container_type *_object = nullptr;
+};
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+template <class T, typename>
+int SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::Build(const T &map) {
+    return _build<container_type, Mem>(_object, container_type::Memsize(map.size()),
+            [this, &map](BinWriter &writer) {
+        return write(_info->_name, writer, map.size(), map.begin(), map.end());
+    });
+}
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+bool SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::Export(const std::string &file) {
+    return _bin2file(file, container_memsize(_object), _object);
+}
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+template <class Iter>
+bool SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::write(
+        const std::string &name, BinWriter &writer, size_type n, Iter first, Iter last) {
+    // container built in an image then written at once, slots placed by probing all over the table
+    std::vector<char> image(container_type::Memsize(n), 0);
+    container_type::Build(image.data(), n, first, last);
+    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, groups=%ld",
+            name.c_str(), ((container_type*)image.data())->size(), ((container_type*)image.data())->group_count());
+    // write file header: used memory size(meta size + container size)/container type hash
+    size_t type_hash = typeid(container_type).hash_code();
+    SharedFileHeader header = {image.size(), type_hash, makeFlags(SharedBase::SC_VERSION)};
+    if (!writer.write(&header, sizeof(header), 0) ||
+            !writer.write(image.data(), image.size(), sizeof(header))) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+template <class T, typename>
+bool SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::Dump(const std::string &file, const T &map) {
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool ret = write(file, writer, map.size(), map.begin(), map.end());
+    return (close(fd) == 0) && ret;
+}
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+bool SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::Dump(
+        const std::string &file, const std::vector<std::pair<Key, Value> > &vec) {
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool ret = write(file, writer, vec.size(), vec.begin(), vec.end());
+    return (close(fd) == 0) && ret;
+}
+
+template <class Key, class Value, class Hash, class Pred, class Mem, class CheckFunc>
+std::string SharedFlatHashMap<Key, Value, Hash, Pred, Mem, CheckFunc>::layout() const {
+    std::stringstream ss;
+    ss << "SharedFlatHashMap this=[" << (void*)this << "]";
+    if (_info->_meta != nullptr) {
+        ss << std::endl << *_info->_meta;
+    }
+    if (_info->_header != nullptr) {
+        ss << std::endl << *_info->_header;
+    }
+    if (_object != nullptr) {
+        ss << std::endl << _object->layout();
+    }
+    return ss.str();
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_SHARED_FLAT_HASHMAP_H
@@ -1,10 +1,21 @@
 #ifndef LEVIN_SHARED_BASE_H
 #define LEVIN_SHARED_BASE_H
 
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <functional>
 #include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
 #include "shared_utils.h"
 #include "shared_allocator.h"
 #include "shared_memory.hpp"
+#include "container_options.h"
+#include "file_loader.h"
+#include "bin_writer.h"
+#include "check_file.h"
+#include "warmup.h"
 
 namespace levin {
 
@@ -13,13 +24,24 @@ struct ContainerInfo {
     std::string _group;
     int _appid;
     CheckFunctor _checkfunc;    // shm region check func
+    ContainerOptions _options;
     boost::scoped_ptr<levin::MemoryBase> _mem;
     boost::scoped_ptr<levin::SharedAllocator> _alloc;
     SharedMeta *_meta;          // which maybe located at shm region, use raw pointer
     SharedFileHeader *_header;  // which maybe located at shm region, use raw pointer
     bool _is_exist = false;
+    size_t _resume_offset = 0;  // binfile offset partial load resumed from, 0 means full load
+    boost::scoped_ptr<Md5Digest> _digest;   // digest of binfile fed while loading, if load_md5 specified
+    boost::scoped_ptr<boost::thread> _warmup_thread;
+    boost::atomic<bool> _warmup_stop;
+    boost::atomic<bool> _is_warm;
+    boost::scoped_ptr<boost::thread> _verify_thread;
+    boost::atomic<bool> _is_verified;
+    boost::atomic<bool> _is_corrupted;
+    std::function<void()> _on_corrupt;
 
-    ContainerInfo() : _name(""), _appid(0), _meta(nullptr), _header(nullptr), _is_exist(false) {
+    ContainerInfo() : _name(""), _appid(0), _meta(nullptr), _header(nullptr), _is_exist(false),
+            _warmup_stop(false), _is_warm(false), _is_verified(false), _is_corrupted(false) {
     }
     ContainerInfo(const std::string &name, const std::string &group, const int id, CheckFunctor fn) :
             _name(name),
@@ -28,7 +50,11 @@ struct ContainerInfo {
             _checkfunc(fn),
             _meta(nullptr),
             _header(nullptr),
-            _is_exist(false) {
+            _is_exist(false),
+            _warmup_stop(false),
+            _is_warm(false),
+            _is_verified(false),
+            _is_corrupted(false) {
     }
 };
 
@@ -38,7 +64,7 @@ public:
     // @brief shared container version for workaround binary-incompatible implement upgrade
     // why not treated version specialized per container type
     // cause there are dependency relationship between them
-    static const uint8_t SC_VERSION = 2;
+    static const uint8_t SC_VERSION = 3;
 
     SharedBase(
             const std::string &name,
@@ -48,6 +74,8 @@ public:
             _info(new ContainerInfo(name, group, appid, check)) {
     }
     virtual ~SharedBase() {
+        _stop_warmup();
+        _stop_verify();
     }
 
     virtual int Init() = 0;
@@ -58,9 +86,43 @@ public:
         return _info->_is_exist;
     }
 
+    // @brief options take effect on next Init/Load
+    void SetOptions(const ContainerOptions &options) {
+        _info->_options = options;
+    }
+    const ContainerOptions& GetOptions() const {
+        return _info->_options;
+    }
+
+    // @brief warm up memory region by options, in background if options.warmup_async
+    // call after Init/Load succ
+    int Warmup();
+    bool IsWarm() const {
+        return _info->_is_warm;
+    }
+
+    // @brief region checksum verified, by Load or by background verifier if options.verify_lazy
+    bool IsVerified() const {
+        return _info->_is_verified;
+    }
+    // @brief region found corrupted by background verifier and quarantined, container should be reloaded
+    bool IsCorrupted() const {
+        return _info->_is_corrupted;
+    }
+    // @brief called by background verifier(in its thread) after corrupted region quarantined
+    // set before Init, callback should NOT destroy this container in place
+    void SetCorruptCallback(const std::function<void()> &callback) {
+        _info->_on_corrupt = callback;
+    }
+
+    // @brief remove memory region, or only detach it if read only
     void Destroy() {
+        _stop_warmup();
+        _stop_verify();
         _info->_meta = nullptr;
-        if (_info->_mem.get() != nullptr) {
+        if (_info->_options.read_only) {
+            _info->_mem.reset();
+        } else if (_info->_mem.get() != nullptr) {
             _info->_mem->remove();
         }
     }
@@ -69,18 +131,83 @@ protected:
     template <typename Container, typename Mem = levin::SharedMemory>
     int _init(Container *&ptr);
 
+    // @brief is_lazy: structural checks only(type hash, version, bounds), region checksum skipped
     template <typename Container>
-    bool _check(const Container *ptr, bool is_upd = false);
+    bool _check(const Container *ptr, bool is_upd = false, bool is_lazy = false);
 
     template <typename Container>
     int _load(Container *&ptr);
 
+    // @brief write binfile image(file header and container) of container_size by writer
+    // retval succ: true fail: false (Never throws)
+    typedef std::function<bool(BinWriter &writer)> BuildFunc;
+    // @brief build container straight into a new memory region by build_func, without binfile
+    // region of the same name published before is unlinked, kept by its attached readers until detached
+    template <typename Container, typename Mem = levin::SharedMemory>
+    int _build(Container *&ptr, const size_t container_size, const BuildFunc &build_func);
+
     template <typename Container>
     bool _file2bin(const std::string &file, Container *&ptr);
 
+    template <typename Container>
+    bool _file2bin_parallel(const std::string &file, Container *&ptr);
+
+    template <typename Container>
+    bool _file2bin_direct(const std::string &file, Container *&ptr);
+
+    template <typename Container>
+    bool _validate(const std::string &file, Container *&ptr);
+
+    template <typename Container>
+    bool _resumable() const;
+    bool _is_partial() const {
+        return VersionOfFlags(_info->_meta->flags) == SC_VERSION && _info->_meta->state != LoadState::Ready;
+    }
+    template <typename Container>
+    void _begin_load(const Container *ptr);
+    template <typename Container>
+    void _commit_loaded(const Container *ptr, uint64_t begin, uint64_t end);
+    bool _verify_digest();
+    size_t _resume_skip() const {
+        return (_info->_resume_offset > sizeof(SharedFileHeader) ?
+                _info->_resume_offset - sizeof(SharedFileHeader) : 0);
+    }
+    // @brief reducer of hash into bucket_count buckets by reduction recorded in file header
+    // retval succ: SC_RET_OK fail: SC_RET_LOAD_FAIL, reduction unknown (Never throws)
+    int _bucket_reducer(size_t bucket_count, BucketReducer &reducer) const {
+        BucketReduce reduce = ReduceOfFlags(_info->_header->flags);
+        if (reduce != BucketReduce::Mod && reduce != BucketReduce::Pow2) {
+            LEVIN_CWARNING_LOG("unknown bucket reduction. name=%s, flags=%lu",
+                    _info->_name.c_str(), _info->_header->flags);
+            return SC_RET_LOAD_FAIL;
+        }
+        reducer = BucketReducer(reduce, std::max<size_t>(bucket_count, 1));
+        return SC_RET_OK;
+    }
+    // @brief layout of bucket records recorded in file header
+    // retval succ: SC_RET_OK fail: SC_RET_LOAD_FAIL, layout unknown (Never throws)
+    int _bucket_layout(BucketLayout &layout) const {
+        layout = LayoutOfFlags(_info->_header->flags);
+        if (layout != BucketLayout::Pair && layout != BucketLayout::Split) {
+            LEVIN_CWARNING_LOG("unknown bucket layout. name=%s, flags=%lu",
+                    _info->_name.c_str(), _info->_header->flags);
+            return SC_RET_LOAD_FAIL;
+        }
+        return SC_RET_OK;
+    }
+
     template <typename Container>
     bool _bin2file(const std::string &file, const size_t container_size, const Container *ptr);
 
+    void _warmup();
+    void _stop_warmup();
+    template <typename Container>
+    void _verify(const Container *ptr);
+    void _stop_verify();
+    size_t _segment_num() const {
+        return (_info->_mem.get() == nullptr ? 1 : _info->_mem->segment_num());
+    }
+
     static size_t HeaderSize() {
         return SharedAllocator::Allocsize(sizeof(SharedFileHeader));
     }
@@ -92,13 +219,82 @@ protected:
     boost::scoped_ptr<ContainerInfo> _info;
 };
 
+inline int SharedBase::Warmup() {
+    if (_info->_mem.get() == nullptr || _info->_meta == nullptr) {
+        LEVIN_CWARNING_LOG("warmup before init&load. name=%s", _info->_name.c_str());
+        return SC_RET_ERR_STATUS;
+    }
+    _stop_warmup();
+    if (!_info->_options.warmup_async) {
+        _warmup();
+        return SC_RET_OK;
+    }
+    try {
+        _info->_warmup_thread.reset(new boost::thread(boost::bind(&SharedBase::_warmup, this)));
+    } catch (std::exception &e) {
+        LEVIN_CWARNING_LOG("start warmup thread fail, warmup in place. what=%s, name=%s",
+                e.what(), _info->_name.c_str());
+        _warmup();
+    }
+    return SC_RET_OK;
+}
+
+inline void SharedBase::_warmup() {
+    _info->_is_warm = WarmupRegion(_info->_name, _info->_mem->get_address(), _info->_mem->get_size(),
+            _info->_options, &_info->_warmup_stop);
+}
+
+inline void SharedBase::_stop_warmup() {
+    if (_info->_warmup_thread.get() != nullptr) {
+        _info->_warmup_stop = true;
+        _info->_warmup_thread->join();
+        _info->_warmup_thread.reset();
+        _info->_warmup_stop = false;
+    }
+}
+
+// @brief background verifier: region checksum walked at lowest priority
+// corrupted region quarantined: unlinked from the system while still mapped by readers of this process
+template <typename Container>
+void SharedBase::_verify(const Container *ptr) {
+    // nice value is per thread on linux, inherited by checksum threads spawned from here
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+    if (_check(ptr)) {
+        _info->_is_verified = true;
+        LEVIN_CINFO_LOG("shm verified in background. name=%s", _info->_name.c_str());
+        return;
+    }
+    LEVIN_CWARNING_LOG("shm verified corrupted in background, quarantine. name=%s\n%s",
+            _info->_name.c_str(), _info->_meta->layout().c_str());
+    _info->_mem->unlink();
+    _info->_is_corrupted = true;
+    if (_info->_on_corrupt) {
+        _info->_on_corrupt();
+    }
+}
+
+inline void SharedBase::_stop_verify() {
+    // region checksum NOT interruptible, wait for it
+    if (_info->_verify_thread.get() != nullptr &&
+            _info->_verify_thread->get_id() != boost::this_thread::get_id()) {
+        _info->_verify_thread->join();
+        _info->_verify_thread.reset();
+    }
+}
+
 template <typename Container, typename Mem>
 int SharedBase::_init(Container *&ptr) {
+    _stop_verify();
+    _info->_resume_offset = 0;
+    _info->_is_verified = false;
+    _info->_is_corrupted = false;
     _info->_mem.reset(new Mem(_info->_name, _info->_appid));
     if (_info->_mem.get() == nullptr) {
         LEVIN_CWARNING_LOG("new SharedMemory failed. name=%s", _info->_name.c_str());
         return SC_RET_OOM;
     }
+    _info->_mem->set_options(_info->_options);
+    _info->_mem->set_group(_info->_group);
     int ret = _info->_mem->init(MetaSize() + HeaderSize());
     if (ret != SC_RET_OK) {
         _info->_mem.reset();
@@ -112,24 +308,68 @@ int SharedBase::_init(Container *&ptr) {
         return SC_RET_OOM;
     }
     try {
+        if (_info->_mem->is_file_mapped()) {
+            // binfile mapped in place, only meta need to be constructed
+            _info->_meta = _info->_alloc->template Construct<SharedMeta>(
+                    _info->_mem->name().c_str(), typeid(Container).name(), _info->_group.c_str(), _info->_appid,
+                    typeid(Container).hash_code(), makeFlags(SC_VERSION));
+            _info->_header = _info->_alloc->template Address<SharedFileHeader>();
+            ptr = _info->_alloc->template Address<Container>();
+            return SC_RET_OK;
+        }
         if (_info->_mem->is_exist()) {
             _info->_meta = _info->_alloc->template Address<SharedMeta>();
             _info->_header = _info->_alloc->template Address<SharedFileHeader>();
             ptr = _info->_alloc->template Address<Container>();
-            if (_check(ptr)) {
+            if (_is_partial()) {
+                // loader died in between, recognized by load state without checksum
+                LEVIN_CWARNING_LOG("shm partially loaded, recycle. name=%s, loaded_offset=%lu",
+                        _info->_name.c_str(), _info->_meta->loaded_offset);
+            } else if (_check(ptr, false, _info->_options.verify_lazy)) {
                 _info->_is_exist = true;
-                LEVIN_CINFO_LOG("shm already exist. name=%s, info=%s",
-                        _info->_name.c_str(), _info->_mem->info().c_str());
+                _info->_mem->publish(_info->_meta->flags);
+                LEVIN_CINFO_LOG("shm already exist. name=%s, verify_lazy=%d, info=%s",
+                        _info->_name.c_str(), _info->_options.verify_lazy, _info->_mem->info().c_str());
+                if (!_info->_options.verify_lazy) {
+                    _info->_is_verified = true;
+                    return SC_RET_OK;
+                }
+                try {
+                    _info->_verify_thread.reset(
+                            new boost::thread(boost::bind(&SharedBase::_verify<Container>, this, ptr)));
+                } catch (std::exception &e) {
+                    LEVIN_CWARNING_LOG("start verify thread fail, verify in place. what=%s, name=%s",
+                            e.what(), _info->_name.c_str());
+                    _verify(ptr);
+                }
+                return SC_RET_OK;
+            } else {
+                LEVIN_CWARNING_LOG("shm already exist but check fail. name=%s\n%s",
+                        _info->_name.c_str(), _info->_meta->layout().c_str());
+            }
+            if (_info->_options.read_only) {
+                // reader never rebuilds
+                ptr = nullptr;
+                Destroy();
+                return SC_RET_CHECK_FAIL;
+            }
+            // chunks loaded from the same binfile kept, load continues after them
+            if (_resumable<Container>()) {
+                _info->_resume_offset = _info->_meta->loaded_offset;
+                LEVIN_CINFO_LOG("resume partial load. name=%s, offset=%lu", _info->_name.c_str(), _info->_resume_offset);
                 return SC_RET_OK;
             }
-            LEVIN_CWARNING_LOG("shm already exist but check fail. name=%s\n%s",
-                    _info->_name.c_str(), _info->_meta->layout().c_str());
+        } else if (_info->_options.read_only) {
+            LEVIN_CWARNING_LOG("shm no exist, read only NOT load. name=%s", _info->_name.c_str());
+            ptr = nullptr;
+            Destroy();
+            return SC_RET_SHM_NOEXIST;
         }
         // shm no exist create shm, construct and load binfile
         // shm exist but checked fail, reconstruct and reload
         _info->_alloc->Reset();
         _info->_meta = _info->_alloc->template Construct<SharedMeta>(
-                _info->_name.c_str(), typeid(Container).name(), _info->_group.c_str(), _info->_appid,
+                _info->_mem->name().c_str(), typeid(Container).name(), _info->_group.c_str(), _info->_appid,
                 typeid(Container).hash_code(), makeFlags(SC_VERSION));
         _info->_header = _info->_alloc->template Construct<SharedFileHeader>();
         ptr = _info->_alloc->template Construct<Container>();
@@ -146,7 +386,7 @@ int SharedBase::_init(Container *&ptr) {
 }
 
 template <typename Container>
-bool SharedBase::_check(const Container *ptr, bool is_upd) {
+bool SharedBase::_check(const Container *ptr, bool is_upd, bool is_lazy) {
     if (typeid(Container).hash_code() != _info->_meta->hashcode) {
         LEVIN_CWARNING_LOG("checked summary hash failed. %s NOT matches %s",
                 demangle(typeid(Container).name()).c_str(), _info->_meta->summary);
@@ -158,13 +398,18 @@ bool SharedBase::_check(const Container *ptr, bool is_upd) {
         return false;
     }
 
+    // segmented memory: every segment still attached in place, region contiguous
+    if (_info->_mem.get() != nullptr && !_info->_mem->verify()) {
+        LEVIN_CWARNING_LOG("checked memory segments failed.");
+        return false;
+    }
     SharedChecksumInfo info((void*)_info->_header, container_memsize(ptr) + HeaderSize());
     if (_info->_alloc->OutOfRange(
                 (void*)((size_t)info.area - MetaSize()), info.length + MetaSize())) {
         LEVIN_CWARNING_LOG("checked region out of range.");
         return false;
     }
-    return _info->_checkfunc(info, _info->_meta, is_upd);
+    return (is_lazy || _info->_checkfunc(info, _info->_meta, is_upd));
 }
 
 template <typename Container>
@@ -173,12 +418,26 @@ int SharedBase::_load(Container *&ptr) {
         LEVIN_CDEBUG_LOG("no need load, use exist shm directly. name=%s", _info->_name.c_str());
         return SC_RET_OK;
     }
-    if (_info->_header == nullptr || ptr == nullptr || !_file2bin(_info->_name, ptr)) {
+    // file mapped memory: container already in place, validate only
+    bool is_mapped = _info->_mem->is_file_mapped();
+    if (!is_mapped && _info->_meta != nullptr) {
+        _begin_load(ptr);
+    }
+    if (_info->_header == nullptr || ptr == nullptr ||
+            !(is_mapped ? _validate(_info->_name, ptr) : _file2bin(_info->_name, ptr))) {
         LEVIN_CWARNING_LOG("load failed, remove shm. name=%s", _info->_name.c_str());
         ptr = nullptr;
         Destroy();
         return SC_RET_LOAD_FAIL;
     }
+    // binfile md5 verified by digest fed while loading, or by a read of mapped binfile
+    if (!_info->_options.load_md5.empty() &&
+            !(is_mapped ? CheckFileMD5(_info->_name, _info->_options.load_md5) : _verify_digest())) {
+        LEVIN_CWARNING_LOG("binfile md5 check fail, remove shm. name=%s", _info->_name.c_str());
+        ptr = nullptr;
+        Destroy();
+        return SC_RET_FILE_CHECK;
+    }
     // double check: this container out of shm range; overlapped by other container
     if (!_check(ptr, true)) {
         LEVIN_CWARNING_LOG("load end but checked fail, remove shm. name=%s\n%s",
@@ -187,24 +446,222 @@ int SharedBase::_load(Container *&ptr) {
         Destroy();
         return SC_RET_CHECK_FAIL;
     }
+    // commit marker: Ready published after container loaded and checksummed
+    LoadState state = LoadState::Ready;
+    __atomic_store(&_info->_meta->state, &state, __ATOMIC_RELEASE);
+    _info->_is_verified = true;
+    _info->_mem->publish(_info->_meta->flags);
     LEVIN_CINFO_LOG("file load succ. name=%s, info=%s",
             _info->_name.c_str(), _info->_mem->info().c_str());
     return SC_RET_OK;
 }
 
+template <typename Container, typename Mem>
+int SharedBase::_build(Container *&ptr, const size_t container_size, const BuildFunc &build_func) {
+    _stop_warmup();
+    _stop_verify();
+    _info->_resume_offset = 0;
+    _info->_is_exist = false;
+    _info->_is_verified = false;
+    _info->_is_corrupted = false;
+    _info->_meta = nullptr;
+    ptr = nullptr;
+    if (_info->_options.read_only) {
+        LEVIN_CWARNING_LOG("read only container NOT buildable. name=%s", _info->_name.c_str());
+        return SC_RET_ERR_STATUS;
+    }
+    // at most twice: region of the same name found and unlinked at first
+    for (int i = 0; i < 2; ++i) {
+        _info->_mem.reset(new Mem(_info->_name, _info->_appid, container_size));
+        _info->_mem->set_options(_info->_options);
+        _info->_mem->set_group(_info->_group);
+        _info->_mem->set_built();
+        int ret = _info->_mem->init(MetaSize() + HeaderSize());
+        if (ret != SC_RET_OK) {
+            _info->_mem.reset();
+            LEVIN_CWARNING_LOG("memory init for build failed. name=%s, ret=%d", _info->_name.c_str(), ret);
+            return ret;
+        }
+        if (_info->_mem->is_file_mapped()) {
+            _info->_mem.reset();
+            LEVIN_CWARNING_LOG("file mapped memory NOT buildable. name=%s", _info->_name.c_str());
+            return SC_RET_ERR_STATUS;
+        }
+        if (!_info->_mem->is_exist()) {
+            break;
+        }
+        LEVIN_CINFO_LOG("region of the same name exists, replaced by build. name=%s, info=%s",
+                _info->_name.c_str(), _info->_mem->info().c_str());
+        _info->_mem->unlink();
+        _info->_mem.reset();
+    }
+    if (_info->_mem.get() == nullptr) {
+        LEVIN_CWARNING_LOG("region of the same name NOT replaced. name=%s", _info->_name.c_str());
+        return SC_RET_SHM_KEY_CONFLICT;
+    }
+    _info->_alloc.reset(
+            new levin::SharedAllocator(_info->_mem->get_address(), _info->_mem->get_size()));
+    try {
+        _info->_meta = _info->_alloc->template Construct<SharedMeta>(
+                _info->_mem->name().c_str(), typeid(Container).name(), _info->_group.c_str(), _info->_appid,
+                typeid(Container).hash_code(), makeFlags(SC_VERSION));
+        _info->_header = _info->_alloc->template Construct<SharedFileHeader>();
+        ptr = _info->_alloc->template Address<Container>();
+    } catch (std::exception &e) {
+        LEVIN_CWARNING_LOG("alloc failed, remove shm. what=%s, name=%s",
+                e.what(), _info->_name.c_str());
+        ptr = nullptr;
+        Destroy();
+        return SC_RET_ALLOC_FAIL;
+    }
+    // no binfile to resume from, region published Ready after built and checksummed
+    LoadState state = LoadState::Loading;
+    __atomic_store(&_info->_meta->state, &state, __ATOMIC_RELEASE);
+    RegionBinWriter writer(_info->_header, ptr, container_size);
+    if (!build_func(writer) || _info->_header->container_size != container_size ||
+            !_validate(_info->_name, ptr)) {
+        LEVIN_CWARNING_LOG("build failed, remove shm. name=%s", _info->_name.c_str());
+        ptr = nullptr;
+        Destroy();
+        return SC_RET_LOAD_FAIL;
+    }
+    _commit_loaded(ptr, 0, sizeof(SharedFileHeader) + container_size);
+    if (!_check(ptr, true)) {
+        LEVIN_CWARNING_LOG("build end but checked fail, remove shm. name=%s\n%s",
+                _info->_name.c_str(), _info->_meta->layout().c_str());
+        ptr = nullptr;
+        Destroy();
+        return SC_RET_CHECK_FAIL;
+    }
+    state = LoadState::Ready;
+    __atomic_store(&_info->_meta->state, &state, __ATOMIC_RELEASE);
+    _info->_is_verified = true;
+    _info->_mem->publish(_info->_meta->flags);
+    LEVIN_CINFO_LOG("build succ. name=%s, info=%s", _info->_name.c_str(), _info->_mem->info().c_str());
+    return SC_RET_OK;
+}
+
 template <typename Container>
 bool SharedBase::_file2bin(const std::string &file, Container *&ptr) {
+    if (_info->_options.load_direct) {
+        return _file2bin_direct(file, ptr);
+    }
+    if (_info->_options.load_threads > 1 || _segment_num() > 1) {
+        return _file2bin_parallel(file, ptr);
+    }
     std::ifstream fin(file, std::ios::in | std::ios::binary);
     if (!fin.is_open()) {
         LEVIN_CWARNING_LOG("open file for read fail. file=%s", file.c_str());
         return false;
     }
-    // read file header: used memory size/container type hashcode
-    fin.read((char*)_info->_header, sizeof(SharedFileHeader));
-    if (!fin) {
+    // read file header: used memory size/container type hashcode, already in place if resumed
+    if (_info->_resume_offset == 0) {
+        fin.read((char*)_info->_header, sizeof(SharedFileHeader));
+        if (!fin) {
+            LEVIN_CWARNING_LOG("read file fail. file=%s", file.c_str());
+            return false;
+        }
+        _commit_loaded(ptr, 0, sizeof(SharedFileHeader));
+    }
+    if (!_validate(file, ptr)) {
+        return false;
+    }
+    // read container bin by chunks, loaded offset committed after each chunk
+    size_t container_size = _info->_header->container_size;
+    size_t chunk_size = (_info->_options.load_chunk_size == 0 ? container_size : _info->_options.load_chunk_size);
+    size_t pos = std::min(_resume_skip(), container_size);
+    fin.seekg(sizeof(SharedFileHeader) + pos);
+    while (pos < container_size) {
+        size_t len = std::min(chunk_size, container_size - pos);
+        fin.read((char*)ptr + pos, len);
+        if (!fin) {
+            LEVIN_CWARNING_LOG("read file fail. file=%s", file.c_str());
+            return false;
+        }
+        _commit_loaded(ptr, sizeof(SharedFileHeader) + pos, sizeof(SharedFileHeader) + pos + len);
+        pos += len;
+    }
+    fin.close();
+    LEVIN_CDEBUG_LOG("file2bin file=%s, T=%s, container size=%ld",
+            file.c_str(), typeid(Container).name(), container_size);
+    return true;
+}
+
+template <typename Container>
+bool SharedBase::_file2bin_parallel(const std::string &file, Container *&ptr) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for read fail. file=%s", file.c_str());
+        return false;
+    }
+    // read file header: used memory size/container type hashcode, already in place if resumed
+    if (_info->_resume_offset == 0) {
+        if (!PreadFull(fd, _info->_header, sizeof(SharedFileHeader), 0)) {
+            close(fd);
+            return false;
+        }
+        _commit_loaded(ptr, 0, sizeof(SharedFileHeader));
+    }
+    if (!_validate(file, ptr)) {
+        close(fd);
+        return false;
+    }
+    // read container bin by chunks, from a pool of threads
+    // segmented memory filled by one thread per segment at least
+    // loaded offset committed over the finished prefix of chunks
+    size_t container_size = _info->_header->container_size;
+    size_t skip = std::min(_resume_skip(), container_size);
+    uint32_t thread_num = std::max<uint32_t>(_info->_options.load_threads, _segment_num());
+    bool succ = ParallelPread(file, fd, (char*)ptr + skip, container_size - skip, sizeof(SharedFileHeader) + skip,
+            _info->_options.load_chunk_size, thread_num, [this, ptr](uint64_t begin, uint64_t end) {
+                _commit_loaded(ptr, begin, end);
+            });
+    close(fd);
+    if (!succ) {
+        LEVIN_CWARNING_LOG("read file fail. file=%s", file.c_str());
+        return false;
+    }
+    LEVIN_CDEBUG_LOG("file2bin file=%s, T=%s, container size=%ld, threads=%u, chunk size=%lu",
+            file.c_str(), typeid(Container).name(), container_size,
+            thread_num, _info->_options.load_chunk_size);
+    return true;
+}
+
+template <typename Container>
+bool SharedBase::_file2bin_direct(const std::string &file, Container *&ptr) {
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for read fail. file=%s", file.c_str());
+        return false;
+    }
+    // read file header: used memory size/container type hashcode, already in place if resumed
+    bool succ = (_info->_resume_offset > 0 || PreadFull(fd, _info->_header, sizeof(SharedFileHeader), 0));
+    close(fd);
+    if (succ && _info->_resume_offset == 0) {
+        _commit_loaded(ptr, 0, sizeof(SharedFileHeader));
+    }
+    if (!succ || !_validate(file, ptr)) {
+        return false;
+    }
+    // read container bin bypass page cache
+    // io completes out of order, loaded offset committed only when all done
+    const ContainerOptions &options = _info->_options;
+    size_t container_size = _info->_header->container_size;
+    size_t skip = std::min(_resume_skip(), container_size);
+    if (!DirectPread(file, (char*)ptr + skip, container_size - skip, sizeof(SharedFileHeader) + skip,
+                options.load_io_size, options.load_queue_depth, options.load_threads)) {
         LEVIN_CWARNING_LOG("read file fail. file=%s", file.c_str());
         return false;
     }
+    _commit_loaded(ptr, sizeof(SharedFileHeader) + skip, sizeof(SharedFileHeader) + container_size);
+    LEVIN_CDEBUG_LOG("file2bin file=%s, T=%s, container size=%ld, direct io size=%lu, queue depth=%u",
+            file.c_str(), typeid(Container).name(), container_size,
+            options.load_io_size, options.load_queue_depth);
+    return true;
+}
+
+template <typename Container>
+bool SharedBase::_validate(const std::string &file, Container *&ptr) {
     // validate expected container type hashcode
     if (typeid(Container).hash_code() != _info->_header->type_hash) {
         LEVIN_CWARNING_LOG("validate typeid hash in file failed. file=%s, T=%s",
@@ -223,15 +680,89 @@ bool SharedBase::_file2bin(const std::string &file, Container *&ptr) {
         LEVIN_CWARNING_LOG("file bin maybe out of region, read file fail. file=%s", file.c_str());
         return false;
     }
-    // read container bin
-    fin.read((char*)ptr, container_size);
-    if (!fin) {
-        LEVIN_CWARNING_LOG("read file fail. file=%s", file.c_str());
+    return true;
+}
+
+// @brief partially loaded region resumable: loading the same container from the same unchanged binfile
+template <typename Container>
+bool SharedBase::_resumable() const {
+    const SharedMeta *meta = _info->_meta;
+    struct stat st;
+    if (meta->state != LoadState::Loading || typeid(Container).hash_code() != meta->hashcode ||
+            _info->_name.compare(meta->path) != 0 || meta->loaded_offset <= sizeof(SharedFileHeader) ||
+            stat(_info->_name.c_str(), &st) != 0) {
         return false;
     }
-    fin.close();
-    LEVIN_CDEBUG_LOG("file2bin file=%s, T=%s, container size=%ld",
-            file.c_str(), typeid(Container).name(), container_size);
+    int64_t mtime = st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec;
+    return meta->file_size == (uint64_t)st.st_size && meta->file_mtime == mtime &&
+            meta->loaded_offset <= meta->file_size;
+}
+
+// @brief region marked Loading before binfile read, with identity of binfile for resume
+template <typename Container>
+void SharedBase::_begin_load(const Container *ptr) {
+    SharedMeta *meta = _info->_meta;
+    if (_info->_resume_offset == 0) {
+        struct stat st;
+        bool is_stat = (stat(_info->_name.c_str(), &st) == 0);
+        meta->loaded_offset = 0;
+        meta->file_size = (is_stat ? st.st_size : 0);
+        meta->file_mtime = (is_stat ? st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec : 0);
+    }
+    ++meta->generation;
+    LoadState state = LoadState::Loading;
+    __atomic_store(&meta->state, &state, __ATOMIC_RELEASE);
+    _info->_digest.reset(_info->_options.load_md5.empty() ? nullptr : new Md5Digest);
+    // prefix loaded before resumed: digest fed from memory
+    if (_info->_resume_offset > 0) {
+        _commit_loaded(ptr, 0, _info->_resume_offset);
+    }
+}
+
+// @brief binfile range [begin, end) loaded in place, committed in file order
+// resume offset advanced, and range fed into digest from memory
+template <typename Container>
+void SharedBase::_commit_loaded(const Container *ptr, uint64_t begin, uint64_t end) {
+    if (_info->_digest.get() != nullptr) {
+        // file header and container are NOT adjacent in memory
+        uint64_t pos = begin;
+        if (pos < sizeof(SharedFileHeader)) {
+            uint64_t header_end = std::min<uint64_t>(end, sizeof(SharedFileHeader));
+            _info->_digest->Update((const char*)_info->_header + pos, header_end - pos);
+            pos = header_end;
+        }
+        if (pos < end) {
+            _info->_digest->Update((const char*)ptr + (pos - sizeof(SharedFileHeader)), end - pos);
+        }
+    }
+    if (_info->_meta != nullptr) {
+        __atomic_store_n(&_info->_meta->loaded_offset, end, __ATOMIC_RELEASE);
+    }
+}
+
+// @brief digest of loaded binfile matches load_md5, bytes beyond container(if any) read from binfile
+inline bool SharedBase::_verify_digest() {
+    if (_info->_digest.get() == nullptr) {
+        return false;
+    }
+    size_t loaded_size = sizeof(SharedFileHeader) + _info->_header->container_size;
+    if (!_info->_digest->UpdateFromFile(_info->_name, loaded_size)) {
+        return false;
+    }
+    std::string md5 = _info->_digest->HexDigest();
+    _info->_digest.reset();
+    if (strncasecmp(md5.c_str(), _info->_options.load_md5.c_str(), md5.size() + 1) != 0) {
+        LEVIN_CWARNING_LOG("md5 unmatch, file=%s, expected=%s, calculated=%s",
+                _info->_name.c_str(), _info->_options.load_md5.c_str(), md5.c_str());
+        return false;
+    }
+    LEVIN_CINFO_LOG("check file md5 in load success, file=%s", _info->_name.c_str());
+    // binfile unchanged since load began: later verification of the same file skipped
+    FileIdentity identity;
+    if (GetFileIdentity(_info->_name, identity) && identity.size == _info->_meta->file_size &&
+            identity.mtime == _info->_meta->file_mtime) {
+        DigestCache::GetInstance().SetVerified(_info->_name, md5, identity);
+    }
     return true;
 }
 
@@ -10,6 +10,8 @@ std::map<std::string, SharedContainerManager::auth_func_pair> SharedContainerMan
 std::set<std::string> SharedContainerManager::_has_checked_file_list;
 bool SharedContainerManager::_clear_process_run = false;
 boost::shared_ptr<boost::thread> SharedContainerManager::_clear_process = nullptr;
+std::vector<std::function<void()> > SharedContainerManager::_background_tasks;
+boost::mutex SharedContainerManager::_background_lock;
 boost::shared_mutex SharedContainerManager::_wr_lock_global;
 boost::shared_mutex SharedContainerManager::_wr_lock_container_init;
 
@@ -30,7 +32,7 @@ SharedContainerManager::SharedContainerManager(const std::string group_name,  co
 SharedContainerManager::~SharedContainerManager() {
     boost_unique_lock lock(_wr_lock_local);
     for (auto ptr = _local_container_map.begin(); ptr != _local_container_map.end(); ptr++) {
-        DeleteContainer(ptr->first);
+        DeleteContainer(*ptr);
     }
 }
 
@@ -38,7 +40,7 @@ void SharedContainerManager::Release() {
     LEVIN_CINFO_LOG("Release function called, group id=[%s], container num=[%lu]", _group_name.c_str(), _local_container_map.size());
     boost_unique_lock lock(_wr_lock_local);
     for (auto ptr = _local_container_map.begin(); ptr != _local_container_map.end(); ptr++) {
-        ReleaseContainer(ptr->first);
+        ReleaseContainer(*ptr);
     }
     _local_container_map.clear();
 }
@@ -87,7 +89,7 @@ int SharedContainerManager::AddLoading(const std::string &key_path, std::shared_
 
     {
         boost_unique_lock lock(_wr_lock_local);
-        _local_container_map[key_path] = shared_ptr;
+        _local_container_map.insert(key_path);
     }
     return SC_RET_OK;
 }
@@ -131,28 +133,24 @@ void SharedContainerManager::ReleaseContainer(const std::string &key_path) {
     }
 }
 
-void SharedContainerManager::VerifyFileProcess(std::map<std::string, std::string>& md5_file_map,
-        boost::atomic<int>&  processed_file_idx,
-        boost::atomic<int>&  left_thread_num,
+// @brief files taken by index from a shared atomic cursor, O(1) per file without lock
+// result of each file written to its own slot
+void SharedContainerManager::VerifyFileProcess(const std::vector<std::pair<std::string, std::string> >& verify_list,
+        boost::atomic<size_t>& processed_file_idx,
+        boost::atomic<int>& left_thread_num,
         boost::atomic<bool>& is_check_stop,
-        std::vector<bool>& check_md5_list_result,
-        boost::mutex& cmutex,
+        std::vector<uint8_t>& check_md5_list_result,
         VerifyFileFuncPtr check_func) {
     while (true) {
-        int file_idx = processed_file_idx++;
-        int file_num = static_cast<int>(md5_file_map.size());
-        if (is_check_stop == true || file_idx >= file_num) {
+        size_t file_idx = processed_file_idx.fetch_add(1, boost::memory_order_relaxed);
+        if (is_check_stop == true || file_idx >= verify_list.size()) {
             int left = --left_thread_num;
             LEVIN_CINFO_LOG("Thread VerifyFileProcess end, left %d threads.", left);
             return;
         }
 
-        std::map<std::string, std::string>::iterator it = md5_file_map.begin();
-        for (int i = 0; i < file_idx; ++i) {
-            ++it;
-        }
-        std::string  list_file_name = it->first;
-        std::string  list_file_md5  = it->second;
+        const std::string &list_file_name = verify_list[file_idx].first;
+        const std::string &list_file_md5 = verify_list[file_idx].second;
         LEVIN_CINFO_LOG(
                 "Thread VerifyFileProcess file [%s], md5 [%s]",
                 list_file_name.c_str(),
@@ -163,16 +161,10 @@ void SharedContainerManager::VerifyFileProcess(std::map<std::string, std::string
                     "Thread VerifyFileProcess failed, GetFileMD5 [%s] error",
                     list_file_name.c_str());
             is_check_stop = true;
-            {
-                boost::mutex::scoped_lock lock(cmutex);
-                check_md5_list_result[file_idx] = false;
-            }
+            check_md5_list_result[file_idx] = false;
             continue;
         } else {
-            {
-                boost::mutex::scoped_lock lock(cmutex);
-                check_md5_list_result[file_idx] = true;
-            }
+            check_md5_list_result[file_idx] = true;
             {
                 boost_unique_lock lock(_wr_lock_global);
                 _has_checked_file_list.insert(list_file_name);
@@ -182,7 +174,7 @@ void SharedContainerManager::VerifyFileProcess(std::map<std::string, std::string
 }
 
 int SharedContainerManager::VerifyFiles(const std::map<std::string, std::string> verify_data,
-        VerifyFileFuncPtr check_func, const int app_id) {
+        VerifyFileFuncPtr check_func, const int app_id, bool verify_in_load) {
     int ret;
     std::map<std::string, std::string> diff_list;
     {
@@ -207,38 +199,39 @@ int SharedContainerManager::VerifyFiles(const std::map<std::string, std::string>
 
     for (auto ptr = global_mem_list.begin(); ptr != global_mem_list.end(); ptr++) {
         if (app_id == ptr->appid) {
-            diff_list.erase(ptr->path);
+            diff_list.erase(NumaReplicaPath(ptr->path));
         }
     }
+    if (verify_in_load && check_func == CheckFileMD5) {
+        LEVIN_CINFO_LOG("md5 of %lu files verified in load", diff_list.size());
+        return SC_RET_OK;
+    }
 
+    std::vector<std::pair<std::string, std::string> > verify_list(diff_list.begin(), diff_list.end());
     uint32_t thread_num;
     int cpu_num = sysconf(_SC_NPROCESSORS_CONF);
     thread_num = (cpu_num / 2) < 1 ? 1 : (cpu_num / 2);
-    if (thread_num > diff_list.size()) {
-        thread_num = diff_list.size();
+    if (thread_num > verify_list.size()) {
+        thread_num = verify_list.size();
     }
     LEVIN_CDEBUG_LOG("CheckDataMD5 cpu_num[%d] thread_num[%u]", cpu_num, thread_num);
 
-    boost::atomic<int> processed_file_idx(0);
+    boost::atomic<size_t> processed_file_idx(0);
     boost::atomic<int> left_thread_num(thread_num);
     boost::atomic<bool> is_check_stop(false);
 
-    boost::mutex check_mutex;
-    std::vector<bool> check_md5_list_result(diff_list.size());
-    for (size_t i = 0; i < check_md5_list_result.size(); ++i) {
-        check_md5_list_result[i] = false;
-    }
+    // one byte per file, NOT vector<bool> whose bits written by threads share words
+    std::vector<uint8_t> check_md5_list_result(verify_list.size(), false);
 
     std::vector<boost::shared_ptr<boost::thread> > check_threads;
     for (uint32_t i = 0; i < thread_num; ++i) {
         check_threads.push_back(boost::make_shared<boost::thread>(
             boost::bind(&SharedContainerManager::VerifyFileProcess,
-                        boost::ref(diff_list),
+                        boost::cref(verify_list),
                         boost::ref(processed_file_idx),
                         boost::ref(left_thread_num),
                         boost::ref(is_check_stop),
                         boost::ref(check_md5_list_result),
-                        boost::ref(check_mutex),
                         check_func)));
     }
 
@@ -248,7 +241,7 @@ int SharedContainerManager::VerifyFiles(const std::map<std::string, std::string>
 
     for (size_t i = 0; i < check_md5_list_result.size(); ++i) {
         if (check_md5_list_result[i] == false) {
-            LEVIN_CWARNING_LOG("CheckDataMD5 failed, check file [%lu] false", i);
+            LEVIN_CWARNING_LOG("CheckDataMD5 failed, check file [%s] false", verify_list[i].first.c_str());
             return SC_RET_FILE_CHECK;
         }
     }
@@ -273,8 +266,9 @@ int SharedContainerManager::ClearByFileList(
     }
 
     for (auto ptr = global_mem_list.begin(); ptr != global_mem_list.end(); ptr++) {
-        if ((app_id == ptr->appid) && absolute_files.find(ptr->path) == absolute_files.end()) {
-            _has_checked_file_list.erase(ptr->path);
+        std::string path = NumaReplicaPath(ptr->path);
+        if ((app_id == ptr->appid) && absolute_files.find(path) == absolute_files.end()) {
+            _has_checked_file_list.erase(path);
             SharedMemory::remove_shared_memory(ptr->mid);
         }
     }
@@ -292,7 +286,7 @@ int SharedContainerManager::ClearByGroup(
 
     for (auto ptr = global_mem_list.begin(); ptr != global_mem_list.end(); ptr++) {
         if (app_id == ptr->appid && reserve_groups.find(ptr->groupid) == reserve_groups.end()) {
-            _has_checked_file_list.erase(ptr->path);
+            _has_checked_file_list.erase(NumaReplicaPath(ptr->path));
             SharedMemory::remove_shared_memory(ptr->mid);
         }
     }
@@ -312,7 +306,7 @@ int SharedContainerManager::ClearUnregistered(const int app_id) {
         for (auto ptr = global_mem_list.begin(); ptr != global_mem_list.end(); ptr++) {
             if (app_id == ptr->appid 
                     && _global_container_map.find(ptr->path) == _global_container_map.end()) {
-                _has_checked_file_list.erase(ptr->path);
+                _has_checked_file_list.erase(NumaReplicaPath(ptr->path));
                 SharedMemory::remove_shared_memory(ptr->mid);
             }
         }
@@ -345,6 +339,26 @@ int SharedContainerManager::VerifyOneFile(const std::string &file_path) {
     }
 }
 
+bool SharedContainerManager::GetLoadMD5(const std::string &file_path, std::string &md5) {
+    boost_share_lock lock(_wr_lock_global);
+    if (_has_checked_file_list.find(file_path) != _has_checked_file_list.end()) {
+        return false;
+    }
+    auto it = _file_check_map.find(file_path);
+    // custom check func verified by a separate pass, md5 cached verified by CheckFileMD5 without read
+    if (it == _file_check_map.end() || it->second.second != CheckFileMD5 ||
+            DigestCache::GetInstance().IsVerified(file_path, it->second.first)) {
+        return false;
+    }
+    md5 = it->second.first;
+    return true;
+}
+
+void SharedContainerManager::SetFileChecked(const std::string &file_path) {
+    boost_unique_lock lock(_wr_lock_global);
+    _has_checked_file_list.insert(file_path);
+}
+
 void SharedContainerManager::ClearSharedContainerProcess() {
     while(_clear_process_run) {
         {
@@ -370,11 +384,37 @@ void SharedContainerManager::ClearSharedContainerProcess() {
                 _file_check_map.erase(*ptr);
             }
         }
+        // reload quarantined containers, export built containers, out of global lock which reload takes
+        std::vector<std::function<void()> > background_tasks;
+        {
+            boost::mutex::scoped_lock lock(_background_lock);
+            background_tasks.swap(_background_tasks);
+        }
+        for (const auto &task : background_tasks) {
+            task();
+        }
         boost::posix_time::milliseconds dura(1000);
         boost::this_thread::sleep(dura);
     }
 }
 
+void SharedContainerManager::AddBackgroundTask(const std::function<void()> &task) {
+    boost::mutex::scoped_lock lock(_background_lock);
+    _background_tasks.push_back(task);
+}
+
+bool SharedContainerManager::ExportContainer(
+        const std::shared_ptr<SharedBase> &container_ptr, const std::string &file) {
+    std::string tmp_file = file + ".tmp";
+    if (!container_ptr->Export(tmp_file) || rename(tmp_file.c_str(), file.c_str()) != 0) {
+        LEVIN_CWARNING_LOG("export container failed, file=[%s]", file.c_str());
+        unlink(tmp_file.c_str());
+        return false;
+    }
+    LEVIN_CINFO_LOG("export container success, file=[%s]", file.c_str());
+    return true;
+}
+
 void SharedContainerManager::StartClearProcess() {
     boost_unique_lock lock(_wr_lock_global);
     if (_clear_process_run == false) {
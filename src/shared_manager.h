@@ -6,6 +6,8 @@
 #include <map>
 #include <set>
 #include <exception>
+#include <vector>
+#include <functional>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp> 
 #include <boost/atomic.hpp>
@@ -23,6 +25,8 @@
 #include "shashmap.hpp"
 #include "snested_hashmap.hpp"
 #include "levin_timer.hpp"
+#include "container_options.h"
+#include "numa_utils.h"
 
 namespace levin {
 
@@ -61,42 +65,206 @@ public:
     SharedContainerManager(const std::string group_name,  const int app_id = 1);
     ~SharedContainerManager();
 
+    // @brief default options of containers registered by this manager
+    void SetOptions(const ContainerOptions &options) {
+        _options = options;
+    }
+    const ContainerOptions& GetOptions() const {
+        return _options;
+    }
+
     template <typename T>
     int Register(const std::string &file_path, std::shared_ptr<T> &container_ptr) {    //注册并获取容器指针
+        return Register(file_path, container_ptr, _options);
+    }
+
+    // @brief register with options specified for this container
+    // NUMA replicated container registers one replica per node,
+    // container_ptr is the replica local to the calling thread's node
+    template <typename T>
+    int Register(const std::string &file_path, std::shared_ptr<T> &container_ptr,
+            const ContainerOptions &options) {
         int ret;
         std::string absolute_path;
         ret = GetAbsolutePath(file_path, absolute_path);
         CHECK_RET(ret);
+        if (options.numa_policy != NumaPolicy::Replicate) {
+            return RegisterContainer(absolute_path, absolute_path, container_ptr, options);
+        }
+        ContainerOptions replica_options = options;
+        const int local_node = CurrentNumaNode();
+        for (int node = 0; node < NumaNodeNum(); ++node) {
+            std::shared_ptr<T> replica_ptr;
+            replica_options.numa_node = node;
+            ret = RegisterContainer(absolute_path, NumaReplicaName(absolute_path, node), replica_ptr,
+                    replica_options);
+            CHECK_RET(ret);
+            if (node == 0 || node == local_node) {
+                container_ptr = replica_ptr;
+            }
+        }
+        return SC_RET_OK;
+    }
+
+    // @brief build container of T straight into memory region by source(builder or vector, see T::Build),
+    // and publish it keyed by name without binfile; name is NOT read, but keyed as a file path
+    // container published by this manager under the same name is replaced, old one released when
+    // no longer referenced; export_file: binfile persisted in background after published, if specified
+    template <typename T, typename Source>
+    int Publish(const std::string &name, Source &source, std::shared_ptr<T> &container_ptr,
+            const std::string &export_file = "") {
+        std::string key_path;
+        int ret = GetAbsolutePath(name, key_path);
+        CHECK_RET(ret);
+        {
+            boost_share_lock lock(_wr_lock_global);
+            auto iter = _global_container_map.find(key_path);
+            if (iter != _global_container_map.end()) {
+                boost_share_lock local_lock(_wr_lock_local);
+                if (_local_container_map.find(key_path) == _local_container_map.end()) {
+                    LEVIN_CWARNING_LOG("container of file=[%s] has registed by other manager", key_path.c_str());
+                    return SC_RET_HAS_REGISTED;
+                }
+                if (iter->second.second != STATUS_READY) {
+                    return SC_RET_ERR_STATUS;
+                }
+            }
+        }
+        // one region per name, NOT replicated per NUMA node
+        ContainerOptions options = _options;
+        options.read_only = false;
+        if (options.numa_policy == NumaPolicy::Replicate) {
+            options.numa_policy = NumaPolicy::None;
+        }
+        try {
+            container_ptr.reset(new T(key_path, _group_name, _app_id));
+            container_ptr->SetOptions(options);
+            {
+                boost_unique_lock lock(_wr_lock_container_init);
+                ret = container_ptr->Build(source);
+            }
+        }
+        catch (std::exception& e) {
+            LEVIN_CWARNING_LOG(
+                "exception happened when build shared-container, name=[%s] msg=[%s]",
+                key_path.c_str(), e.what());
+            ret = SC_RET_EXCEPTION;
+        }
+        if (ret != SC_RET_OK) {
+            LEVIN_CWARNING_LOG("container build failed, name=[%s], ret=%d", key_path.c_str(), ret);
+            container_ptr.reset();
+            return ret;
+        }
+        container_ptr->Warmup();
+        {
+            boost_unique_lock lock(_wr_lock_global);
+            _global_container_map[key_path] = std::make_pair(container_ptr, STATUS_READY);
+        }
+        {
+            boost_unique_lock lock(_wr_lock_local);
+            _local_container_map.insert(key_path);
+        }
+        if (!export_file.empty()) {
+            std::shared_ptr<SharedBase> exported = container_ptr;
+            AddBackgroundTask([exported, export_file]() {
+                ExportContainer(exported, export_file);
+            });
+        }
+        LEVIN_CINFO_LOG("publish success, name=[%s], container size=%lu",
+                key_path.c_str(), container_ptr->size());
+        return SC_RET_OK;
+    }
+
+    template <typename T>
+    static int GetContanerPtr(const std::string &file_path, std::shared_ptr<T> &container_ptr) {
+        std::string absolute_path;
+        int ret = GetAbsolutePath(file_path, absolute_path);
+        CHECK_RET(ret);
+        {
+            boost_share_lock lock(_wr_lock_global);
+            // NUMA replicated, resolve to the replica local to the calling thread's node
+            std::string replica_path = NumaReplicaName(absolute_path, CurrentNumaNode());
+            if (_global_container_map.find(replica_path) != _global_container_map.end()) {
+                absolute_path = replica_path;
+            }
+            if (_global_container_map.find(absolute_path) != _global_container_map.end()) {
+                if (_global_container_map[absolute_path].second != STATUS_READY) {
+                    return SC_RET_ERR_STATUS;
+                }
+                container_ptr = std::dynamic_pointer_cast<T>(_global_container_map[absolute_path].first);
+                if (container_ptr == nullptr) {
+                    LEVIN_CWARNING_LOG(
+                        "get container ptr with err type, file path=[%s]",
+                        file_path.c_str());
+                    return SC_RET_ERR_TYPE;
+                }
+                return SC_RET_OK;
+            }
+        }
+
+        return SC_RET_NO_REGISTER;
+    }
 
+    void Release();
+
+    // @brief verify files NOT loaded yet by check_func
+    // verify_in_load: md5 of CheckFileMD5 NOT checked here, but verified by Register in the same pass
+    // the file is loaded, so the file is read once; Register fails with SC_RET_FILE_CHECK if mismatched
+    static int VerifyFiles(const std::map<std::string, std::string> verify_data,
+            VerifyFileFuncPtr check_func = CheckFileMD5, const int app_id = 1, bool verify_in_load = false);
+
+    static int ClearByFileList(const std::set<std::string> &reserve_files, const int app_id = 1);  
+
+    static int ClearByGroup(const std::set<std::string> &reserve_groups, const int app_id = 1);
+
+    static int ClearUnregistered(const int app_id = 1);
+
+private:
+    // @brief register container loaded from absolute_path, keyed by key_path
+    template <typename T>
+    int RegisterContainer(const std::string &absolute_path, const std::string &key_path,
+            std::shared_ptr<T> &container_ptr, const ContainerOptions &options) {
+        int ret;
         try {
             container_ptr.reset(new T(absolute_path, _group_name, _app_id));
             if (container_ptr == nullptr) {
-                LEVIN_CWARNING_LOG("creat new container failed, file path=[%s]", file_path.c_str());
+                LEVIN_CWARNING_LOG("creat new container failed, file path=[%s]", key_path.c_str());
                 return SC_RET_OOM;
             }
-            ret = AddLoading(absolute_path, container_ptr);
+            // md5 of file registered by VerifyFiles verified in the same pass of load, file read once
+            ContainerOptions container_options = options;
+            bool is_load_md5 = (!options.read_only && GetLoadMD5(absolute_path, container_options.load_md5));
+            container_ptr->SetOptions(container_options);
+            SetReloadOnCorrupt(container_ptr, absolute_path, key_path, _group_name, _app_id, options);
+            ret = AddLoading(key_path, container_ptr);
             CHECK_RET(ret);
-            {
+            if (options.read_only) {
+                // reader only attaches existing and verified shm, never blocked by loaders
+                ret = container_ptr->Init();
+            } else {
                 boost_unique_lock lock(_wr_lock_container_init);
                 ret = container_ptr->Init();
             }
             if (ret != SC_RET_OK) {
-                if (ret == SC_RET_OOM) {
+                if (ret == SC_RET_OOM && !options.read_only) {
                     ClearUnregistered();
                     ret = container_ptr->Init();
                 }
                 if (ret != SC_RET_OK) {
-                    DeleteLoading(absolute_path);
+                    DeleteLoading(key_path);
                     LEVIN_CWARNING_LOG(
                             "container init failed, file path=[%s], ret=%d",
-                            file_path.c_str(), ret);
+                            key_path.c_str(), ret);
                     return ret;
                 }
             }
 
+            // read only container not exist is mapped binfile, which is validated by Load
             if (!container_ptr->IsExist()) {
-                ret = VerifyOneFile(absolute_path);
-                CHECK_RET(ret);
+                if (!options.read_only && !is_load_md5) {
+                    ret = VerifyOneFile(absolute_path);
+                    CHECK_RET(ret);
+                }
                 ret = container_ptr->Load();
                 if (ret != SC_RET_OK) {
                     LEVIN_CWARNING_LOG(
@@ -104,78 +272,119 @@ public:
                             absolute_path.c_str());
                     container_ptr->Destroy();
                     container_ptr.reset();
-                    DeleteLoading(absolute_path);
+                    DeleteLoading(key_path);
                     return ret;
                 }
+                if (is_load_md5) {
+                    SetFileChecked(absolute_path);
+                }
             }
+            // block until warm, or warm in background if warmup_async
+            container_ptr->Warmup();
         }
         catch (std::exception& e) {
             LEVIN_CWARNING_LOG(
                 "exception happened when creat shared-container, file_path=[%s] msg=[%s]",
-                file_path.c_str(), e.what());
+                key_path.c_str(), e.what());
             if (container_ptr) {
                 container_ptr->Destroy();
                 container_ptr.reset();
             }
-            DeleteLoading(absolute_path);
+            DeleteLoading(key_path);
             return SC_RET_EXCEPTION;
         }
         catch (...) {
             LEVIN_CWARNING_LOG(
                 "exception happened when creat shared-container, file_path=[%s] msg=[unknown]",
-                file_path.c_str());
+                key_path.c_str());
             if (container_ptr) {
                 container_ptr->Destroy();
                 container_ptr.reset();
             }
-            DeleteLoading(absolute_path);
+            DeleteLoading(key_path);
             return SC_RET_EXCEPTION;
         }
-        ret = UpdateSharedStatus(absolute_path, STATUS_READY);
+        ret = UpdateSharedStatus(key_path, STATUS_READY);
         CHECK_RET(ret);
         LEVIN_CINFO_LOG(
                 "register success, path=[%s], container size=%lu",
-                file_path.c_str(), container_ptr->size());
+                key_path.c_str(), container_ptr->size());
         return SC_RET_OK;
     }
 
+    // @brief container quarantined by background verifier(options.verify_lazy) is reloaded
+    // by clear process, and replaces the corrupted one if it is still registered
     template <typename T>
-    static int GetContanerPtr(const std::string &file_path, std::shared_ptr<T> &container_ptr) {
-        std::string absolute_path;
-        int ret = GetAbsolutePath(file_path, absolute_path);
-        CHECK_RET(ret);
+    static void SetReloadOnCorrupt(const std::shared_ptr<T> &container_ptr, const std::string &absolute_path,
+            const std::string &key_path, const std::string &group, const int app_id,
+            const ContainerOptions &options) {
+        std::weak_ptr<SharedBase> corrupted = container_ptr;
+        container_ptr->SetCorruptCallback([=]() {
+            LEVIN_CWARNING_LOG("container corrupted, reload in background, path=[%s]", key_path.c_str());
+            AddBackgroundTask([=]() {
+                ReloadContainer<T>(absolute_path, key_path, group, app_id, options, corrupted);
+            });
+        });
+    }
+
+    template <typename T>
+    static int ReloadContainer(const std::string &absolute_path, const std::string &key_path,
+            const std::string &group, const int app_id, const ContainerOptions &options,
+            const std::weak_ptr<SharedBase> &corrupted) {
         {
-            boost_share_lock lock(_wr_lock_global);
-            if (_global_container_map.find(absolute_path) != _global_container_map.end()) {
-                if (_global_container_map[absolute_path].second != STATUS_READY) {
-                    return SC_RET_ERR_STATUS;
-                }
-                container_ptr = std::dynamic_pointer_cast<T>(_global_container_map[absolute_path].first);
-                if (container_ptr == nullptr) {
-                    LEVIN_CWARNING_LOG(
-                        "get container ptr with err type, file path=[%s]",
-                        file_path.c_str());
-                    return SC_RET_ERR_TYPE;
-                }
-                return SC_RET_OK;
+            // quarantined: GetContanerPtr fails with SC_RET_ERR_STATUS until reloaded
+            boost_unique_lock lock(_wr_lock_global);
+            auto iter = _global_container_map.find(key_path);
+            if (iter == _global_container_map.end() || iter->second.second != STATUS_READY ||
+                    iter->second.first != corrupted.lock()) {
+                LEVIN_CWARNING_LOG("corrupted container no longer registered, path=[%s]", key_path.c_str());
+                return SC_RET_NO_REGISTER;
             }
+            iter->second.second = STATUS_LOADING;
         }
-
-        return SC_RET_NO_REGISTER;
+        int ret = SC_RET_OK;
+        std::shared_ptr<T> container_ptr;
+        try {
+            container_ptr.reset(new T(absolute_path, group, app_id));
+            container_ptr->SetOptions(options);
+            SetReloadOnCorrupt(container_ptr, absolute_path, key_path, group, app_id, options);
+            {
+                boost_unique_lock lock(_wr_lock_container_init);
+                ret = container_ptr->Init();
+            }
+            if (ret == SC_RET_OK && !container_ptr->IsExist()) {
+                ret = container_ptr->Load();
+            }
+        }
+        catch (std::exception& e) {
+            LEVIN_CWARNING_LOG(
+                "exception happened when reload shared-container, file_path=[%s] msg=[%s]",
+                key_path.c_str(), e.what());
+            ret = SC_RET_EXCEPTION;
+        }
+        if (ret != SC_RET_OK) {
+            // left quarantined, released with its manager
+            LEVIN_CWARNING_LOG("reload corrupted container failed, path=[%s], ret=%d", key_path.c_str(), ret);
+            return ret;
+        }
+        container_ptr->Warmup();
+        boost_unique_lock lock(_wr_lock_global);
+        auto iter = _global_container_map.find(key_path);
+        if (iter == _global_container_map.end() || iter->second.second != STATUS_LOADING ||
+                iter->second.first != corrupted.lock()) {
+            LEVIN_CWARNING_LOG("corrupted container released while reloading, path=[%s]", key_path.c_str());
+            return SC_RET_NO_REGISTER;
+        }
+        iter->second = std::make_pair(container_ptr, STATUS_READY);
+        LEVIN_CINFO_LOG("reload corrupted container success, path=[%s]", key_path.c_str());
+        return SC_RET_OK;
     }
 
-    void Release();
-
-    static int VerifyFiles(const std::map<std::string, std::string> verify_data,
-            VerifyFileFuncPtr check_func = CheckFileMD5, const int app_id = 1);
-
-    static int ClearByFileList(const std::set<std::string> &reserve_files, const int app_id = 1);  
-
-    static int ClearByGroup(const std::set<std::string> &reserve_groups, const int app_id = 1);
+    static void AddBackgroundTask(const std::function<void()> &task);
 
-    static int ClearUnregistered(const int app_id = 1);
+    // @brief binfile written to a temporary file and renamed, never seen partially written
+    static bool ExportContainer(const std::shared_ptr<SharedBase> &container_ptr, const std::string &file);
 
-private:
     static int GetAbsolutePath(const std::string &file_path, std::string &absolute_path);
 
     int AddLoading(const std::string &key_path, std::shared_ptr<SharedBase> shared_ptr);
@@ -190,14 +399,18 @@ private:
 
     int VerifyOneFile(const std::string &file_path);
 
+    // @brief expected md5 of file registered by VerifyFiles with CheckFileMD5 and NOT checked yet
+    static bool GetLoadMD5(const std::string &file_path, std::string &md5);
+
+    static void SetFileChecked(const std::string &file_path);
+
     static void ClearSharedContainerProcess();
 
-    static void VerifyFileProcess(std::map<std::string, std::string>& md5_file_map,
-            boost::atomic<int>&  processed_file_idx,
-            boost::atomic<int>&  left_thread_num,
+    static void VerifyFileProcess(const std::vector<std::pair<std::string, std::string> >& verify_list,
+            boost::atomic<size_t>& processed_file_idx,
+            boost::atomic<int>& left_thread_num,
             boost::atomic<bool>& is_check_stop,
-            std::vector<bool>& check_md5_list_result,
-            boost::mutex& cmutex,
+            std::vector<uint8_t>& check_md5_list_result,
             VerifyFileFuncPtr check_func);
 
     static void StartClearProcess();
@@ -209,14 +422,18 @@ private:
     SharedContainerManager& operator =(const SharedContainerManager&) = delete;
     SharedContainerManager& operator =(SharedContainerManager&&) = delete;
 
-    std::map<std::string, std::shared_ptr<SharedBase> > _local_container_map;
+    // keys of containers registered by this manager, containers owned by _global_container_map
+    std::set<std::string> _local_container_map;
     std::string _group_name;
     int _app_id;
+    ContainerOptions _options;
     static std::map<std::string, ptr_status_pair> _global_container_map;
     static std::map<std::string, auth_func_pair> _file_check_map;
     static std::set<std::string> _has_checked_file_list;
     static bool _clear_process_run;
     static boost::shared_ptr<boost::thread> _clear_process;
+    static std::vector<std::function<void()> > _background_tasks;
+    static boost::mutex _background_lock;
 
     //读写锁
     boost::shared_mutex _wr_lock_local;
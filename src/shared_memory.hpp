@@ -2,12 +2,23 @@
 #define LEVIN_SHARED_MEMORY_HPP
 
 #include <fstream>
+#include <vector>
+#include <algorithm>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/algorithm/string.hpp>
 #include "xsi_shm.hpp"
 #include "shared_utils.h"
+#include "shared_allocator.h"
 #include "id_manager.h"
+#include "shm_catalog.h"
+#include "container_options.h"
+#include "numa_utils.h"
 
 namespace levin {
 
@@ -26,27 +37,71 @@ public:
     }
 
     // @brief Open or create memory
+    // mem_size: container size, read from binfile header if 0
+    // binfile NOT needed if region built in place, or reader attaches existing region of its own size
     virtual int init(const size_t fixed_size) {
-        std::ifstream fin(_path, std::ios::in | std::ios::binary);
-        if (!fin.is_open()) {
+        std::ifstream fin;
+        if (!_is_built) {
+            fin.open(_path, std::ios::in | std::ios::binary);
+        }
+        if (!_is_built && !fin.is_open() && !_options.read_only) {
             return SC_RET_FILE_NOEXIST;
         }
-        if (_mem_size == 0) {
+        if (_mem_size == 0 && fin.is_open()) {
             fin.read((char*)&_mem_size, sizeof(_mem_size));
             if (!fin) {
                 return SC_RET_READ_FAIL;
             }
         }
         _mem_size += fixed_size;
-        if (_mem_size == 0 || _mem_size >= MAX_MEM_SIZE) {
+        if (_mem_size == 0 || reserved_size() >= max_size()) {
             LEVIN_CWARNING_LOG("init memory fail. illegal size=%lu", _mem_size);
             return SC_RET_SHM_SIZE_ERR;
         }
         return SC_RET_OK;
     }
     virtual bool remove() = 0;
+    // @brief remove memory region from the system while keeping it mapped by this process,
+    // later processes create a new region of the same name, eg. quarantine of corrupted region
+    // private memory(heap, mapped binfile) is never shared, nothing to unlink
+    // retval succ: true fail: false (Never throws)
+    virtual bool unlink() { return true; }
+
+    // @brief options take effect on next init
+    void set_options(const ContainerOptions &options) {
+        _options = options;
+    }
+    void set_group(const std::string &group) {
+        _group = group;
+    }
+    // @brief region of mem_size built in place, NOT loaded from binfile
+    void set_built() {
+        _is_built = true;
+    }
+    // @brief name of memory region: binfile path, or replica name if NUMA replicated
+    std::string name() const {
+        return (_options.numa_policy == NumaPolicy::Replicate ?
+                NumaReplicaName(_path, _options.numa_node) : _path);
+    }
+    // @brief size of memory region reserved, rounded up to huge page granularity if specified
+    // NOTE: get_size is still used by allocator for bound check, tail of last huge page is unused
+    size_t reserved_size() const {
+        size_t page = _options.huge_page_size;
+        return (page == 0 ? _mem_size : (_mem_size + page - 1) / page * page);
+    }
+
+    // @brief upper limit of memory region size
+    virtual size_t max_size() const { return MAX_MEM_SIZE; }
+    // @brief number of segments the memory region consists of
+    virtual size_t segment_num() const { return 1; }
+    // @brief memory region still mapped as a whole, segments contiguous
+    virtual bool verify() const { return true; }
+    // @brief container loaded and checked, state published to other processes
+    virtual void publish(uint64_t version) { (void)version; }
 
     virtual bool is_exist() const { return false; }
+    // @brief binfile header&container already mapped in place, no need to read file
+    virtual bool is_file_mapped() const { return false; }
     virtual void* get_address() const { return nullptr; }
     virtual std::size_t get_size() const { return _mem_size; }
     virtual const std::string &info() const { return _info; }
@@ -56,6 +111,9 @@ protected:
     size_t _mem_size = 0;
     int _id = 0;
     std::string _info;
+    ContainerOptions _options;
+    std::string _group;
+    bool _is_built = false;
 };
 
 // @brief Heap memory
@@ -73,11 +131,29 @@ public:
         if (ret != SC_RET_OK) {
             return ret;
         }
+        // process private memory, nothing to attach
+        if (_options.read_only) {
+            LEVIN_CWARNING_LOG("heap memory NOT attachable read only. path=%s", _path.c_str());
+            return SC_RET_SHM_NOEXIST;
+        }
 
-        _ptr = (void*)malloc(_mem_size);
+        // page aligned if huge page or NUMA policy specified
+        size_t page = _options.huge_page_size;
+        if (page == 0 && _options.numa_policy != NumaPolicy::None) {
+            page = sysconf(_SC_PAGESIZE);
+        }
+        if (page == 0) {
+            _ptr = (void*)malloc(_mem_size);
+        } else if (posix_memalign(&_ptr, page, reserved_size()) != 0) {
+            _ptr = nullptr;
+        }
         if (_ptr == nullptr) {
             return SC_RET_OOM;
         }
+        if (_options.huge_page_size > 0 && madvise(_ptr, reserved_size(), MADV_HUGEPAGE) != 0) {
+            LEVIN_CWARNING_LOG("madvise huge page fail, use normal page. path=%s, errno=%d", _path.c_str(), errno);
+        }
+        NumaBindRegion(_ptr, reserved_size(), _options.numa_policy, _options.numa_node);
         set_info();
         LEVIN_CINFO_LOG("heap memory init succ. path=%s, info=%s", _path.c_str(), _info.c_str());
         return SC_RET_OK;
@@ -96,6 +172,7 @@ private:
     void set_info() {
         std::stringstream ss;
         ss << "HeapMemory size=" << get_size()
+           << " reserved=" << reserved_size()
            << " region=["
            << get_address() << "," << (void*)((size_t)get_address() + get_size()) << ")";
         _info = ss.str();
@@ -105,6 +182,93 @@ private:
     void* _ptr = nullptr;
 };
 
+// @brief Read-only mapped binfile (zero copy)
+// binfile pages are mapped MAP_SHARED, so every process mapping the same file shares page cache
+// region layout: [ meta (private anonymous) | file header + container (file mapping) ]
+// meta is placed at the tail of the anonymous pages, adjacent to the page aligned file mapping
+class MappedFileMemory : public MemoryBase {
+public:
+    MappedFileMemory(const std::string &path, int id = 1, const size_t mem_size = 0) :
+        MemoryBase(path, id, mem_size) {
+    }
+    virtual ~MappedFileMemory() {
+        remove();
+    }
+
+    virtual int init(const size_t fixed_size) override;
+    virtual bool remove() override {
+        if (_base != nullptr) {
+            munmap(_base, _map_size);
+            _base = nullptr;
+            _address = nullptr;
+        }
+        return true;
+    }
+
+    virtual bool is_file_mapped() const override { return true; }
+    virtual void* get_address() const override { return _address; }
+
+private:
+    void set_info() {
+        std::stringstream ss;
+        ss << "MappedFileMemory size=" << get_size()
+           << " region=["
+           << get_address() << "," << (void*)((size_t)get_address() + get_size()) << ")";
+        _info = ss.str();
+    }
+
+private:
+    void *_base = nullptr;     // base of whole reservation, page aligned
+    size_t _map_size = 0;      // length of whole reservation
+    void *_address = nullptr;  // address of meta
+};
+
+inline int MappedFileMemory::init(const size_t fixed_size) {
+    int ret = MemoryBase::init(fixed_size);
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    // memory size = meta + file header + container, file size = file header + container
+    const size_t meta_len = fixed_size - SharedAllocator::Allocsize(sizeof(SharedFileHeader));
+    const size_t file_len = _mem_size - meta_len;
+    int fd = open(_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return SC_RET_FILE_NOEXIST;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < file_len) {
+        LEVIN_CWARNING_LOG("mapped file size mismatch. path=%s, expect=%lu", _path.c_str(), file_len);
+        close(fd);
+        return SC_RET_READ_FAIL;
+    }
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t meta_pages = (meta_len + page_size - 1) / page_size * page_size;
+    _map_size = meta_pages + file_len;
+    void *base = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return SC_RET_OOM;
+    }
+    // populate page tables of the whole file at map time if specified
+    int flags = MAP_SHARED | MAP_FIXED | (_options.warmup == WarmupPolicy::Populate ? MAP_POPULATE : 0);
+    void *file_addr = mmap((char*)base + meta_pages, file_len, PROT_READ, flags, fd, 0);
+    int err = errno;
+    close(fd);
+    if (file_addr == MAP_FAILED) {
+        munmap(base, _map_size);
+        LEVIN_CWARNING_LOG("mmap file fail. path=%s, errno=%d", _path.c_str(), err);
+        return SC_RET_ERR_SYS;
+    }
+    if (_options.huge_page_size > 0 && madvise(file_addr, file_len, MADV_HUGEPAGE) != 0) {
+        LEVIN_CWARNING_LOG("madvise huge page fail, use normal page. path=%s, errno=%d", _path.c_str(), errno);
+    }
+    _base = base;
+    _address = (char*)file_addr - meta_len;
+    set_info();
+    LEVIN_CINFO_LOG("mapped file init succ. path=%s, info=%s", _path.c_str(), _info.c_str());
+    return SC_RET_OK;
+}
+
 // @brief System V share memory
 class SharedMemory : public MemoryBase {
 public:
@@ -117,6 +281,7 @@ public:
     // @brief Open or create shared memory
     virtual int init(const size_t fixed_size) override;
     virtual bool remove() override;
+    virtual bool unlink() override;
 
     //@brief Return base address of share memory
     virtual void* get_address() const override {
@@ -128,6 +293,9 @@ public:
     virtual bool is_exist() const override {
         return _is_exist;
     }
+    virtual void publish(uint64_t version) override {
+        ShmCatalog::GetInstance().Update(name(), _shmid, CatalogState::Ready, version);
+    }
 
     //@brief Return ID which identifies the share memory
     int get_shmid() const {
@@ -141,11 +309,14 @@ public:
     static bool get_all_shmid(std::vector<SharedMidInfo> &shmid_info, bool no_attach = true);
 
 private:
+    int create();
+    int acquire(const std::string &shm_name);
     bool check_path();
     void set_info() {
         std::stringstream ss;
         ss << "SharedMemory shmid=" << get_shmid()
            << " size=" << get_size()
+           << " reserved=" << reserved_size()
            << " region=["
            << get_address() << "," << (void*)((size_t)get_address() + get_size()) << ")";
         _info = ss.str();
@@ -158,6 +329,8 @@ private:
     int _shmid = IPC_PRIVATE;
     boost::scoped_ptr<MappedRegion> _region_ptr;
     bool _is_exist = false;
+    bool _is_taken_over = false;     // Loading region of dead loader taken over by catalog
+    bool _is_unlinked = false;
 };
 
 inline int SharedMemory::init(const size_t fixed_size) {
@@ -166,21 +339,24 @@ inline int SharedMemory::init(const size_t fixed_size) {
         return ret;
     }
 
-    boost::scoped_ptr<XsiSharedMemory> shm_ptr(new XsiSharedMemory);
-    if (shm_ptr.get() == nullptr) {
-        return SC_RET_OOM;
-    }
-    if (IdManager::GetInstance().GetId(_path, _shmid)) {
+    const std::string shm_name = name();
+    if (ShmCatalog::GetInstance().IsValid()) {
+        ret = acquire(shm_name);
+    } else if (IdManager::GetInstance().GetId(shm_name, _shmid)) {
         _is_exist = true;
-    } else {
-        if (shm_ptr->open(XsiShmCreateMode::Create, _shmid, _mem_size) != 0) {
-            return SC_RET_ERR_SYS;
-        }
-        _shmid = shm_ptr->get_shmid();
-        IdManager::GetInstance().Register(_shmid, _path);
+    } else if (_options.read_only) {
+        ret = SC_RET_SHM_NOEXIST;
+    } else if ((ret = create()) == SC_RET_OK) {
+        IdManager::GetInstance().Register(_shmid, shm_name);
+    }
+    if (ret == SC_RET_SHM_NOEXIST) {
+        LEVIN_CINFO_LOG("shm no exist, read only NOT create. path=%s", shm_name.c_str());
+    }
+    if (ret != SC_RET_OK) {
+        return ret;
     }
-    LEVIN_CINFO_LOG("path=%s, shmid=%d, is_exist=%d", _path.c_str(), get_shmid(), is_exist());
-    _region_ptr.reset(new MappedRegion(_shmid));
+    LEVIN_CINFO_LOG("path=%s, shmid=%d, is_exist=%d", shm_name.c_str(), get_shmid(), is_exist());
+    _region_ptr.reset(new MappedRegion(_shmid, _options.read_only ? SHM_RDONLY : 0));
     if (_region_ptr.get() == nullptr) {
         return SC_RET_OOM;
     }
@@ -192,25 +368,99 @@ inline int SharedMemory::init(const size_t fixed_size) {
         LEVIN_CWARNING_LOG("shared memory init fail. system errno=%d", ret);
         return SC_RET_ERR_SYS;
     }
-    // double check path desc of the existed shm
-    if (_is_exist && !check_path()) {
+    // double check path desc of the existed shm, skipped if taken over by path in catalog
+    // which meta maybe NOT constructed yet by dead loader
+    if (_is_exist && !_is_taken_over && !check_path()) {
         return SC_RET_SHM_KEY_CONFLICT;
     }
+    // placement policy applies to pages faulted in later, by loader of the new shm
+    if (!_is_exist) {
+        NumaBindRegion(get_address(), get_size(), _options.numa_policy, _options.numa_node);
+    }
     set_info();
     LEVIN_CINFO_LOG("shared memory init succ. path=%s, info=%s", _path.c_str(), _info.c_str());
     return SC_RET_OK;
 }
 
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SharedMemory::create() {
+    XsiSharedMemory shm;
+    int err = shm.open(XsiShmCreateMode::Create, IPC_PRIVATE, _mem_size, 0644, _options.huge_page_size);
+    if (err != 0 && _options.huge_page_size > 0) {
+        // no hugetlbfs pages reserved(ENOMEM) or no privilege(EPERM)
+        LEVIN_CWARNING_LOG("create shm with huge page fail, fallback to normal page. path=%s, huge_page_size=%lu, errno=%d",
+                _path.c_str(), _options.huge_page_size, err);
+        _options.huge_page_size = 0;
+        err = shm.open(XsiShmCreateMode::Create, IPC_PRIVATE, _mem_size);
+    }
+    if (err != 0) {
+        return SC_RET_ERR_SYS;
+    }
+    _shmid = shm.get_shmid();
+    return SC_RET_OK;
+}
+
+// @brief find shm of name in catalog, or create it and become the loader
+// shm Loading by another process is waited until published Ready
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SharedMemory::acquire(const std::string &shm_name) {
+    ShmCatalog::CreateFunc create_func;
+    bool is_created = false;
+    if (!_options.read_only) {
+        // called under catalog lock, catalog NOT accessed inside
+        create_func = [this, &shm_name, &is_created](CatalogEntry &entry) {
+            int ret = create();
+            is_created = (ret == SC_RET_OK);
+            if (ret == SC_RET_OK) {
+                entry = CatalogEntry(shm_name, _group, _shmid, _id, _mem_size);
+            }
+            return ret;
+        };
+    }
+    CatalogEntry entry;
+    bool is_loader = false;
+    int ret = ShmCatalog::GetInstance().Acquire(
+            shm_name, create_func, _options.load_wait_timeout_ms, entry, is_loader);
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    _shmid = entry.shmid;
+    if (is_loader && entry.size != _mem_size) {
+        // taken over from dead loader, but binfile changed since
+        LEVIN_CWARNING_LOG("shm of dead loader mismatched, recreate. path=%s, shmid=%d, size=%lu, expected=%lu",
+                shm_name.c_str(), _shmid, entry.size, _mem_size);
+        if (!remove()) {
+            return SC_RET_ERR_SYS;
+        }
+        return acquire(shm_name);
+    }
+    // taken over from dead loader: region exists, partial load resumed or recycled by container
+    _is_exist = !is_created;
+    _is_taken_over = (is_loader && !is_created);
+    IdManager::GetInstance().Refresh(_shmid, shm_name);
+    return SC_RET_OK;
+}
+
 inline bool SharedMemory::remove() {
     if (_region_ptr.get() != nullptr) {
         _region_ptr.reset();
     }
+    return (_is_unlinked || unlink());
+}
+
+// @brief marked destroyed(IPC_RMID), shm freed by kernel after the last detach
+inline bool SharedMemory::unlink() {
+    if (_is_unlinked) {
+        return true;
+    }
     if (!XsiSharedMemory::remove(_shmid)) {
         LEVIN_CWARNING_LOG("remove shm failed. path=%s, shmid=%d", _path.c_str(), _shmid);
         return false;
     }
     IdManager::GetInstance().DeRegister(_shmid);
-    LEVIN_CINFO_LOG("remove shm succ. path=%s, shmid=%d", _path.c_str(), _shmid);
+    ShmCatalog::GetInstance().Erase(name(), _shmid);
+    _is_unlinked = true;
+    LEVIN_CINFO_LOG("remove shm succ. path=%s, shmid=%d", name().c_str(), _shmid);
     return true;
 }
 
@@ -220,19 +470,399 @@ inline bool SharedMemory::check_path() {
     }
     SharedMeta *meta = static_cast<SharedMeta*>(_region_ptr->get_address());
     if (std::string(meta->summary).find(LEVIN_PATTERN) != std::string::npos &&
-        _path.compare(meta->path) == 0) {
+        name().compare(meta->path) == 0) {
         return true;
     }
-    LEVIN_CWARNING_LOG("shm key conflict, shm file:%s, load file:%s", meta->path, _path.c_str());
+    LEVIN_CWARNING_LOG("shm key conflict, shm file:%s, load file:%s", meta->path, name().c_str());
     return false;
 }
 
+// @brief System V share memory splitted into segments
+// region beyond MAX_MEM_SIZE or shmmax consists of several segments, attached side by side
+// into one reserved range of virtual address, so offsets within container keep valid across segments
+// first segment starts with meta, registered by name like SharedMemory,
+// following segments are keyed by hash of name and segment index
+class SegmentedSharedMemory : public MemoryBase {
+public:
+    static const size_t MAX_SEGMENT_NUM = 64;
+
+    SegmentedSharedMemory(const std::string &path, int id = 1, const size_t mem_size = 0) :
+        MemoryBase(path, id, mem_size) {
+    }
+    virtual ~SegmentedSharedMemory() {
+        detach();
+    }
+
+    // @brief Open or create segments, attach them contiguously
+    virtual int init(const size_t fixed_size) override;
+    virtual bool remove() override;
+    virtual bool unlink() override;
+
+    virtual size_t max_size() const override { return segment_size() * MAX_SEGMENT_NUM; }
+    virtual size_t segment_num() const override { return _segments.size(); }
+    virtual bool verify() const override;
+    virtual void publish(uint64_t version) override {
+        ShmCatalog::GetInstance().Update(name(), get_shmid(), CatalogState::Ready, version);
+    }
+
+    virtual void* get_address() const override { return _address; }
+    virtual std::size_t get_size() const override { return _size; }
+    virtual bool is_exist() const override { return _is_exist; }
+
+    //@brief Return ID of the first segment, which identifies the share memory
+    int get_shmid() const {
+        return (_segments.empty() ? IPC_PRIVATE : _segments[0].shmid);
+    }
+
+    // @brief key of following segment(index > 0) of the named memory region
+    static key_t segment_key(const std::string &name, size_t index);
+    // @brief remove following segments of the named memory region, first segment excluded
+    static void remove_segments(const std::string &name);
+
+private:
+    struct Segment {
+        int shmid;
+        size_t size;
+        void *address;
+    };
+
+    size_t segment_size() const;
+    size_t align_size() const {
+        return std::max((size_t)sysconf(_SC_PAGESIZE), _options.huge_page_size);
+    }
+    int create_segments();
+    int open_segments(int shmid);
+    int acquire(const std::string &shm_name);
+    int attach_segments();
+    void detach();
+    bool check_path() const;
+    void set_info() {
+        std::stringstream ss;
+        ss << "SegmentedSharedMemory shmid=" << get_shmid()
+           << " segments=" << segment_num()
+           << " size=" << get_size()
+           << " region=["
+           << get_address() << "," << (void*)((size_t)get_address() + get_size()) << ")";
+        _info = ss.str();
+    }
+
+private:
+    std::vector<Segment> _segments;
+    void *_base = nullptr;       // base of whole reservation
+    size_t _map_size = 0;        // length of whole reservation
+    void *_address = nullptr;    // address of first segment(meta)
+    size_t _size = 0;            // total size of segments
+    bool _is_exist = false;
+    bool _is_taken_over = false;     // Loading region of dead loader taken over by catalog
+    bool _is_unlinked = false;
+};
+
+// @brief segment size, multiple of page(SHMLBA) or huge page, so segments attached side by side
+inline size_t SegmentedSharedMemory::segment_size() const {
+    size_t size = _options.shm_segment_size;
+    if (size == 0) {
+        size = MAX_MEM_SIZE;
+        size_t shmmax = 0;
+        std::ifstream fin("/proc/sys/kernel/shmmax");
+        if (fin >> shmmax && shmmax < size) {
+            size = shmmax;
+        }
+    }
+    const size_t align = align_size();
+    return std::max(size / align, (size_t)1) * align;
+}
+
+inline int SegmentedSharedMemory::init(const size_t fixed_size) {
+    int ret = MemoryBase::init(fixed_size);
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    detach();
+    _segments.clear();
+    const std::string shm_name = name();
+    int shmid = IPC_PRIVATE;
+    if (ShmCatalog::GetInstance().IsValid()) {
+        ret = acquire(shm_name);
+    } else if ((_is_exist = IdManager::GetInstance().GetId(shm_name, shmid))) {
+        ret = open_segments(shmid);
+    } else if (_options.read_only) {
+        ret = SC_RET_SHM_NOEXIST;
+    } else if ((ret = create_segments()) == SC_RET_OK) {
+        IdManager::GetInstance().Register(get_shmid(), shm_name);
+    }
+    if (ret == SC_RET_SHM_NOEXIST) {
+        LEVIN_CINFO_LOG("shm no exist, read only NOT create. path=%s", shm_name.c_str());
+    }
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    LEVIN_CINFO_LOG("path=%s, shmid=%d, segments=%lu, is_exist=%d",
+            name().c_str(), get_shmid(), segment_num(), is_exist());
+    ret = attach_segments();
+    if (ret != SC_RET_OK) {
+        if (!_is_exist) {
+            remove();
+        }
+        return ret;
+    }
+    // double check path desc of the existed shm, skipped if taken over by path in catalog
+    // which meta maybe NOT constructed yet by dead loader
+    if (_is_exist && !_is_taken_over && !check_path()) {
+        return SC_RET_SHM_KEY_CONFLICT;
+    }
+    if (!_is_exist) {
+        NumaBindRegion(get_address(), get_size(), _options.numa_policy, _options.numa_node);
+    }
+    set_info();
+    LEVIN_CINFO_LOG("segmented shared memory init succ. path=%s, info=%s", _path.c_str(), _info.c_str());
+    return SC_RET_OK;
+}
+
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SegmentedSharedMemory::create_segments() {
+    const std::string shm_name = name();
+    // segments left by removed region of the same name, processes attached keep their mapping
+    remove_segments(shm_name);
+    const size_t seg_size = segment_size();
+    const size_t num = (_mem_size + seg_size - 1) / seg_size;
+    for (size_t i = 0; i < num; ++i) {
+        const size_t size = (i + 1 < num ? seg_size : _mem_size - i * seg_size);
+        const key_t key = (i == 0 ? IPC_PRIVATE : segment_key(shm_name, i));
+        XsiSharedMemory shm;
+        int err = shm.open(XsiShmCreateMode::Create, key, size, 0644, _options.huge_page_size);
+        if (err == 0) {
+            _segments.push_back({shm.get_shmid(), size, nullptr});
+            continue;
+        }
+        LEVIN_CWARNING_LOG("create shm segment fail. path=%s, index=%lu, size=%lu, errno=%d",
+                shm_name.c_str(), i, size, err);
+        for (const auto &segment : _segments) {
+            XsiSharedMemory::remove(segment.shmid);
+        }
+        _segments.clear();
+        if (err != EEXIST && _options.huge_page_size > 0) {
+            LEVIN_CWARNING_LOG("create shm with huge page fail, fallback to normal page. path=%s, huge_page_size=%lu",
+                    _path.c_str(), _options.huge_page_size);
+            _options.huge_page_size = 0;
+            return create_segments();
+        }
+        return (err == EEXIST ? SC_RET_SHM_KEY_CONFLICT : SC_RET_ERR_SYS);
+    }
+    return SC_RET_OK;
+}
+
+// @brief find segments of name in catalog, or create them and become the loader
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SegmentedSharedMemory::acquire(const std::string &shm_name) {
+    ShmCatalog::CreateFunc create_func;
+    bool is_created = false;
+    if (!_options.read_only) {
+        // called under catalog lock, catalog NOT accessed inside
+        create_func = [this, &shm_name, &is_created](CatalogEntry &entry) {
+            int ret = create_segments();
+            is_created = (ret == SC_RET_OK);
+            if (ret == SC_RET_OK) {
+                entry = CatalogEntry(shm_name, _group, get_shmid(), _id, _mem_size, segment_num());
+            }
+            return ret;
+        };
+    }
+    CatalogEntry entry;
+    bool is_loader = false;
+    int ret = ShmCatalog::GetInstance().Acquire(
+            shm_name, create_func, _options.load_wait_timeout_ms, entry, is_loader);
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    if (_segments.empty() && (ret = open_segments(entry.shmid)) != SC_RET_OK) {
+        return ret;
+    }
+    if (is_loader && entry.size != _mem_size) {
+        // taken over from dead loader, but binfile changed since
+        LEVIN_CWARNING_LOG("shm of dead loader mismatched, recreate. path=%s, shmid=%d, size=%lu, expected=%lu",
+                shm_name.c_str(), entry.shmid, entry.size, _mem_size);
+        if (!remove()) {
+            return SC_RET_ERR_SYS;
+        }
+        return acquire(shm_name);
+    }
+    // taken over from dead loader: region exists, partial load resumed or recycled by container
+    _is_exist = !is_created;
+    _is_taken_over = (is_loader && !is_created);
+    IdManager::GetInstance().Refresh(get_shmid(), shm_name);
+    return SC_RET_OK;
+}
+
+// @brief collect existed segments, from the first one registered by name
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SegmentedSharedMemory::open_segments(int shmid) {
+    const std::string shm_name = name();
+    for (size_t i = 0; i < MAX_SEGMENT_NUM; ++i) {
+        if (i > 0 && (shmid = shmget(segment_key(shm_name, i), 0, 0)) == -1) {
+            break;
+        }
+        shmid_ds shm_ds;
+        if (shmctl(shmid, IPC_STAT, &shm_ds) == -1) {
+            LEVIN_CWARNING_LOG("stat shm segment fail. path=%s, index=%lu, errno=%d", shm_name.c_str(), i, errno);
+            return SC_RET_ERR_SYS;
+        }
+        _segments.push_back({shmid, shm_ds.shm_segsz, nullptr});
+    }
+    return SC_RET_OK;
+}
+
+// @brief reserve virtual address range of all segments, then attach segments in place by SHM_REMAP
+// retval succ: SC_RET_OK fail: error code (Never throws)
+inline int SegmentedSharedMemory::attach_segments() {
+    const size_t align = align_size();
+    size_t total = 0;
+    for (const auto &segment : _segments) {
+        total += (segment.size + align - 1) / align * align;
+    }
+    // over reserved by align, base of first segment aligned to huge page
+    _map_size = total + align;
+    void *base = mmap(nullptr, _map_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LEVIN_CWARNING_LOG("reserve address range fail. path=%s, size=%lu, errno=%d", _path.c_str(), _map_size, errno);
+        _map_size = 0;
+        return SC_RET_OOM;
+    }
+    _base = base;
+    _address = (void*)(((size_t)base + align - 1) / align * align);
+    _size = 0;
+    for (auto &segment : _segments) {
+        // segments except the last one sized multiple of align, otherwise NOT contiguous
+        if (_size % align != 0) {
+            LEVIN_CWARNING_LOG("shm segment NOT aligned. path=%s, shmid=%d, offset=%lu",
+                    _path.c_str(), segment.shmid, _size);
+            return SC_RET_SHM_KEY_CONFLICT;
+        }
+        void *addr = shmat(segment.shmid, (char*)_address + _size,
+                SHM_REMAP | (_options.read_only ? SHM_RDONLY : 0));
+        if (addr == (void*)-1) {
+            int err = errno;
+            LEVIN_CWARNING_LOG("attach shm segment fail. path=%s, shmid=%d, errno=%d", _path.c_str(), segment.shmid, err);
+            return (err == ENOMEM ? SC_RET_OOM : SC_RET_ERR_SYS);
+        }
+        segment.address = addr;
+        _size += segment.size;
+    }
+    return SC_RET_OK;
+}
+
+inline void SegmentedSharedMemory::detach() {
+    for (auto &segment : _segments) {
+        if (segment.address != nullptr) {
+            shmdt(segment.address);
+            segment.address = nullptr;
+        }
+    }
+    if (_base != nullptr) {
+        munmap(_base, _map_size);
+        _base = nullptr;
+    }
+    _map_size = 0;
+    _address = nullptr;
+    _size = 0;
+}
+
+inline bool SegmentedSharedMemory::remove() {
+    detach();
+    bool succ = unlink();
+    _segments.clear();
+    return succ;
+}
+
+inline bool SegmentedSharedMemory::unlink() {
+    if (_segments.empty() || _is_unlinked) {
+        return true;
+    }
+    bool succ = true;
+    for (const auto &segment : _segments) {
+        if (!XsiSharedMemory::remove(segment.shmid)) {
+            LEVIN_CWARNING_LOG("remove shm segment failed. path=%s, shmid=%d", _path.c_str(), segment.shmid);
+            succ = false;
+        }
+    }
+    IdManager::GetInstance().DeRegister(_segments[0].shmid);
+    ShmCatalog::GetInstance().Erase(name(), _segments[0].shmid);
+    LEVIN_CINFO_LOG("remove shm succ. path=%s, shmid=%d, segments=%lu", name().c_str(), get_shmid(), segment_num());
+    _is_unlinked = true;
+    return succ;
+}
+
+// @brief every segment still exists(NOT marked destroyed) with the attached size, adjacent to the previous one
+inline bool SegmentedSharedMemory::verify() const {
+    if (_address == nullptr || _segments.empty()) {
+        return false;
+    }
+    size_t offset = 0;
+    for (const auto &segment : _segments) {
+        shmid_ds shm_ds;
+        if (segment.address != (char*)_address + offset ||
+                shmctl(segment.shmid, IPC_STAT, &shm_ds) == -1 || shm_ds.shm_segsz != segment.size ||
+                (shm_ds.shm_perm.mode & SHM_DEST) != 0) {
+            LEVIN_CWARNING_LOG("shm segment mismatch. path=%s, shmid=%d, offset=%lu",
+                    _path.c_str(), segment.shmid, offset);
+            return false;
+        }
+        offset += segment.size;
+    }
+    return offset == _size;
+}
+
+inline bool SegmentedSharedMemory::check_path() const {
+    SharedMeta *meta = static_cast<SharedMeta*>(_address);
+    if (std::string(meta->summary).find(LEVIN_PATTERN) != std::string::npos &&
+        name().compare(meta->path) == 0) {
+        return true;
+    }
+    LEVIN_CWARNING_LOG("shm key conflict, shm file:%s, load file:%s", meta->path, name().c_str());
+    return false;
+}
+
+inline key_t SegmentedSharedMemory::segment_key(const std::string &name, size_t index) {
+    std::string key = name;
+    key.append(1, '\0').append(std::to_string(index));
+    unsigned char digest[MD5SUM_DIGEST_LENGTH];
+    MD5((const unsigned char*)key.data(), key.size(), digest);
+    key_t shm_key = 0;
+    memcpy(&shm_key, digest, sizeof(shm_key));
+    return (shm_key == IPC_PRIVATE ? 1 : shm_key);
+}
+
+inline void SegmentedSharedMemory::remove_segments(const std::string &name) {
+    for (size_t i = 1; i < MAX_SEGMENT_NUM; ++i) {
+        int shmid = shmget(segment_key(name, i), 0, 0);
+        if (shmid != -1 && XsiSharedMemory::remove(shmid)) {
+            LEVIN_CINFO_LOG("remove shm segment succ. path=%s, index=%lu, shmid=%d", name.c_str(), i, shmid);
+        }
+    }
+}
+
 inline bool SharedMemory::remove_shared_memory(int shmid) {
+    // following segments of SegmentedSharedMemory, keyed by name in catalog or meta
+    ShmCatalog &catalog = ShmCatalog::GetInstance();
+    CatalogEntry entry;
+    if (catalog.FindById(shmid, entry)) {
+        if (entry.segments > 1) {
+            SegmentedSharedMemory::remove_segments(entry.path);
+        }
+    } else {
+        MappedRegion region(shmid, SHM_RDONLY);
+        if (region.attach() == 0) {
+            SharedMeta *meta = static_cast<SharedMeta*>(region.get_address());
+            if (std::string(meta->summary).find(LEVIN_PATTERN) != std::string::npos) {
+                SegmentedSharedMemory::remove_segments(meta->path);
+            }
+        }
+    }
     if (!XsiSharedMemory::remove(shmid)) {
         LEVIN_CWARNING_LOG("remove shm failed, shmid: %d", shmid);
         return false;
     }
     IdManager::GetInstance().DeRegister(shmid);
+    catalog.Erase(shmid);
     return true;
 }
 
@@ -240,6 +870,191 @@ inline bool SharedMemory::get_all_shmid(std::vector<SharedMidInfo> &shmid_info,
     return IdManager::get_all_shmid(shmid_info, no_attach);
 }
 
+// @brief POSIX share memory, shm_open under /dev/shm
+// object named by hash of absolute path/group/appid, found again by a single shm_open
+// instead of a scan of all System V segments, and NOT bounded by shmmax/shmmni
+class PosixSharedMemory : public MemoryBase {
+public:
+    PosixSharedMemory(const std::string &path, int id = 1, const size_t mem_size = 0) :
+        MemoryBase(path, id, mem_size) {
+    }
+    virtual ~PosixSharedMemory() {
+        unmap();
+    }
+
+    virtual int init(const size_t fixed_size) override;
+    virtual bool remove() override;
+    virtual bool unlink() override;
+
+    virtual void* get_address() const override { return _address; }
+    virtual bool is_exist() const override { return _is_exist; }
+
+    // @brief name of POSIX shm object, eg. /levin.626738dd02fccd46b2d9ed8d093014d7
+    const std::string& get_shm_name() const { return _shm_name; }
+    static std::string shm_name(const std::string &path, const std::string &group, int id);
+
+private:
+    int open_shm(bool &is_created);
+    void unmap() {
+        if (_address != nullptr) {
+            munmap(_address, reserved_size());
+            _address = nullptr;
+        }
+    }
+    void set_info() {
+        std::stringstream ss;
+        ss << "PosixSharedMemory name=" << _shm_name
+           << " size=" << get_size()
+           << " region=["
+           << get_address() << "," << (void*)((size_t)get_address() + get_size()) << ")";
+        _info = ss.str();
+    }
+
+private:
+    std::string _shm_name;
+    ino_t _ino = 0;             // inode of shm object, avoid unlinking the recreated one
+    void *_address = nullptr;
+    bool _is_exist = false;
+};
+
+inline std::string PosixSharedMemory::shm_name(const std::string &path, const std::string &group, int id) {
+    char real_path[PATH_MAX] = {0};
+    std::string key = (realpath(path.c_str(), real_path) != nullptr ? std::string(real_path) : path);
+    key.append(1, '\0').append(group).append(1, '\0').append(std::to_string(id));
+    unsigned char digest[MD5SUM_DIGEST_LENGTH];
+    MD5((const unsigned char*)key.data(), key.size(), digest);
+    char hex[MD5SUM_DIGEST_LENGTH * 2 + 1] = {0};
+    for (size_t i = 0; i < MD5SUM_DIGEST_LENGTH; ++i) {
+        snprintf(&hex[2 * i], 3, "%02x", digest[i]);
+    }
+    return "/" + LEVIN_PATTERN + "." + hex;
+}
+
+// @brief open existed shm object, or create a new one sized by memory size
+// existed object with mismatched size is stale(binfile changed), unlinked and recreated,
+// processes attached to it keep their mapping
+// retval succ: fd fail: -1 (Never throws)
+inline int PosixSharedMemory::open_shm(bool &is_created) {
+    const size_t size = reserved_size();
+    if (_options.read_only) {
+        // reader never creates or unlinks, stale object treated as missing
+        int fd = shm_open(_shm_name.c_str(), O_RDONLY, 0644);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size == size) {
+            is_created = false;
+            return fd;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    for (int retry = 0; retry < 2; ++retry) {
+        int fd = shm_open(_shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        if (fd >= 0) {
+            if (ftruncate(fd, size) != 0) {
+                LEVIN_CWARNING_LOG("ftruncate shm fail. name=%s, errno=%d", _shm_name.c_str(), errno);
+                close(fd);
+                shm_unlink(_shm_name.c_str());
+                return -1;
+            }
+            is_created = true;
+            return fd;
+        }
+        if (errno != EEXIST) {
+            LEVIN_CWARNING_LOG("shm_open fail. name=%s, errno=%d", _shm_name.c_str(), errno);
+            return -1;
+        }
+        fd = shm_open(_shm_name.c_str(), O_RDWR, 0644);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size == size) {
+            is_created = false;
+            return fd;
+        }
+        LEVIN_CWARNING_LOG("stale shm, unlink and recreate. name=%s, path=%s", _shm_name.c_str(), name().c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        shm_unlink(_shm_name.c_str());
+    }
+    return -1;
+}
+
+inline int PosixSharedMemory::init(const size_t fixed_size) {
+    int ret = MemoryBase::init(fixed_size);
+    if (ret != SC_RET_OK) {
+        return ret;
+    }
+    unmap();
+    _shm_name = shm_name(name(), _group, _id);
+    bool is_created = false;
+    int fd = open_shm(is_created);
+    if (fd < 0) {
+        return (_options.read_only ? SC_RET_SHM_NOEXIST : SC_RET_ERR_SYS);
+    }
+    struct stat st;
+    _ino = (fstat(fd, &st) == 0 ? st.st_ino : 0);
+    if (!is_created && _options.read_only && _ino != 0) {
+        // reader maps existing region of its own size
+        _mem_size = st.st_size;
+    }
+    const int prot = (_options.read_only ? PROT_READ : PROT_READ | PROT_WRITE);
+    void *addr = mmap(nullptr, reserved_size(), prot, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        LEVIN_CWARNING_LOG("mmap shm fail. name=%s, errno=%d", _shm_name.c_str(), err);
+        return (err == ENOMEM ? SC_RET_OOM : SC_RET_ERR_SYS);
+    }
+    _address = addr;
+    _is_exist = !is_created;
+    if (_is_exist) {
+        // double check path desc of the existed shm, hash collision or not levin created
+        SharedMeta *meta = static_cast<SharedMeta*>(_address);
+        if (std::string(meta->summary).find(LEVIN_PATTERN) == std::string::npos ||
+                name().compare(meta->path) != 0) {
+            LEVIN_CWARNING_LOG("shm key conflict, shm file:%s, load file:%s", meta->path, name().c_str());
+            return SC_RET_SHM_KEY_CONFLICT;
+        }
+    } else {
+        if (_options.huge_page_size > 0 && madvise(_address, reserved_size(), MADV_HUGEPAGE) != 0) {
+            LEVIN_CWARNING_LOG("madvise huge page fail, use normal page. path=%s, errno=%d", _path.c_str(), errno);
+        }
+        NumaBindRegion(_address, reserved_size(), _options.numa_policy, _options.numa_node);
+    }
+    set_info();
+    LEVIN_CINFO_LOG("posix shared memory init succ. path=%s, is_exist=%d, info=%s",
+            name().c_str(), _is_exist, _info.c_str());
+    return SC_RET_OK;
+}
+
+inline bool PosixSharedMemory::remove() {
+    unmap();
+    return unlink();
+}
+
+inline bool PosixSharedMemory::unlink() {
+    if (_shm_name.empty()) {
+        return true;
+    }
+    int fd = shm_open(_shm_name.c_str(), O_RDONLY, 0644);
+    struct stat st;
+    bool is_same = (fd >= 0 && fstat(fd, &st) == 0 && st.st_ino == _ino);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!is_same) {
+        LEVIN_CINFO_LOG("shm already unlinked or recreated. path=%s, name=%s", name().c_str(), _shm_name.c_str());
+        return true;
+    }
+    if (shm_unlink(_shm_name.c_str()) != 0 && errno != ENOENT) {
+        LEVIN_CWARNING_LOG("remove shm failed. path=%s, name=%s, errno=%d", name().c_str(), _shm_name.c_str(), errno);
+        return false;
+    }
+    LEVIN_CINFO_LOG("remove shm succ. path=%s, name=%s", name().c_str(), _shm_name.c_str());
+    return true;
+}
+
 }  // namespace levin
 
 #endif  // LEVIN_SHARED_MEMORY_HPP
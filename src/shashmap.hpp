@@ -3,11 +3,15 @@
 
 #include <unordered_map>
 #include "details/hashmap.hpp"
+#include "details/bucket_builder.hpp"
 #include "shared_base.hpp"
 #include "svec.hpp"
 
 namespace levin {
 
+template <class Key, class Value, class Hash = std::hash<Key> >
+class SharedHashMapBuilder;
+
 template<class Key, class Value>
 class HashIterator;
 
@@ -34,24 +38,35 @@ public:
         _object(nullptr) {
     }
 
+    // @brief reducer of hash into bucket and layout of records set here if memory region exists, by Load otherwise
     virtual int Init() override {
-        return _init<container_type, Mem>(_object);
+        int ret = _init<container_type, Mem>(_object);
+        return (ret == SC_RET_OK && IsExist() ? _buckets() : ret);
     }
 
     virtual int Load() override {
-        return _load<container_type>(_object);
+        int ret = _load<container_type>(_object);
+        return (ret == SC_RET_OK ? _buckets() : ret);
     }
 
+    // @brief build container straight into memory region from builder, instead of Init&Load of binfile
+    // name is key of memory region(NOT read), region of the same name published before is replaced
+    // records of builder released whether succ or fail
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    int Build(SharedHashMapBuilder<Key, Value, Hash> &builder);
+
     virtual bool Export(const std::string &file) override;
 
     // @brief T is ordered/unordered KV mapper type
     // which SHOULD has the same Key&Value type with expected SharedHashmap
+    // options: bucket count/load factor, reduction of hash into bucket and layout of records, see BucketOptions
     template <class T,
               typename = typename std::enable_if<
                   std::is_same<typename T::key_type, Key>::value &&
                   std::is_same<typename T::mapped_type, Value>::value>::type>
-    static bool Dump(const std::string &file, const T &map);
-    static bool Dump(const std::string &file, const std::vector<std::pair<Key, Value> > &vec);
+    static bool Dump(const std::string &file, const T &map, const BucketOptions &options = BucketOptions());
+    static bool Dump(const std::string &file, const std::vector<std::pair<Key, Value> > &vec,
+            const BucketOptions &options = BucketOptions());
     static bool dump(
             const std::string &file,
             const size_t size,
@@ -61,20 +76,35 @@ public:
     bool empty() const { return _object->size() == 0; }
     size_t size() const { return _object->size(); }
     size_t bucket_size() const { return _object->bucket_size(); }
-    iterator find(Key key) { return _object->find(key); }
-    const_iterator find(Key key) const { return _object->find(key); }
+    BucketReduce bucket_reduce() const { return _reducer.reduce(); }
+    BucketLayout bucket_layout() const { return _layout; }
+    iterator find(Key key) { return _object->find(key, _reducer, _layout); }
+    const_iterator find(Key key) const { return _object->find(key, _reducer, _layout); }
+    // @brief n keys found with cache misses overlapped, values[i] nullptr if keys[i] NOT found
+    // retval number of keys found
+    size_t find_batch(const Key *keys, size_t n, const Value **values) const {
+        return _object->find_batch(keys, n, _reducer, values, _layout);
+    }
+    // @brief bucket of key prefetched, eg. for key of next find
+    void prefetch(const Key &key) const { _object->prefetch(key, _reducer); }
     
-    iterator begin() { return _object->begin(); }
-    const_iterator begin() const { return _object->begin(); }
+    iterator begin() { return _object->begin(_layout); }
+    const_iterator begin() const { return _object->begin(_layout); }
     iterator end() { return _object->end(); }
     const_iterator end() const { return _object->end(); }
 
-    size_t count(const Key& key) { return _object->count(key); }
+    size_t count(const Key& key) { return (find(key) == end() ? 0 : 1); }
     // @brief mybe THROW
     // STD unordered_map performing an insertion if such key does not already exist
     // Levin hashmap will throw out_of_range if key does not exist, just as at
-    const Value& operator[](const Key& key) { return find(key)->second; }
-    const Value& at(const Key& key) const { return _object->at(key); }
+    const Value& operator[](const Key& key) { return at(key); }
+    const Value& at(const Key& key) const {
+        const Value *value = _object->find_value(key, _reducer, _layout);
+        if (value == nullptr) {
+            throw std::out_of_range("accessed position out of range");
+        }
+        return *value;
+    }
 
     std::string layout() const {
         std::stringstream ss;
@@ -97,10 +127,137 @@ public:
         }
         return 0;
     }
+private:
+    // @brief reduction and layout of binfile, set when loaded or built
+    // retval succ: SC_RET_OK fail: SC_RET_LOAD_FAIL (Never throws)
+    int _buckets() {
+        int ret = _bucket_reducer(_object->bucket_size(), _reducer);
+        return (ret == SC_RET_OK ? _bucket_layout(_layout) : ret);
+    }
+
 private:
     container_type *_object = nullptr;
+    // @brief hash to bucket by reduction of binfile, set when loaded or built
+    BucketReducer _reducer;
+    BucketLayout _layout = BucketLayout::Pair;
 };
 
+// @brief streaming builder of SharedHashMap binfile, records added one by one
+// records kept flat in blocks, partitioned into hash buckets in place and written in the layout of
+// SharedHashMap::Dump, so peak memory is ~1x of binfile, without a vector per bucket
+template <class Key, class Value, class Hash>
+class SharedHashMapBuilder {
+public:
+    typedef HashMap<Key, Value, Hash>                container_type;
+    typedef typename container_type::bucket_type     bucket_type;
+    typedef typename container_type::value_type      value_type;
+    typedef typename container_type::value_size_type value_size_type;
+    typedef typename container_type::size_type       size_type;
+
+    explicit SharedHashMapBuilder(const BucketOptions &options = BucketOptions()) : _options(options) {}
+
+    void Add(const Key &key, const Value &value) {
+        _records.push_back(value_type(key, value));
+    }
+    size_t size() const { return _records.size(); }
+    // @brief bucket count by options, prime ~1x of size by default
+    size_t bucket_count() const {
+        return BucketCountOf(_options, _records.size(), getPrime(_records.size()));
+    }
+
+    // @brief size of container written, without file header
+    size_t container_size() const {
+        size_t size = _records.size();
+        return sizeof(container_type) + bucket_count() * sizeof(bucket_type) + size * sizeof(value_type);
+    }
+
+    // @brief write binfile, records released whether succ or fail
+    bool Dump(const std::string &file);
+    // @brief write binfile image by writer, eg. straight into memory region by SharedHashMap::Build
+    // name: binfile or container name for log; records released whether succ or fail
+    bool Write(const std::string &name, BinWriter &writer);
+
+private:
+    BucketOptions _options;
+    ChunkedArray<value_type> _records;
+};
+
+template <class Key, class Value, class Hash>
+bool SharedHashMapBuilder<Key, Value, Hash>::Dump(const std::string &file) {
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        _records.clear();
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool ret = Write(file, writer);
+    return (close(fd) == 0) && ret;
+}
+
+template <class Key, class Value, class Hash>
+bool SharedHashMapBuilder<Key, Value, Hash>::Write(const std::string &name, BinWriter &writer) {
+    typedef SharedNestedVector<value_type, value_size_type> buckets_type;
+    size_t size = _records.size();
+    size_t bucket_count = this->bucket_count();
+    uint32_t thread_num = DumpThreadNum(size);
+    const bool split = (_options.layout == BucketLayout::Split);
+    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld, reduce=%d, layout=%d, thread=%u",
+            name.c_str(), size, bucket_count, (int)_options.reduce, (int)_options.layout, thread_num);
+
+    // write file header: used memory size(meta size + container size)/container type hash
+    size_t type_hash = typeid(container_type).hash_code();
+    SharedFileHeader header = {container_size(), type_hash,
+            makeFlags(SharedBase::SC_VERSION, _options.reduce, _options.layout)};
+    size_type imap_headers[2] = {size, bucket_count};
+    off_t base = sizeof(header) + sizeof(imap_headers);
+    // split layout: keys of records from records_base, values from values_base
+    off_t records_base = base + buckets_type::array_offset(bucket_count, 0);
+    off_t values_base = records_base + SplitRecords<Key, Value>::ValuesOffset(size);
+    bool ret = writer.write(&header, sizeof(header), 0) &&
+            writer.write(imap_headers, sizeof(imap_headers), sizeof(header));
+    if (!ret) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+    }
+    // buckets partitioned and sorted by threads, each range of buckets written at its final position
+    std::vector<uint32_t> counts;
+    Hash hashfun;
+    BucketReducer reducer(_options.reduce, bucket_count);
+    ret = ret && buckets_type::write_header(name, writer, base, bucket_count) &&
+            PartitionBuckets(_records, bucket_count,
+            [&hashfun, &reducer](const value_type &kv) { return reducer(hashfun(kv.first)); },
+            CMP<Key, Value>, thread_num, counts,
+            [&](size_t bucket_begin, size_t bucket_end, size_t record_begin) {
+        size_t record_end = record_begin;
+        for (size_t i = bucket_begin; i < bucket_end; ++i) {
+            record_end += counts[i];
+        }
+        if (!buckets_type::write_col_headers(name, writer, base, bucket_count, bucket_begin, bucket_end,
+                    record_begin, [&counts](size_t i) { return counts[i]; }) ||
+                !(split ? _records.write_split(writer, records_base, values_base, record_begin, record_end) :
+                    _records.write(writer, base + buckets_type::array_offset(bucket_count, record_begin),
+                        record_begin, record_end))) {
+            LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+            return false;
+        }
+        return true;
+    });
+    if (ret && split && !WriteSplitPadding<Key, Value>(writer, records_base, size)) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+        ret = false;
+    }
+    _records.clear();
+    return ret;
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+int SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Build(SharedHashMapBuilder<Key, Value, Hash> &builder) {
+    int ret = _build<container_type, Mem>(_object, builder.container_size(), [this, &builder](BinWriter &writer) {
+        return builder.Write(_info->_name, writer);
+    });
+    return (ret == SC_RET_OK ? _buckets() : ret);
+}
+
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 bool SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Export(const std::string &file) {
     return _bin2file(file, container_memsize(this->_object), _object);
@@ -108,42 +265,25 @@ bool SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Export(const std::string &
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 template <class T, typename>
-bool SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(const std::string &file, const T &map) {
-    std::ofstream fout(file, std::ios::out | std::ios::binary);
-    if (!fout.is_open()) {
-        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
-        return false;
-    }
+bool SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
+        const std::string &file, const T &map, const BucketOptions &options) {
     // key: hash buckets idx
     // val: [ pair<key, value> ]
-    size_t bucket_count = getPrime(map.size());
-    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld", file.c_str(), map.size(), bucket_count);
-    Hash hashfun;
-    std::vector<std::vector<std::pair<Key, Value> > > datas(
-            bucket_count, std::vector<std::pair<Key, Value> >());
+    SharedHashMapBuilder<Key, Value, Hash> builder(options);
     for (auto it = map.begin(); it != map.end(); ++it) {
-        datas[hashfun(it->first) % bucket_count].emplace_back(std::make_pair(it->first, it->second));
+        builder.Add(it->first, it->second);
     }
-    return SharedHashMap<Key, Value, Hash, CheckFunc>::dump(file, map.size(), datas, fout);
+    return builder.Dump(file);
 }
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 bool SharedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
-        const std::string &file, const std::vector<std::pair<Key, Value> > &vec) {
-    std::ofstream fout(file, std::ios::out | std::ios::binary);
-    if (!fout.is_open()) {
-        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
-        return false;
-    }
-    size_t bucket_count = getPrime(vec.size());
-    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld", file.c_str(), vec.size(), bucket_count);
-    Hash hashfun;
-    std::vector<std::vector<std::pair<Key, Value> > > datas(
-            bucket_count, std::vector<std::pair<Key, Value> >());
+        const std::string &file, const std::vector<std::pair<Key, Value> > &vec, const BucketOptions &options) {
+    SharedHashMapBuilder<Key, Value, Hash> builder(options);
     for (const auto &kv: vec) {
-        datas[hashfun(kv.first) % bucket_count].emplace_back(std::make_pair(kv.first, kv.second));
+        builder.Add(kv.first, kv.second);
     }
-    return SharedHashMap<Key, Value, Hash, CheckFunc>::dump(file, vec.size(), datas, fout);
+    return builder.Dump(file);
 }
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
@@ -29,22 +29,29 @@ public:
             _object(nullptr) {
     }
 
+    // @brief reducer of hash into bucket set here if memory region exists, by Load otherwise
     virtual int Init() override {
-        return _init<container_type, Mem>(_object);
+        int ret = _init<container_type, Mem>(_object);
+        return (ret == SC_RET_OK && IsExist() ? _bucket_reducer(_object->bucket_count(), _reducer) : ret);
     }
 
     virtual int Load() override {
-        return _load<container_type>(_object);
+        int ret = _load<container_type>(_object);
+        return (ret == SC_RET_OK ? _bucket_reducer(_object->bucket_count(), _reducer) : ret);
     }
 
     virtual bool Export(const std::string &file) override;
+    // @brief options: bucket count/load factor and reduction of hash into bucket, see BucketOptions
+    // bucket count of hashset by default
     static bool Dump(
             const std::string &file,
-            const std::unordered_set<Key, Hash, Pred> &hashset);
+            const std::unordered_set<Key, Hash, Pred> &hashset,
+            const BucketOptions &options = BucketOptions());
 
     bool empty() const { return _object->empty(); }
     size_t size() const { return _object->size(); }
     size_t bucket_count() const { return _object->bucket_count(); }
+    BucketReduce bucket_reduce() const { return _reducer.reduce(); }
     // @brief no range check, as std unordered_set
     size_t bucket_size(size_t n) const { return _object->bucket_size(n); }
     const Key* cbegin() const { return _object->cbegin(); }
@@ -52,13 +59,22 @@ public:
     // ret type const refrence for reminder readonly
     const Key* begin() const { return _object->begin(); }
     const Key* end() const { return _object->end(); }
-    const Key* find(const Key& key) const { return _object->find(key); }
-    size_t count(const Key& key) const { return _object->count(key); }
+    const Key* find(const Key& key) const { return _object->find(key, _reducer); }
+    size_t count(const Key& key) const { return (find(key) == cend() ? 0 : 1); }
+    // @brief n keys found with cache misses overlapped, results[i] nullptr if keys[i] NOT found
+    // retval number of keys found
+    size_t find_batch(const Key *keys, size_t n, const Key **results) const {
+        return _object->find_batch(keys, n, _reducer, results);
+    }
+    // @brief bucket of key prefetched, eg. for key of next find
+    void prefetch(const Key &key) const { _object->prefetch(key, _reducer); }
 
     std::string layout() const;
 
 protected:
     container_type *_object = nullptr;
+    // @brief hash to bucket by reduction of binfile, set when loaded
+    BucketReducer _reducer;
 };
 
 template <class Key, class Hash, class Pred, class Mem, class CheckFunc>
@@ -69,14 +85,16 @@ bool SharedHashSet<Key, Hash, Pred, Mem, CheckFunc>::Export(const std::string &f
 template <class Key, class Hash, class Pred, class Mem, class CheckFunc>
 bool SharedHashSet<Key, Hash, Pred, Mem, CheckFunc>::Dump(
         const std::string &file,
-        const std::unordered_set<Key, Hash, Pred> &hashset) {
-    size_t bucket_count = hashset.bucket_count();
-    LEVIN_CDEBUG_LOG("Dump(). file=%s, hashset size=%ld, bcount=%ld, bucket count=%ld",
-            file.c_str(), hashset.size(), hashset.bucket_count(), bucket_count);
+        const std::unordered_set<Key, Hash, Pred> &hashset,
+        const BucketOptions &options) {
+    size_t bucket_count = BucketCountOf(options, hashset.size(), hashset.bucket_count());
+    LEVIN_CDEBUG_LOG("Dump(). file=%s, hashset size=%ld, bcount=%ld, bucket count=%ld, reduce=%d",
+            file.c_str(), hashset.size(), hashset.bucket_count(), bucket_count, (int)options.reduce);
     std::vector<std::vector<Key> > datas(bucket_count, std::vector<Key>());
     Hash hasher;
+    BucketReducer reducer(options.reduce, bucket_count);
     for (const auto &key : hashset) {
-        datas[hasher(key) % bucket_count].emplace_back(key);
+        datas[reducer(hasher(key))].emplace_back(key);
     }
     std::ofstream fout(file, std::ios::out | std::ios::binary);
     if (!fout.is_open()) {
@@ -90,7 +108,7 @@ bool SharedHashSet<Key, Hash, Pred, Mem, CheckFunc>::Dump(
         container_size += row.size() * sizeof(value_type);
     }
     size_t type_hash = typeid(container_type).hash_code();
-    SharedFileHeader header = {container_size, type_hash, makeFlags(SharedBase::SC_VERSION)};
+    SharedFileHeader header = {container_size, type_hash, makeFlags(SharedBase::SC_VERSION, options.reduce)};
     fout.write((const char*)&header, sizeof(header));
     CHECK_FILE_READ_OR_WRITE_RES(fout, file);
 
@@ -0,0 +1,417 @@
+#include "shm_catalog.h"
+#include <errno.h>
+#include <algorithm>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/shm.h>
+#include "id_manager.h"
+#include "levin_logger.h"
+
+namespace levin {
+
+// "LEVINCAT" + layout version, catalog of other layout NOT used
+static const uint64_t CATALOG_MAGIC = 0x4c4556494e434102;
+// waiter wakes up at least every interval, to check whether the loader died
+static const uint32_t LOADER_CHECK_MS = 100;
+static const int CATALOG_WAIT_MS = 5000;    // creator bootstrap maybe slow with many segments
+
+struct ShmCatalog::Region {
+    uint64_t magic;         // set by creator after initialized
+    uint32_t capacity;
+    uint32_t count;         // live entries
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;    // broadcast when entry published Ready or erased
+    CatalogEntry entries[CATALOG_CAPACITY];
+};
+
+// @brief robust mutex guard, state made consistent if previous owner died
+class ShmCatalog::LockGuard {
+public:
+    explicit LockGuard(pthread_mutex_t *mutex) : _mutex(mutex) {
+        int ret = pthread_mutex_lock(_mutex);
+        if (ret == EOWNERDEAD) {
+            LEVIN_CWARNING_LOG("catalog lock owner died, recover lock");
+            pthread_mutex_consistent(_mutex);
+        }
+    }
+    ~LockGuard() {
+        pthread_mutex_unlock(_mutex);
+    }
+
+    // @brief wait on cond at most timeout_ms, lock reacquired
+    void wait(pthread_cond_t *cond, uint32_t timeout_ms) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += timeout_ms / 1000;
+        ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000;
+        }
+        if (pthread_cond_timedwait(cond, _mutex, &ts) == EOWNERDEAD) {
+            LEVIN_CWARNING_LOG("catalog lock owner died, recover lock");
+            pthread_mutex_consistent(_mutex);
+        }
+    }
+
+private:
+    pthread_mutex_t *_mutex;
+};
+
+CatalogEntry::CatalogEntry(const std::string &name, const std::string &group_name, int id, int app_id,
+        uint64_t mem_size, uint32_t segment_num) :
+        shmid(id), appid(app_id), version(0), size(mem_size), segments(segment_num),
+        state(CatalogState::Loading), loader_pid(0), hash(0) {
+    strncpy(path, name.c_str(), PATH_LENGTH);
+    path[PATH_LENGTH] = '\0';
+    strncpy(group, group_name.c_str(), GROUP_ID_LENGTH);
+    group[GROUP_ID_LENGTH] = '\0';
+}
+
+ShmCatalog::~ShmCatalog() {
+    if (_region != nullptr) {
+        shmdt(_region);
+        _region = nullptr;
+    }
+}
+
+bool ShmCatalog::open() {
+    for (int retry = 0; retry < 2; ++retry) {
+        _shmid = shmget(CATALOG_KEY, sizeof(Region), IPC_CREAT | IPC_EXCL | 0666);
+        if (_shmid != -1) {
+            return create();
+        }
+        if (errno != EEXIST) {
+            LEVIN_CWARNING_LOG("create shm catalog fail, fallback to scan. errno=%d", errno);
+            return false;
+        }
+        _shmid = shmget(CATALOG_KEY, 0, 0);
+        void *addr = (_shmid == -1 ? (void*)-1 : shmat(_shmid, nullptr, 0));
+        if (addr == (void*)-1) {
+            LEVIN_CWARNING_LOG("attach shm catalog fail, fallback to scan. errno=%d", errno);
+            return false;
+        }
+        _region = static_cast<Region*>(addr);
+        if (wait_ready()) {
+            return true;
+        }
+        shmdt(_region);
+        _region = nullptr;
+        // creator died before catalog initialized, remove and recreate
+        shmid_ds shm_ds;
+        if (shmctl(_shmid, IPC_STAT, &shm_ds) == 0 && kill(shm_ds.shm_cpid, 0) != 0 && errno == ESRCH) {
+            LEVIN_CWARNING_LOG("shm catalog NOT initialized by dead creator, recreate. shmid=%d", _shmid);
+            shmctl(_shmid, IPC_RMID, nullptr);
+            continue;
+        }
+        LEVIN_CWARNING_LOG("shm catalog NOT initialized or mismatched, fallback to scan. shmid=%d", _shmid);
+        return false;
+    }
+    return false;
+}
+
+bool ShmCatalog::create() {
+    void *addr = shmat(_shmid, nullptr, 0);
+    if (addr == (void*)-1) {
+        LEVIN_CWARNING_LOG("attach shm catalog fail, fallback to scan. errno=%d", errno);
+        shmctl(_shmid, IPC_RMID, nullptr);
+        return false;
+    }
+    Region *region = static_cast<Region*>(addr);
+    // new segment zero filled: all entries Free
+    region->capacity = CATALOG_CAPACITY;
+    region->count = 0;
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&region->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&region->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    _region = region;
+    bootstrap();
+    __atomic_store_n(&region->magic, CATALOG_MAGIC, __ATOMIC_RELEASE);
+    LEVIN_CINFO_LOG("shm catalog created. shmid=%d, entries=%u", _shmid, region->count);
+    return true;
+}
+
+bool ShmCatalog::wait_ready() const {
+    for (int i = 0; i < CATALOG_WAIT_MS; ++i) {
+        uint64_t magic = __atomic_load_n(&_region->magic, __ATOMIC_ACQUIRE);
+        if (magic == CATALOG_MAGIC) {
+            return _region->capacity == CATALOG_CAPACITY;
+        }
+        if (magic != 0) {
+            return false;
+        }
+        usleep(1000);
+    }
+    return false;
+}
+
+// @brief levin shm created before catalog, found by scan once
+void ShmCatalog::bootstrap() {
+    std::vector<SharedMidInfo> infos;
+    if (!IdManager::scan_all_shmid(infos, false)) {
+        return;
+    }
+    for (const auto &info : infos) {
+        shmid_ds shm_ds;
+        if (shmctl(info.mid, IPC_STAT, &shm_ds) == -1) {
+            continue;
+        }
+        CatalogEntry entry(info.path, info.groupid, info.mid, info.appid, shm_ds.shm_segsz);
+        entry.state = CatalogState::Ready;
+        Insert(entry);
+    }
+}
+
+uint64_t ShmCatalog::hash(const std::string &path) {
+    // FNV-1a, stable across processes and builds
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : path) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+int64_t ShmCatalog::probe(const std::string &path, uint64_t hash, bool &is_found) const {
+    is_found = false;
+    int64_t reusable = -1;
+    for (uint32_t i = 0; i < CATALOG_CAPACITY; ++i) {
+        uint32_t slot = (hash + i) % CATALOG_CAPACITY;
+        const CatalogEntry &entry = _region->entries[slot];
+        if (entry.state == CatalogState::Free) {
+            return (reusable >= 0 ? reusable : slot);
+        }
+        if (entry.state == CatalogState::Deleted) {
+            if (reusable < 0) {
+                reusable = slot;
+            }
+            continue;
+        }
+        if (entry.hash == hash && path.compare(entry.path) == 0) {
+            is_found = true;
+            return slot;
+        }
+    }
+    return reusable;
+}
+
+void ShmCatalog::write(int64_t slot, const CatalogEntry &entry, uint64_t hash, bool is_found) {
+    // entry published by state at last, slot stays Deleted if writer died in between
+    CatalogEntry tmp = entry;
+    tmp.hash = hash;
+    tmp.state = CatalogState::Deleted;
+    CatalogEntry &dst = _region->entries[slot];
+    dst.state = CatalogState::Deleted;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&dst, &tmp, sizeof(CatalogEntry));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    dst.state = entry.state;
+    if (!is_found) {
+        ++_region->count;
+    }
+}
+
+void ShmCatalog::erase(int64_t slot) {
+    _region->entries[slot].state = CatalogState::Deleted;
+    --_region->count;
+    pthread_cond_broadcast(&_region->cond);
+}
+
+bool ShmCatalog::Insert(const CatalogEntry &entry) {
+    if (_region == nullptr) {
+        return false;
+    }
+    const std::string path(entry.path);
+    const uint64_t h = hash(path);
+    LockGuard guard(&_region->mutex);
+    bool is_found = false;
+    int64_t slot = probe(path, h, is_found);
+    if (slot < 0) {
+        LEVIN_CWARNING_LOG("shm catalog full. capacity=%u, path=%s", CATALOG_CAPACITY, entry.path);
+        return false;
+    }
+    write(slot, entry, h, is_found);
+    return true;
+}
+
+bool ShmCatalog::Erase(const std::string &path, int shmid) {
+    if (_region == nullptr) {
+        return false;
+    }
+    const uint64_t h = hash(path);
+    LockGuard guard(&_region->mutex);
+    bool is_found = false;
+    int64_t slot = probe(path, h, is_found);
+    if (!is_found || _region->entries[slot].shmid != shmid) {
+        return false;
+    }
+    erase(slot);
+    return true;
+}
+
+bool ShmCatalog::Erase(int shmid) {
+    if (_region == nullptr) {
+        return false;
+    }
+    LockGuard guard(&_region->mutex);
+    for (uint32_t i = 0; i < CATALOG_CAPACITY; ++i) {
+        CatalogEntry &entry = _region->entries[i];
+        if (entry.state != CatalogState::Free && entry.state != CatalogState::Deleted && entry.shmid == shmid) {
+            erase(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShmCatalog::Update(const std::string &path, int shmid, CatalogState state, uint64_t version) {
+    if (_region == nullptr) {
+        return false;
+    }
+    const uint64_t h = hash(path);
+    LockGuard guard(&_region->mutex);
+    bool is_found = false;
+    int64_t slot = probe(path, h, is_found);
+    if (!is_found || _region->entries[slot].shmid != shmid) {
+        return false;
+    }
+    _region->entries[slot].version = version;
+    _region->entries[slot].state = state;
+    pthread_cond_broadcast(&_region->cond);
+    return true;
+}
+
+bool ShmCatalog::Find(const std::string &path, CatalogEntry &entry) const {
+    if (_region == nullptr) {
+        return false;
+    }
+    const uint64_t h = hash(path);
+    LockGuard guard(&_region->mutex);
+    bool is_found = false;
+    int64_t slot = probe(path, h, is_found);
+    if (!is_found) {
+        return false;
+    }
+    entry = _region->entries[slot];
+    return true;
+}
+
+bool ShmCatalog::FindById(int shmid, CatalogEntry &entry) const {
+    if (_region == nullptr) {
+        return false;
+    }
+    LockGuard guard(&_region->mutex);
+    for (uint32_t i = 0; i < CATALOG_CAPACITY; ++i) {
+        const CatalogEntry &cur = _region->entries[i];
+        if (cur.state != CatalogState::Free && cur.state != CatalogState::Deleted && cur.shmid == shmid) {
+            entry = cur;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShmCatalog::List(std::vector<CatalogEntry> &entries) const {
+    entries.clear();
+    if (_region == nullptr) {
+        return false;
+    }
+    LockGuard guard(&_region->mutex);
+    entries.reserve(_region->count);
+    for (uint32_t i = 0; i < CATALOG_CAPACITY; ++i) {
+        const CatalogEntry &entry = _region->entries[i];
+        if (entry.state != CatalogState::Free && entry.state != CatalogState::Deleted) {
+            entries.push_back(entry);
+        }
+    }
+    return true;
+}
+
+bool ShmCatalog::is_alive(const CatalogEntry &entry) {
+    shmid_ds shm_ds;
+    return shmctl(entry.shmid, IPC_STAT, &shm_ds) == 0 && (shm_ds.shm_perm.mode & SHM_DEST) == 0;
+}
+
+bool ShmCatalog::is_process_alive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+int ShmCatalog::Acquire(const std::string &path, const CreateFunc &create_func, uint32_t timeout_ms,
+        CatalogEntry &entry, bool &is_loader) {
+    is_loader = false;
+    if (_region == nullptr) {
+        return SC_RET_ERR_SYS;
+    }
+    const uint64_t h = hash(path);
+    const pid_t pid = getpid();
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    LockGuard guard(&_region->mutex);
+    while (true) {
+        bool is_found = false;
+        int64_t slot = probe(path, h, is_found);
+        if (is_found && !is_alive(_region->entries[slot])) {
+            // shm removed out of levin, entry stale
+            erase(slot);
+            slot = probe(path, h, is_found);
+        }
+        if (!is_found) {
+            if (!create_func) {
+                return SC_RET_SHM_NOEXIST;
+            }
+            if (slot < 0) {
+                LEVIN_CWARNING_LOG("shm catalog full. capacity=%u, path=%s", CATALOG_CAPACITY, path.c_str());
+                return SC_RET_ERR_SYS;
+            }
+            CatalogEntry created;
+            int ret = create_func(created);
+            if (ret != SC_RET_OK) {
+                return ret;
+            }
+            created.state = CatalogState::Loading;
+            created.loader_pid = pid;
+            write(slot, created, h, false);
+            entry = _region->entries[slot];
+            is_loader = true;
+            return SC_RET_OK;
+        }
+        CatalogEntry &cur = _region->entries[slot];
+        if (cur.state == CatalogState::Ready || cur.loader_pid == pid) {
+            entry = cur;
+            return SC_RET_OK;
+        }
+        if (!is_process_alive(cur.loader_pid)) {
+            if (!create_func) {
+                return SC_RET_SHM_NOEXIST;
+            }
+            LEVIN_CWARNING_LOG("loader died, take over loading. path=%s, shmid=%d, loader=%d",
+                    path.c_str(), cur.shmid, cur.loader_pid);
+            cur.loader_pid = pid;
+            entry = cur;
+            is_loader = true;
+            return SC_RET_OK;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed_ms >= timeout_ms) {
+            LEVIN_CWARNING_LOG("wait for loading timeout. path=%s, shmid=%d, loader=%d, timeout=%u",
+                    path.c_str(), cur.shmid, cur.loader_pid, timeout_ms);
+            return SC_RET_LOADING;
+        }
+        guard.wait(&_region->cond, std::min<uint64_t>(timeout_ms - elapsed_ms, LOADER_CHECK_MS));
+    }
+}
+
+}  // namespace levin
@@ -0,0 +1,122 @@
+#ifndef LEVIN_SHM_CATALOG_H
+#define LEVIN_SHM_CATALOG_H
+
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <vector>
+#include <functional>
+#include <boost/noncopyable.hpp>
+#include "shared_utils.h"
+
+namespace levin {
+
+// @brief state of container shm in catalog
+enum class CatalogState : uint32_t {
+    Free = 0,       // slot never used
+    Loading,        // shm created, container being loaded
+    Ready,          // container loaded and checked
+    Deleted         // slot of removed shm, probed through by lookup
+};
+
+// @brief catalog entry of one levin shm, keyed by path(shm name)
+struct CatalogEntry {
+    char path[PATH_LENGTH + 1];
+    char group[GROUP_ID_LENGTH + 1];
+    int32_t shmid;
+    int32_t appid;
+    uint64_t version;       // container flags(version), 0 before loaded
+    uint64_t size;          // size of memory region
+    uint32_t segments;      // number of segments, > 1 if SegmentedSharedMemory
+    CatalogState state;
+    int32_t loader_pid;     // process which creates and loads the shm
+    uint64_t hash;          // hash of path
+
+    CatalogEntry() : shmid(-1), appid(0), version(0), size(0), segments(1),
+            state(CatalogState::Free), loader_pid(0), hash(0) {
+        path[0] = '\0';
+        group[0] = '\0';
+    }
+    CatalogEntry(const std::string &name, const std::string &group_name, int id, int app_id,
+            uint64_t mem_size, uint32_t segment_num = 1);
+};
+
+// @brief catalog of levin shm, a System V segment of well-known key shared by all processes
+// lookup by path costs O(1) by open addressing, listing costs no shmat of containers
+// entries updated under a robust process-shared mutex, which is recovered if owner died
+// catalog created with entries of existed levin shm by a scan of all segments, only once per boot
+// load coordination: the first process creates the shm with a Loading entry and loads it,
+// others wait on a process-shared condition until it is published Ready, then attach it
+class ShmCatalog : public boost::noncopyable {
+public:
+    static const key_t CATALOG_KEY = 0x4c564e43;
+    static const uint32_t CATALOG_CAPACITY = 4096;
+
+    // @brief create shm and fill the entry, called under catalog lock
+    // retval succ: SC_RET_OK fail: error code
+    typedef std::function<int(CatalogEntry&)> CreateFunc;
+
+    static ShmCatalog& GetInstance() {
+        static ShmCatalog instance;
+        return instance;
+    }
+
+    // @brief catalog attached and initialized, otherwise callers fallback to scan
+    bool IsValid() const { return _region != nullptr; }
+
+    // @brief insert or replace the entry of the same path
+    // retval succ: true fail: false (Never throws)
+    bool Insert(const CatalogEntry &entry);
+    // @brief mark entry of path&shmid deleted
+    bool Erase(const std::string &path, int shmid);
+    // @brief mark entry of shmid deleted, by a scan of entries
+    bool Erase(int shmid);
+    bool Update(const std::string &path, int shmid, CatalogState state, uint64_t version);
+    bool Find(const std::string &path, CatalogEntry &entry) const;
+    bool FindById(int shmid, CatalogEntry &entry) const;
+    bool List(std::vector<CatalogEntry> &entries) const;
+
+    // @brief find shm of path, or create it by create_func if missing and create_func specified
+    // shm Loading by another alive process is waited until Ready, at most timeout_ms;
+    // shm Loading by a dead process is taken over, entry returned Loading with loader of this process
+    // is_loader means shm created by create_func or taken over, this process should load it
+    // retval succ: SC_RET_OK fail: SC_RET_LOADING(timeout) SC_RET_SHM_NOEXIST(missing, no create_func)
+    //         or error code of create_func (Never throws)
+    int Acquire(const std::string &path, const CreateFunc &create_func, uint32_t timeout_ms,
+            CatalogEntry &entry, bool &is_loader);
+
+    int get_shmid() const { return _shmid; }
+
+private:
+    struct Region;
+    class LockGuard;
+
+    ShmCatalog() {
+        open();
+    }
+    ~ShmCatalog();
+
+    bool open();
+    bool create();
+    bool wait_ready() const;
+    void bootstrap();
+    // @brief slot of path if found, otherwise first reusable slot in probe chain; -1 if full
+    int64_t probe(const std::string &path, uint64_t hash, bool &is_found) const;
+    // @brief write entry to slot, published by state at last
+    void write(int64_t slot, const CatalogEntry &entry, uint64_t hash, bool is_found);
+    void erase(int64_t slot);
+
+    // @brief shm of entry NOT removed
+    static bool is_alive(const CatalogEntry &entry);
+    static bool is_process_alive(pid_t pid);
+
+    static uint64_t hash(const std::string &path);
+
+private:
+    Region *_region = nullptr;
+    int _shmid = -1;
+};
+
+}  // namespace levin
+
+#endif  // LEVIN_SHM_CATALOG_H
@@ -38,6 +38,11 @@ public:
 
     virtual bool Export(const std::string &file) override;
     static bool Dump(const std::string &file, const std::map<Key, Value, Compare> &map);
+    // @brief presorted unique pairs(by Compare of key) of input range or generator written sequentially,
+    // ordering checked on the fly instead of building std::map; fail if NOT strictly ordered
+    template <class InputIt>
+    static bool DumpSorted(const std::string &file, InputIt first, InputIt last);
+    static bool DumpSorted(const std::string &file, const std::function<bool(value_type &kv)> &gen);
 
     bool empty() const { return _object->empty(); }
     size_t size() const { return _object->size(); }
@@ -96,6 +101,29 @@ bool SharedMap<Key, Value, Compare, Mem, CheckFunc>::Dump(
     return SharedVector<value_type>::Dump(file, vec, typeid(container_type).hash_code());
 }
 
+template <class Key, class Value, class Compare, class Mem, class CheckFunc>
+template <class InputIt>
+bool SharedMap<Key, Value, Compare, Mem, CheckFunc>::DumpSorted(
+        const std::string &file, InputIt first, InputIt last) {
+    return DumpSorted(file, [&first, &last](value_type &kv) {
+        if (first == last) {
+            return false;
+        }
+        kv = *first;
+        ++first;
+        return true;
+    });
+}
+
+template <class Key, class Value, class Compare, class Mem, class CheckFunc>
+bool SharedMap<Key, Value, Compare, Mem, CheckFunc>::DumpSorted(
+        const std::string &file, const std::function<bool(value_type &kv)> &gen) {
+    Compare comp;
+    return SharedVector<value_type>::dump_sequence(file, gen,
+            [&comp](const value_type &prev, const value_type &kv) { return comp(prev.first, kv.first); },
+            typeid(container_type).hash_code());
+}
+
 template <class Key, class Value>
 inline std::ostream& operator<<(std::ostream &os, const SharedMap<Key, Value> &map) {
     return os << map.layout();
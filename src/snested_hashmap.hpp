@@ -5,10 +5,14 @@
 #include <unordered_map>
 #include "shared_base.hpp"
 #include "details/nested_hashmap.hpp"
+#include "details/bucket_builder.hpp"
 #include "svec.hpp"
 
 namespace levin {
 
+template <class Key, class Value, class Hash = std::hash<Key> >
+class SharedNestedHashMapBuilder;
+
 template <class Key,
           class Value,
           class Hash = std::hash<Key>,
@@ -36,24 +40,35 @@ public:
             _object(nullptr) {
     }
 
+    // @brief reducer of hash into bucket and layout of records set here if memory region exists, by Load otherwise
     virtual int Init() override {
-        return _init<container_type, Mem>(_object);
+        int ret = _init<container_type, Mem>(_object);
+        return (ret == SC_RET_OK && IsExist() ? _buckets() : ret);
     }
 
     virtual int Load() override {
-        return _load<container_type>(_object);
+        int ret = _load<container_type>(_object);
+        return (ret == SC_RET_OK ? _buckets() : ret);
     }
 
+    // @brief build container straight into memory region from builder, instead of Init&Load of binfile
+    // name is key of memory region(NOT read), region of the same name published before is replaced
+    // records of builder released whether succ or fail
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    int Build(SharedNestedHashMapBuilder<Key, Value, Hash> &builder);
+
     virtual bool Export(const std::string &file) override;
     // @brief T is ordered/unordered KV(V is vector<Elem>) mapper type
     // which SHOULD has the same Key&Elem type with expected SharedNestedHashmap
+    // options: bucket count/load factor, reduction of hash into bucket and layout of records, see BucketOptions
     template <class T,
               typename = typename std::enable_if<
                   std::is_same<typename T::key_type, Key>::value &&
                   std::is_same<typename T::mapped_type::value_type, Value>::value>::type>
-    static bool Dump(const std::string &file, const T &map);
+    static bool Dump(const std::string &file, const T &map, const BucketOptions &options = BucketOptions());
     static bool Dump(
-            const std::string &file, const std::vector<std::pair<Key, std::vector<Value> >> &vec);
+            const std::string &file, const std::vector<std::pair<Key, std::vector<Value> >> &vec,
+            const BucketOptions &options = BucketOptions());
     static bool dump(
             const std::string &file,
             std::vector<std::vector<std::pair<Key, size_t> > > &index,
@@ -64,13 +79,22 @@ public:
     size_t size() const { return _object->size(); }
     size_t bucket_size() const { return _object->bucket_size(); }
 
-    iterator begin() { return _object->begin(); }
-    const_iterator begin() const { return _object->begin(); }
+    iterator begin() { return _object->begin(_layout); }
+    const_iterator begin() const { return _object->begin(_layout); }
     iterator end() { return _object->end(); }
     const_iterator end() const  { return _object->end(); }
 
-    iterator find(Key key) { return _object->find(key); }
-    size_t count(const Key& key) { return _object->count(key); }
+    BucketReduce bucket_reduce() const { return _reducer.reduce(); }
+    BucketLayout bucket_layout() const { return _layout; }
+    iterator find(Key key) { return _object->find(key, _reducer, _layout); }
+    size_t count(const Key& key) { return (find(key) == end() ? 0 : 1); }
+    // @brief n keys found with cache misses overlapped, arrays[i] nullptr if keys[i] NOT found
+    // retval number of keys found
+    size_t find_batch(const Key *keys, size_t n, const data_array_type **arrays) {
+        return _object->find_batch(keys, n, _reducer, arrays, _layout);
+    }
+    // @brief index bucket of key prefetched, eg. for key of next find
+    void prefetch(const Key &key) const { _object->prefetch(key, _reducer); }
     const data_array_type* operator[](const Key& key) { return find(key)->second; }
 
     std::string layout() const {
@@ -95,10 +119,202 @@ public:
         return 0;
     }
 
+private:
+    // @brief reduction and layout of binfile, set when loaded or built
+    // retval succ: SC_RET_OK fail: SC_RET_LOAD_FAIL (Never throws)
+    int _buckets() {
+        int ret = _bucket_reducer(_object->bucket_size(), _reducer);
+        return (ret == SC_RET_OK ? _bucket_layout(_layout) : ret);
+    }
+
 private:
     container_type *_object = nullptr;
+    // @brief hash to bucket by reduction of binfile, set when loaded or built
+    BucketReducer _reducer;
+    BucketLayout _layout = BucketLayout::Pair;
 };
 
+// @brief streaming builder of SharedNestedHashMap binfile, records added one by one
+// index records and value arrays kept flat in blocks, index partitioned into hash buckets in place
+// and written in the layout of SharedNestedHashMap::Dump, so peak memory is ~1x of binfile
+template <class Key, class Value, class Hash>
+class SharedNestedHashMapBuilder {
+public:
+    typedef NestedHashMap<Key, Value, Hash>                container_type;
+    typedef typename container_type::data_impl_type        data_impl_type;
+    typedef typename container_type::index_bucket_type     index_bucket_type;
+    typedef typename container_type::data_array_type       data_array_type;
+    typedef typename container_type::index_value_type      index_value_type;
+    typedef typename container_type::index_value_size_type index_value_size_type;
+    typedef typename container_type::data_value_type       data_value_type;
+    typedef typename container_type::data_value_size_type  data_value_size_type;
+    typedef typename container_type::size_type             size_type;
+
+    explicit SharedNestedHashMapBuilder(const BucketOptions &options = BucketOptions()) : _options(options) {}
+
+    // @brief retval succ: true fail: false, array size exceeds data_value_size_type (Never throws)
+    bool Add(const Key &key, const Value *values, const size_t n) {
+        if (n > std::numeric_limits<data_value_size_type>::max()) {
+            LEVIN_CWARNING_LOG("value array size %lu exceeds size_type numeric limit", n);
+            return false;
+        }
+        _index.push_back(index_value_type(key, _sizes.size()));
+        _sizes.push_back(static_cast<data_value_size_type>(n));
+        _values.append(values, n);
+        return true;
+    }
+    template <class Container>
+    bool Add(const Key &key, const Container &values) {
+        std::vector<Value> buff(values.begin(), values.end());
+        return Add(key, buff.data(), buff.size());
+    }
+    bool Add(const Key &key, const std::vector<Value> &values) {
+        return Add(key, values.data(), values.size());
+    }
+    size_t size() const { return _index.size(); }
+    // @brief bucket count by options, prime ~1x of size by default
+    size_t bucket_count() const {
+        return BucketCountOf(_options, _index.size(), getPrime(_index.size()));
+    }
+
+    // @brief size of container written, without file header
+    size_t container_size() const {
+        return sizeof(container_type) + index_size() + data_size();
+    }
+
+    // @brief write binfile, records released whether succ or fail
+    bool Dump(const std::string &file);
+    // @brief write binfile image by writer, eg. straight into memory region by SharedNestedHashMap::Build
+    // name: binfile or container name for log; records released whether succ or fail
+    bool Write(const std::string &name, BinWriter &writer);
+
+private:
+    // @brief sizeof NestedHashMap contains sizeof index data
+    size_t index_size() const {
+        return bucket_count() * sizeof(index_bucket_type) + _index.size() * sizeof(index_value_type);
+    }
+    size_t data_size() const {
+        return sizeof(data_impl_type) + _index.size() * sizeof(data_array_type) +
+                _values.size() * sizeof(data_value_type);
+    }
+    void clear() {
+        _index.clear();
+        _sizes.clear();
+        _values.clear();
+    }
+
+private:
+    BucketOptions _options;
+    ChunkedArray<index_value_type> _index;
+    ChunkedArray<data_value_size_type> _sizes;
+    ChunkedArray<data_value_type> _values;
+};
+
+template <class Key, class Value, class Hash>
+bool SharedNestedHashMapBuilder<Key, Value, Hash>::Dump(const std::string &file) {
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        clear();
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool ret = Write(file, writer);
+    return (close(fd) == 0) && ret;
+}
+
+template <class Key, class Value, class Hash>
+bool SharedNestedHashMapBuilder<Key, Value, Hash>::Write(const std::string &name, BinWriter &writer) {
+    typedef SharedNestedVector<index_value_type, index_value_size_type> index_vec_type;
+    typedef SharedNestedVector<data_value_type, data_value_size_type> data_vec_type;
+    size_t size = _index.size();
+    size_t bucket_count = this->bucket_count();
+    uint32_t thread_num = DumpThreadNum(size + _values.size());
+    const bool split = (_options.layout == BucketLayout::Split);
+    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld, reduce=%d, layout=%d, thread=%u",
+            name.c_str(), size, bucket_count, (int)_options.reduce, (int)_options.layout, thread_num);
+
+    // write file header: used memory size(meta size + container size)/container type hash
+    size_t type_hash = typeid(container_type).hash_code();
+    SharedFileHeader header = {container_size(), type_hash,
+            makeFlags(SharedBase::SC_VERSION, _options.reduce, _options.layout)};
+    size_type imap_headers[4] = {size, bucket_count, index_size(), data_size()};
+    off_t index_base = sizeof(header) + sizeof(imap_headers);
+    off_t data_base = index_base + index_vec_type::array_offset(bucket_count, size);
+    // split layout: keys of index records from records_base, value array positions from positions_base
+    off_t records_base = index_base + index_vec_type::array_offset(bucket_count, 0);
+    off_t positions_base = records_base + SplitRecords<Key, size_t>::ValuesOffset(size);
+    bool ret = writer.write(&header, sizeof(header), 0) &&
+            writer.write(imap_headers, sizeof(imap_headers), sizeof(header));
+    if (!ret) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+    }
+
+    // value arrays in order of Add, written by ranges of entries
+    const ChunkedArray<data_value_size_type> &sizes = _sizes;
+    auto size_at = [&sizes](size_t i) { return sizes[i]; };
+    const size_t task_rows = DUMP_ELEMS_PER_THREAD;
+    const size_t task_num = (size + task_rows - 1) / task_rows;
+    std::vector<size_t> elem_begins(task_num + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        elem_begins[i / task_rows + 1] += sizes[i];
+    }
+    for (size_t t = 0; t < task_num; ++t) {
+        elem_begins[t + 1] += elem_begins[t];
+    }
+    ret = ret && data_vec_type::write_header(name, writer, data_base, size) &&
+            ParallelRun(task_num, thread_num, [&](size_t t) {
+        size_t row_begin = t * task_rows;
+        size_t row_end = std::min(size, row_begin + task_rows);
+        if (!data_vec_type::write_col_headers(name, writer, data_base, size, row_begin, row_end,
+                    elem_begins[t], size_at) ||
+                !_values.write(writer, data_base + data_vec_type::array_offset(size, elem_begins[t]),
+                    elem_begins[t], elem_begins[t + 1])) {
+            LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+            return false;
+        }
+        return true;
+    });
+
+    // index buckets partitioned and sorted by threads, each range of buckets written at its final position
+    std::vector<uint32_t> counts;
+    Hash hashfun;
+    BucketReducer reducer(_options.reduce, bucket_count);
+    ret = ret && index_vec_type::write_header(name, writer, index_base, bucket_count) &&
+            PartitionBuckets(_index, bucket_count,
+            [&hashfun, &reducer](const index_value_type &kv) { return reducer(hashfun(kv.first)); },
+            CMP<Key, size_t>, thread_num, counts,
+            [&](size_t bucket_begin, size_t bucket_end, size_t record_begin) {
+        size_t record_end = record_begin;
+        for (size_t i = bucket_begin; i < bucket_end; ++i) {
+            record_end += counts[i];
+        }
+        if (!index_vec_type::write_col_headers(name, writer, index_base, bucket_count, bucket_begin, bucket_end,
+                    record_begin, [&counts](size_t i) { return counts[i]; }) ||
+                !(split ? _index.write_split(writer, records_base, positions_base, record_begin, record_end) :
+                    _index.write(writer, index_base + index_vec_type::array_offset(bucket_count, record_begin),
+                        record_begin, record_end))) {
+            LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+            return false;
+        }
+        return true;
+    });
+    if (ret && split && !WriteSplitPadding<Key, size_t>(writer, records_base, size)) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+        ret = false;
+    }
+    clear();
+    return ret;
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+int SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Build(SharedNestedHashMapBuilder<Key, Value, Hash> &builder) {
+    int ret = _build<container_type, Mem>(_object, builder.container_size(), [this, &builder](BinWriter &writer) {
+        return builder.Write(_info->_name, writer);
+    });
+    return (ret == SC_RET_OK ? _buckets() : ret);
+}
+
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 bool SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Export(const std::string &file) {
     return _bin2file(file, container_memsize(this->_object), _object);
@@ -106,49 +322,31 @@ bool SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Export(const std::st
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 template <class T, typename>
-bool SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(const std::string &file, const T &map) {
-    std::ofstream fout(file, std::ios::out | std::ios::binary);
-    if (!fout.is_open()) {
-        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
-        return false;
-    }
+bool SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
+        const std::string &file, const T &map, const BucketOptions &options) {
     // key: hash buckets idx
     // index: [ pair<key, pos> ]
     // data:  [pos ->CustomVector<Value>]
-    size_t bucket_count = getPrime(map.size());
-    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld", file.c_str(), map.size(), bucket_count);
-    std::vector<std::vector<std::pair<Key, size_t> > > idx_datas(
-            bucket_count, std::vector<std::pair<Key, size_t> >());
-    std::vector<std::vector<Value> > value_datas(map.size(), std::vector<Value>());
-    Hash hashfun;
-    size_t pos = 0;
-    for (auto it = map.begin(); it != map.end(); ++it, ++pos) {
-        idx_datas[hashfun(it->first) % bucket_count].emplace_back(std::make_pair(it->first, pos));
-        value_datas[pos].assign(it->second.begin(), it->second.end());
+    SharedNestedHashMapBuilder<Key, Value, Hash> builder(options);
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        if (!builder.Add(it->first, it->second)) {
+            return false;
+        }
     }
-    return SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::dump(file, idx_datas, value_datas, fout);
+    return builder.Dump(file);
 }
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
 bool SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
-        const std::string &file, const std::vector<std::pair<Key, std::vector<Value> > > &vec) {
-    std::ofstream fout(file, std::ios::out | std::ios::binary);
-    if (!fout.is_open()) {
-        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
-        return false;
-    }
-    size_t bucket_count = getPrime(vec.size());
-    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, bucket=%ld", file.c_str(), vec.size(), bucket_count);
-    std::vector<std::vector<std::pair<Key, size_t> > > idx_datas(
-            bucket_count, std::vector<std::pair<Key, size_t> >());
-    std::vector<std::vector<Value> > value_datas(vec.size(), std::vector<Value>());
-    Hash hashfun;
-    size_t pos = 0;
-    for (auto it = vec.begin(); it != vec.end(); ++it, ++pos) {
-        idx_datas[hashfun(it->first) % bucket_count].emplace_back(std::make_pair(it->first, pos));
-        value_datas[pos].assign(it->second.begin(), it->second.end());
+        const std::string &file, const std::vector<std::pair<Key, std::vector<Value> > > &vec,
+        const BucketOptions &options) {
+    SharedNestedHashMapBuilder<Key, Value, Hash> builder(options);
+    for (auto it = vec.begin(); it != vec.end(); ++it) {
+        if (!builder.Add(it->first, it->second)) {
+            return false;
+        }
     }
-    return SharedNestedHashMap<Key, Value, Hash, Mem, CheckFunc>::dump(file, idx_datas, value_datas, fout);
+    return builder.Dump(file);
 }
 
 template <class Key, class Value, class Hash, class Mem, class CheckFunc>
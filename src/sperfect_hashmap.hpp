@@ -0,0 +1,332 @@
+#ifndef LEVIN_SHARED_PERFECT_HASHMAP_H
+#define LEVIN_SHARED_PERFECT_HASHMAP_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "details/perfect_hashmap.hpp"
+#include "details/bucket_builder.hpp"
+#include "shared_base.hpp"
+
+namespace levin {
+
+template <class Key, class Value, class Hash = std::hash<Key> >
+class SharedPerfectHashMapBuilder;
+
+// @brief immutable map of static key set by minimal perfect hash, keys NOT stored
+// ~3 bits per key of index, plus fingerprint bits per key(default 16) to reject absent keys
+// lookup: partition descriptor, pilot, fingerprint and exactly one value access
+template <class Key,
+          class Value,
+          class Hash = std::hash<Key>,
+          class Mem = levin::SharedMemory,
+          class CheckFunc = levin::IntegrityChecker>
+class SharedPerfectHashMap : public SharedBase {
+public:
+    typedef PerfectHashMap<Key, Value, Hash>        container_type;
+    typedef typename container_type::key_type       key_type;
+    typedef typename container_type::mapped_type    mapped_type;
+    typedef typename container_type::size_type      size_type;
+    typedef typename container_type::const_iterator const_iterator;
+
+    SharedPerfectHashMap(const std::string &name, const std::string group = "default", const int id = 1) :
+            SharedBase(name, group, id, CheckFunc()),
+            _object(nullptr) {
+    }
+
+    virtual int Init() override {
+        return _init<container_type, Mem>(_object);
+    }
+
+    virtual int Load() override {
+        return _load<container_type>(_object);
+    }
+
+    // @brief build container straight into memory region from builder, instead of Init&Load of binfile
+    // name is key of memory region(NOT read), region of the same name published before is replaced
+    // records of builder released whether succ or fail
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    int Build(SharedPerfectHashMapBuilder<Key, Value, Hash> &builder);
+
+    virtual bool Export(const std::string &file) override;
+
+    // @brief T is ordered/unordered KV mapper type
+    // which SHOULD has the same Key&Value type with expected SharedPerfectHashMap
+    // fingerprint_bits: 8/16/32, or 0 without fingerprint, absent keys then mapped to value of some key
+    template <class T,
+              typename = typename std::enable_if<
+                  std::is_same<typename T::key_type, Key>::value &&
+                  std::is_same<typename T::mapped_type, Value>::value>::type>
+    static bool Dump(const std::string &file, const T &map, uint32_t fingerprint_bits = 16);
+    // @brief keys MUST be distinct
+    static bool Dump(const std::string &file, const std::vector<std::pair<Key, Value> > &vec,
+            uint32_t fingerprint_bits = 16);
+
+    bool empty() const { return _object->empty(); }
+    size_t size() const { return _object->size(); }
+    uint32_t fingerprint_bits() const { return _object->fingerprint_bits(); }
+    double bits_per_key() const { return _object->bits_per_key(); }
+    // @brief value of key, nullptr if key rejected by fingerprint
+    const Value* find(const Key &key) const { return _object->find(key); }
+    size_t count(const Key &key) const { return _object->count(key); }
+    // @brief index of key in value array, for any key
+    size_t index(const Key &key) const { return _object->index(key); }
+    // @brief mybe THROW out_of_range if key rejected by fingerprint
+    const Value& operator[](const Key &key) const { return _object->at(key); }
+    const Value& at(const Key &key) const { return _object->at(key); }
+    // @brief values in order of index
+    const_iterator begin() const { return _object->begin(); }
+    const_iterator end() const { return _object->end(); }
+
+    std::string layout() const;
+
+private:
+    container_type *_object = nullptr;
+};
+
+// @brief builder of SharedPerfectHashMap binfile, records added one by one
+// records partitioned by hash and minimal perfect hash of each partition built by a pool of threads,
+// written at final positions; layout is the same whatever threads
+template <class Key, class Value, class Hash>
+class SharedPerfectHashMapBuilder {
+public:
+    typedef PerfectHashMap<Key, Value, Hash> container_type;
+    struct Record {
+        uint64_t hash;
+        Value value;
+    };
+
+    explicit SharedPerfectHashMapBuilder(uint32_t fingerprint_bits = 16) : _fingerprint_bits(fingerprint_bits) {}
+
+    void Add(const Key &key, const Value &value) {
+        Record record = {container_type::KeyHash(key), value};
+        _records.push_back(record);
+    }
+    size_t size() const { return _records.size(); }
+
+    // @brief size of container written, without file header
+    size_t container_size() const {
+        std::vector<uint64_t> sizes;
+        size_t pilot_count = 0;
+        size_t free_count = 0;
+        _partition_sizes(sizes, pilot_count, free_count);
+        container_type object(_records.size(), sizes.size(), pilot_count, free_count, _fingerprint_bits);
+        return object.memsize();
+    }
+
+    // @brief write binfile, records released whether succ or fail
+    bool Dump(const std::string &file);
+    // @brief write binfile image by writer, eg. straight into memory region by SharedPerfectHashMap::Build
+    // name: binfile or container name for log; records released whether succ or fail
+    bool Write(const std::string &name, BinWriter &writer);
+
+private:
+    size_t _partition_count() const { return _records.size() / PERFECT_PARTITION_KEYS + 1; }
+    // @brief sizes: keys of each partition, with pilots and free slots of all partitions
+    void _partition_sizes(std::vector<uint64_t> &sizes, size_t &pilot_count, size_t &free_count) const;
+    bool _write(const std::string &name, BinWriter &writer);
+
+private:
+    uint32_t _fingerprint_bits;
+    ChunkedArray<Record> _records;
+};
+
+template <class Key, class Value, class Hash>
+void SharedPerfectHashMapBuilder<Key, Value, Hash>::_partition_sizes(
+        std::vector<uint64_t> &sizes, size_t &pilot_count, size_t &free_count) const {
+    const size_t size = _records.size();
+    const size_t part_num = _partition_count();
+    uint32_t thread_num = DumpThreadNum(size);
+    size_t range_len = (size + thread_num - 1) / thread_num;
+    std::vector<std::vector<uint64_t> > histograms(thread_num, std::vector<uint64_t>(part_num, 0));
+    ParallelRun(thread_num, thread_num, [&](size_t r) {
+        for (size_t i = r * range_len; i < std::min(size, (r + 1) * range_len); ++i) {
+            ++histograms[r][FastRange64(_records[i].hash, part_num)];
+        }
+        return true;
+    });
+    sizes.assign(part_num, 0);
+    pilot_count = 0;
+    free_count = 0;
+    for (size_t p = 0; p < part_num; ++p) {
+        for (uint32_t r = 0; r < thread_num; ++r) {
+            sizes[p] += histograms[r][p];
+        }
+        pilot_count += PerfectKeyHash::BucketCount(sizes[p]);
+        free_count += PerfectKeyHash::TableSize(sizes[p]) - sizes[p];
+    }
+}
+
+template <class Key, class Value, class Hash>
+bool SharedPerfectHashMapBuilder<Key, Value, Hash>::Dump(const std::string &file) {
+    int fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        _records.clear();
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool ret = Write(file, writer);
+    return (close(fd) == 0) && ret;
+}
+
+template <class Key, class Value, class Hash>
+bool SharedPerfectHashMapBuilder<Key, Value, Hash>::Write(const std::string &name, BinWriter &writer) {
+    bool ret = _write(name, writer);
+    _records.clear();
+    return ret;
+}
+
+template <class Key, class Value, class Hash>
+bool SharedPerfectHashMapBuilder<Key, Value, Hash>::_write(const std::string &name, BinWriter &writer) {
+    if (!container_type::ValidFingerprintBits(_fingerprint_bits) || _records.size() > UINT32_MAX * 0.99) {
+        LEVIN_CWARNING_LOG("invalid fingerprint bits or too many keys. file=%s, fingerprint bits=%u, size=%lu",
+                name.c_str(), _fingerprint_bits, _records.size());
+        return false;
+    }
+    std::vector<uint64_t> sizes;
+    size_t pilot_count = 0;
+    size_t free_count = 0;
+    _partition_sizes(sizes, pilot_count, free_count);
+    const size_t part_num = sizes.size();
+    const container_type object(_records.size(), part_num, pilot_count, free_count, _fingerprint_bits);
+    const size_t fp_bytes = _fingerprint_bits / 8;
+    uint32_t thread_num = DumpThreadNum(_records.size());
+    LEVIN_CDEBUG_LOG("Dump file=%s, size=%ld, partition=%ld, thread=%u",
+            name.c_str(), object.size(), part_num, thread_num);
+
+    // write file header: used memory size(meta size + container size)/container type hash
+    size_t type_hash = typeid(container_type).hash_code();
+    SharedFileHeader header = {object.memsize(), type_hash, makeFlags(SharedBase::SC_VERSION)};
+    const off_t base = sizeof(header);
+    std::vector<PerfectPartition> parts(part_num);
+    uint64_t key_begin = 0;
+    uint64_t pilot_begin = 0;
+    uint64_t free_begin = 0;
+    for (size_t p = 0; p < part_num; ++p) {
+        PerfectPartition part = {key_begin, pilot_begin, free_begin, sizes[p]};
+        parts[p] = part;
+        key_begin += sizes[p];
+        pilot_begin += PerfectKeyHash::BucketCount(sizes[p]);
+        free_begin += PerfectKeyHash::TableSize(sizes[p]) - sizes[p];
+    }
+    // padding of arrays aligned, written as zero
+    const char zeros[8] = {0};
+    bool ret = writer.write(&header, sizeof(header), 0) &&
+            writer.write(&object, sizeof(object), base) &&
+            writer.write(parts.data(), sizeof(PerfectPartition) * part_num, base + sizeof(object)) &&
+            writer.write(zeros, object.free_offset() - object.pilots_offset() - sizeof(uint16_t) * pilot_begin,
+                    base + object.pilots_offset() + sizeof(uint16_t) * pilot_begin) &&
+            writer.write(zeros, object.fingerprints_offset() - object.free_offset() - sizeof(uint32_t) * free_begin,
+                    base + object.free_offset() + sizeof(uint32_t) * free_begin) &&
+            writer.write(zeros, object.values_offset() - object.fingerprints_offset() - fp_bytes * key_begin,
+                    base + object.fingerprints_offset() + fp_bytes * key_begin);
+    if (!ret) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+        return false;
+    }
+    // records partitioned and sorted by hash, perfect hash of partitions built by threads
+    std::vector<uint32_t> counts;
+    return PartitionBuckets(_records, part_num,
+            [part_num](const Record &record) { return FastRange64(record.hash, part_num); },
+            [](const Record &a, const Record &b) { return a.hash < b.hash; }, thread_num, counts,
+            [&](size_t part_begin, size_t part_end, size_t record_begin) {
+        std::vector<uint64_t> hashes;
+        std::vector<uint16_t> pilots;
+        std::vector<uint32_t> free;
+        std::vector<uint32_t> indexes;
+        std::vector<Value> values;
+        std::vector<char> fps;
+        size_t r = record_begin;
+        for (size_t p = part_begin; p < part_end; ++p) {
+            const PerfectPartition &part = parts[p];
+            hashes.resize(part.size);
+            for (size_t i = 0; i < part.size; ++i) {
+                hashes[i] = _records[r + i].hash;
+                if (i > 0 && hashes[i] == hashes[i - 1]) {
+                    LEVIN_CWARNING_LOG("duplicated key or hash of key. file=%s", name.c_str());
+                    return false;
+                }
+            }
+            if (!container_type::BuildPartition(hashes, pilots, free, indexes)) {
+                LEVIN_CWARNING_LOG("perfect hash of partition NOT built. file=%s, partition=%lu", name.c_str(), p);
+                return false;
+            }
+            values.resize(part.size);
+            fps.resize(fp_bytes * part.size);
+            for (size_t i = 0; i < part.size; ++i) {
+                values[indexes[i]] = _records[r + i].value;
+                uint32_t fp = container_type::Fingerprint(PerfectKeyHash(hashes[i]));
+                memcpy(&fps[fp_bytes * indexes[i]], &fp, fp_bytes);
+            }
+            if (!writer.write(pilots.data(), sizeof(uint16_t) * pilots.size(),
+                        base + object.pilots_offset() + sizeof(uint16_t) * part.pilot_begin) ||
+                    !writer.write(free.data(), sizeof(uint32_t) * free.size(),
+                        base + object.free_offset() + sizeof(uint32_t) * part.free_begin) ||
+                    !writer.write(fps.data(), fps.size(),
+                        base + object.fingerprints_offset() + fp_bytes * part.key_begin) ||
+                    !writer.write(values.data(), sizeof(Value) * values.size(),
+                        base + object.values_offset() + sizeof(Value) * part.key_begin)) {
+                LEVIN_CWARNING_LOG("write file fail. file=%s", name.c_str());
+                return false;
+            }
+            r += part.size;
+        }
+        return true;
+    });
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+int SharedPerfectHashMap<Key, Value, Hash, Mem, CheckFunc>::Build(
+        SharedPerfectHashMapBuilder<Key, Value, Hash> &builder) {
+    return _build<container_type, Mem>(_object, builder.container_size(), [this, &builder](BinWriter &writer) {
+        return builder.Write(_info->_name, writer);
+    });
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+bool SharedPerfectHashMap<Key, Value, Hash, Mem, CheckFunc>::Export(const std::string &file) {
+    return _bin2file(file, container_memsize(_object), _object);
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+template <class T, typename>
+bool SharedPerfectHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
+        const std::string &file, const T &map, uint32_t fingerprint_bits) {
+    SharedPerfectHashMapBuilder<Key, Value, Hash> builder(fingerprint_bits);
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        builder.Add(it->first, it->second);
+    }
+    return builder.Dump(file);
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+bool SharedPerfectHashMap<Key, Value, Hash, Mem, CheckFunc>::Dump(
+        const std::string &file, const std::vector<std::pair<Key, Value> > &vec, uint32_t fingerprint_bits) {
+    SharedPerfectHashMapBuilder<Key, Value, Hash> builder(fingerprint_bits);
+    for (const auto &kv : vec) {
+        builder.Add(kv.first, kv.second);
+    }
+    return builder.Dump(file);
+}
+
+template <class Key, class Value, class Hash, class Mem, class CheckFunc>
+std::string SharedPerfectHashMap<Key, Value, Hash, Mem, CheckFunc>::layout() const {
+    std::stringstream ss;
+    ss << "SharedPerfectHashMap this=[" << (void*)this << "]";
+    if (_info->_meta != nullptr) {
+        ss << std::endl << *_info->_meta;
+    }
+    if (_info->_header != nullptr) {
+        ss << std::endl << *_info->_header;
+    }
+    if (_object != nullptr) {
+        ss << std::endl << _object->layout();
+    }
+    return ss.str();
+}
+
+}  // namespace levin
+
+#endif  // LEVIN_SHARED_PERFECT_HASHMAP_H
@@ -35,6 +35,11 @@ public:
 
     virtual bool Export(const std::string &file) override;
     static bool Dump(const std::string &file, const std::set<Key, Compare> &st);
+    // @brief presorted unique keys(by Compare) of input range or generator written sequentially,
+    // ordering checked on the fly instead of building std::set; fail if NOT strictly ordered
+    template <class InputIt>
+    static bool DumpSorted(const std::string &file, InputIt first, InputIt last);
+    static bool DumpSorted(const std::string &file, const std::function<bool(value_type &key)> &gen);
 
     bool empty() const { return _object->empty(); }
     size_t size() const { return _object->size(); }
@@ -69,6 +74,29 @@ bool SharedSet<Key, Compare, Mem, CheckFunc>::Dump(
     return SharedVector<value_type>::Dump(file, vec, typeid(container_type).hash_code());
 }
 
+template <class Key, class Compare, class Mem, class CheckFunc>
+template <class InputIt>
+bool SharedSet<Key, Compare, Mem, CheckFunc>::DumpSorted(
+        const std::string &file, InputIt first, InputIt last) {
+    return DumpSorted(file, [&first, &last](value_type &key) {
+        if (first == last) {
+            return false;
+        }
+        key = *first;
+        ++first;
+        return true;
+    });
+}
+
+template <class Key, class Compare, class Mem, class CheckFunc>
+bool SharedSet<Key, Compare, Mem, CheckFunc>::DumpSorted(
+        const std::string &file, const std::function<bool(value_type &key)> &gen) {
+    Compare comp;
+    return SharedVector<value_type>::dump_sequence(file, gen,
+            [&comp](const value_type &prev, const value_type &key) { return comp(prev, key); },
+            typeid(container_type).hash_code());
+}
+
 template <class Key, class Compare, class Mem, class CheckFunc>
 std::string SharedSet<Key, Compare, Mem, CheckFunc>::layout() const {
     std::stringstream ss;
@@ -1,9 +1,12 @@
 #ifndef LEVIN_SHARED_VECTOR_H
 #define LEVIN_SHARED_VECTOR_H
 
+#include <fcntl.h>
 #include <iostream>
 #include "shared_base.hpp"
 #include "details/vector.hpp"
+#include "bin_writer.h"
+#include "parallel_utils.h"
 
 namespace levin {
 
@@ -46,10 +49,26 @@ public:
         return ret;
     }
 
+    // @brief build container straight into memory region from vec, instead of Init&Load of binfile
+    // name is key of memory region(NOT read), region of the same name published before is replaced
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    int Build(const std::vector<T> &vec);
+
     virtual bool Export(const std::string &file) override;
     static bool Dump(const std::string &file, const std::vector<T> &vec, uint64_t type = 0);
+    // @brief generator of elements: retval true with next element set, false at end
+    typedef std::function<bool(T &elem)> Generator;
+    // @brief elements of input range or generator written sequentially by a bounded buffer,
+    // no vector materialized; header written after all elements counted
+    template <class InputIt>
+    static bool Dump(const std::string &file, InputIt first, InputIt last, uint64_t type = 0);
+    static bool Dump(const std::string &file, const Generator &gen, uint64_t type = 0);
     // for combination container
     static bool dump(const std::string &file, const std::vector<T> &vec, std::ofstream &fout);
+    // @brief elements by next written sequentially, is_ordered(prev, elem) checked on the fly
+    // file removed if any element NOT ordered
+    template <class Next, class Ordered>
+    static bool dump_sequence(const std::string &file, Next next, Ordered is_ordered, uint64_t type);
 
     bool empty() const { return _size == 0; }
     size_t size() const { return _size; }
@@ -108,15 +127,55 @@ public:
             SharedVector<CustomVector<T, SizeType>, Mem, CheckFunc>(name, group, id) {
     }
 
+    // @brief build container straight into memory region from vec, instead of Init&Load of binfile
+    // retval succ: SC_RET_OK fail: error code (Never throws)
+    int Build(const std::vector<std::vector<T> > &vec);
+
     virtual bool Export(const std::string &file) override;
     static bool Dump(
             const std::string &file, const std::vector<std::vector<T> > &vec, uint64_t type = 0);
     // for combination container eg. hashmap
     static bool dump(
             const std::string &file, const std::vector<std::vector<T> > &vec, std::ofstream &fout);
+
+    // @brief file offset of column array element elem_idx, relative to nested vector of row_size rows
+    static size_t array_offset(const size_t row_size, const size_t elem_idx) {
+        return sizeof(container_type) + sizeof(row_value_type) * row_size + sizeof(col_value_type) * elem_idx;
+    }
+    // @brief write rows of vec at binfile offset base, ranges of rows written by a pool of threads
+    static bool write(const std::string &file, const std::vector<std::vector<T> > &vec,
+            BinWriter &writer, off_t base);
+    // @brief write customvector header of row_size rows at binfile offset base
+    static bool write_header(const std::string &file, BinWriter &writer, off_t base, const size_t row_size);
+    // @brief write column headers of rows [row_begin, row_end) at file offset base, row i has size_at(i)
+    // elements, and elem_begin elements in rows before row_begin; disjoint ranges of rows written by threads,
+    // column arrays written by caller at array_offset, eg. from a flat buffer of rows
+    template <class SizeAt>
+    static bool write_col_headers(const std::string &file, BinWriter &writer, off_t base, const size_t row_size,
+            const size_t row_begin, const size_t row_end, const size_t elem_begin, const SizeAt &size_at);
     std::string layout() const;
 };
 
+template <class T, class Mem, class CheckFunc>
+int SharedVector<T, Mem, CheckFunc>::Build(const std::vector<T> &vec) {
+    size_t container_size = sizeof(container_type) + vec.size() * sizeof(value_type);
+    int ret = _build<container_type, Mem>(_object, container_size, [&](BinWriter &writer) {
+        // file header, customvector header: size/offset, array
+        SharedFileHeader header = {
+            container_size, typeid(container_type).hash_code(), makeFlags(SharedBase::SC_VERSION)};
+        size_type headers[2] = {vec.size(), sizeof(container_type)};
+        return writer.write(&header, sizeof(header), 0) &&
+                writer.write(headers, sizeof(headers), sizeof(header)) &&
+                writer.write(vec.data(), sizeof(value_type) * vec.size(), sizeof(header) + sizeof(headers));
+    });
+    if (ret == SC_RET_OK) {
+        _size = _object->size();
+        _array = _object->_array();
+        _end = _array + _size;
+    }
+    return ret;
+}
+
 template <class T, class Mem, class CheckFunc>
 bool SharedVector<T, Mem, CheckFunc>::Export(const std::string &file) {
     return this->_bin2file(file, container_memsize(_object), _object);
@@ -143,6 +202,79 @@ bool SharedVector<T, Mem, CheckFunc>::Dump(
     return SharedVector<value_type>::dump(file, vec, fout);
 }
 
+template <class T, class Mem, class CheckFunc>
+template <class InputIt>
+bool SharedVector<T, Mem, CheckFunc>::Dump(
+        const std::string &file, InputIt first, InputIt last, uint64_t type) {
+    return dump_sequence(file, [&first, &last](T &elem) {
+        if (first == last) {
+            return false;
+        }
+        elem = *first;
+        ++first;
+        return true;
+    }, [](const T&, const T&) { return true; }, type);
+}
+
+template <class T, class Mem, class CheckFunc>
+bool SharedVector<T, Mem, CheckFunc>::Dump(const std::string &file, const Generator &gen, uint64_t type) {
+    return dump_sequence(file, gen, [](const T&, const T&) { return true; }, type);
+}
+
+template <class T, class Mem, class CheckFunc>
+template <class Next, class Ordered>
+bool SharedVector<T, Mem, CheckFunc>::dump_sequence(
+        const std::string &file, Next next, Ordered is_ordered, uint64_t type) {
+    std::ofstream fout(file, std::ios::out | std::ios::binary);
+    if (!fout.is_open()) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        return false;
+    }
+    // file header and customvector header: size/offset, rewritten after all elements counted
+    SharedFileHeader header = {0, (type == 0 ? typeid(container_type).hash_code() : type),
+        makeFlags(SharedBase::SC_VERSION)};
+    size_type headers[2] = {0, sizeof(container_type)};
+    fout.write((const char*)&header, sizeof(header));
+    fout.write((const char*)headers, sizeof(headers));
+
+    static const size_t buff_size_limit = (1UL << 20) / sizeof(value_type) + 1;
+    std::vector<T> buff;
+    buff.reserve(buff_size_limit);
+    T elem = T();
+    T prev = T();
+    size_t size = 0;
+    bool is_sorted = true;
+    while (fout && next(elem)) {
+        if (size > 0 && !is_ordered(prev, elem)) {
+            LEVIN_CWARNING_LOG("element %lu NOT ordered, write file fail. file=%s", size, file.c_str());
+            is_sorted = false;
+            break;
+        }
+        prev = elem;
+        buff.push_back(elem);
+        ++size;
+        if (buff.size() == buff_size_limit) {
+            fout.write((const char*)buff.data(), sizeof(value_type) * buff.size());
+            buff.clear();
+        }
+    }
+    fout.write((const char*)buff.data(), sizeof(value_type) * buff.size());
+    header.container_size = sizeof(container_type) + size * sizeof(value_type);
+    headers[0] = size;
+    fout.seekp(0);
+    fout.write((const char*)&header, sizeof(header));
+    fout.write((const char*)headers, sizeof(headers));
+    fout.close();
+    if (!is_sorted || !fout) {
+        if (is_sorted) {
+            LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
+        }
+        unlink(file.c_str());
+        return false;
+    }
+    return true;
+}
+
 template <class T, class Mem, class CheckFunc>
 bool SharedVector<T, Mem, CheckFunc>::dump(
         const std::string &file, const std::vector<T> &vec, std::ofstream &fout) {
@@ -188,6 +320,27 @@ std::string SharedVector<T, Mem, CheckFunc>::layout() const {
     return ss.str();
 }
 
+template <class T, class SizeType, class Mem, class CheckFunc>
+int SharedNestedVector<T, SizeType, Mem, CheckFunc>::Build(const std::vector<std::vector<T> > &vec) {
+    size_t container_size = sizeof(container_type);
+    for (auto &row : vec) {
+        container_size += sizeof(row_value_type);
+        container_size += row.size() * sizeof(col_value_type);
+    }
+    int ret = this->template _build<container_type, Mem>(this->_object, container_size, [&](BinWriter &writer) {
+        SharedFileHeader header = {
+            container_size, typeid(container_type).hash_code(), makeFlags(SharedBase::SC_VERSION)};
+        return writer.write(&header, sizeof(header), 0) &&
+                write(this->_info->_name, vec, writer, sizeof(header));
+    });
+    if (ret == SC_RET_OK) {
+        this->_size = this->_object->size();
+        this->_array = this->_object->_array();
+        this->_end = this->_array + this->_size;
+    }
+    return ret;
+}
+
 template <class T, class SizeType, class Mem, class CheckFunc>
 bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::Export(const std::string &file) {
     return this->_bin2file(file, container_memsize(this->_object), this->_object);
@@ -220,53 +373,121 @@ bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::Dump(
 template <class T, class SizeType, class Mem, class CheckFunc>
 bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::dump(
         const std::string &file, const std::vector<std::vector<T> > &vec, std::ofstream &fout) {
+    // rows written with pwrite at their final positions, after what written by fout
+    fout.flush();
+    off_t base = fout.tellp();
+    if (!fout || base < 0) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
+        return false;
+    }
+    int fd = open(file.c_str(), O_WRONLY);
+    if (fd < 0) {
+        LEVIN_CWARNING_LOG("open file for write fail. file=%s", file.c_str());
+        return false;
+    }
+    FileBinWriter writer(fd);
+    bool succ = write(file, vec, writer, base);
+    close(fd);
+    size_t elem_size = 0;
+    for (const auto &row : vec) {
+        elem_size += row.size();
+    }
+    fout.seekp(base + array_offset(vec.size(), elem_size));
+    return succ && fout;
+}
+
+template <class T, class SizeType, class Mem, class CheckFunc>
+bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::write(
+        const std::string &file, const std::vector<std::vector<T> > &vec, BinWriter &writer, off_t base) {
+    const size_t row_size = vec.size();
+    const size_t task_rows = DUMP_ELEMS_PER_THREAD;
+    const size_t task_num = (row_size + task_rows - 1) / task_rows;
+    std::vector<size_t> elem_begins(task_num + 1, 0);
+    for (size_t i = 0; i < row_size; ++i) {
+        elem_begins[i / task_rows + 1] += vec[i].size();
+    }
+    for (size_t t = 0; t < task_num; ++t) {
+        elem_begins[t + 1] += elem_begins[t];
+    }
+    const size_t elem_size = elem_begins[task_num];
+    auto size_at = [&vec](size_t i) { return vec[i].size(); };
+    return write_header(file, writer, base, row_size) &&
+            ParallelRun(task_num, DumpThreadNum(row_size + elem_size), [&](size_t t) {
+        size_t row_begin = t * task_rows;
+        size_t row_end = std::min(row_size, row_begin + task_rows);
+        if (!write_col_headers(file, writer, base, row_size, row_begin, row_end, elem_begins[t], size_at)) {
+            return false;
+        }
+        // column arrays of small rows gathered, written by large write
+        static const size_t buff_size_limit = (1UL << 20) / sizeof(col_value_type) + 1;
+        std::vector<col_value_type> buff;
+        off_t offset = base + array_offset(row_size, elem_begins[t]);
+        for (size_t i = row_begin; i < row_end; ++i) {
+            buff.insert(buff.end(), vec[i].begin(), vec[i].end());
+            if (buff.size() >= buff_size_limit || i + 1 == row_end) {
+                if (!writer.write(buff.data(), sizeof(col_value_type) * buff.size(), offset)) {
+                    LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
+                    return false;
+                }
+                offset += sizeof(col_value_type) * buff.size();
+                buff.clear();
+            }
+        }
+        return true;
+    });
+}
+
+template <class T, class SizeType, class Mem, class CheckFunc>
+bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::write_header(
+        const std::string &file, BinWriter &writer, off_t base, const size_t row_size) {
     static const size_t row_size_limit = std::numeric_limits<row_size_type>::max();
-    static const size_t col_size_limit = std::numeric_limits<col_size_type>::max();
     static const size_t fix_row_offset = sizeof(container_type);
-    static const size_t fix_col_offset = sizeof(row_value_type);
-
     // write customvector header: size/offset
-    size_t row_size = vec.size();
     if (fix_row_offset > row_size_limit || row_size > row_size_limit) {
         LEVIN_CWARNING_LOG("column size/offset exceed size_type(%s) numeric limit, "
                 "write file fail. file=%s",
                 demangle(typeid(row_size_type).name()).c_str(), file.c_str());
         return false;
     }
-    std::vector<row_size_type> row_headers = {
+    row_size_type row_headers[2] = {
         static_cast<row_size_type>(row_size), static_cast<row_size_type>(fix_row_offset)};
-    fout.write((const char*)row_headers.data(), sizeof(row_size_type) * row_headers.size());
-    if (!fout) {
+    if (!writer.write(row_headers, sizeof(row_headers), base)) {
         LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
         return false;
     }
+    return true;
+}
 
-    // write column header
-    size_t cur_offset = fix_col_offset * row_size;
-    for (size_t i = 0; i < row_size; ++i) {
-        size_t col_size = vec[i].size();
+template <class T, class SizeType, class Mem, class CheckFunc>
+template <class SizeAt>
+bool SharedNestedVector<T, SizeType, Mem, CheckFunc>::write_col_headers(
+        const std::string &file, BinWriter &writer, off_t base, const size_t row_size,
+        const size_t row_begin, const size_t row_end, const size_t elem_begin, const SizeAt &size_at) {
+    static const size_t col_size_limit = std::numeric_limits<col_size_type>::max();
+    static const size_t fix_col_offset = sizeof(row_value_type);
+    if (row_begin >= row_end) {
+        return true;
+    }
+    // offset of column array relative to its column header
+    size_t cur_offset = fix_col_offset * (row_size - row_begin) + sizeof(col_value_type) * elem_begin;
+    std::vector<col_size_type> col_headers;
+    col_headers.reserve((row_end - row_begin) * 2);
+    for (size_t i = row_begin; i < row_end; ++i) {
+        size_t col_size = size_at(i);
         if (cur_offset > col_size_limit || col_size > col_size_limit) {
             LEVIN_CWARNING_LOG("column size/offset exceed size_type(%s) numeric limit, "
                     "write file fail. file=%s",
                     demangle(typeid(col_size_type).name()).c_str(), file.c_str());
             return false;
         }
-        std::vector<col_size_type> col_headers = {
-            static_cast<col_size_type>(col_size), static_cast<col_size_type>(cur_offset)};
-        fout.write((const char*)col_headers.data(), sizeof(col_size_type) * col_headers.size());
-        if (!fout) {
-            LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
-            return false;
-        }
+        col_headers.push_back(static_cast<col_size_type>(col_size));
+        col_headers.push_back(static_cast<col_size_type>(cur_offset));
         cur_offset += col_size * sizeof(col_value_type) - fix_col_offset;
     }
-    // write column array
-    for (size_t i = 0; i < row_size; ++i) {
-        fout.write((const char*)vec[i].data(), sizeof(col_value_type) * vec[i].size());
-        if (!fout) {
-            LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
-            return false;
-        }
+    if (!writer.write(col_headers.data(), sizeof(col_size_type) * col_headers.size(),
+                base + sizeof(container_type) + fix_col_offset * row_begin)) {
+        LEVIN_CWARNING_LOG("write file fail. file=%s", file.c_str());
+        return false;
     }
     return true;
 }
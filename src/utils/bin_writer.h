@@ -0,0 +1,75 @@
+#ifndef LEVIN_BIN_WRITER_H
+#define LEVIN_BIN_WRITER_H
+
+#include <string.h>
+#include <sys/types.h>
+#include <cstddef>
+#include <algorithm>
+#include "levin_logger.h"
+#include "shared_utils.h"
+#include "file_loader.h"
+
+namespace levin {
+
+// @brief positional writer of binfile image: file header followed by container
+// image written to a binfile, or straight into memory region of container without binfile
+class BinWriter {
+public:
+    virtual ~BinWriter() {
+    }
+    // @brief write len bytes at binfile offset, called concurrently on disjoint ranges
+    // retval succ: true fail: false (Never throws)
+    virtual bool write(const void *buf, size_t len, off_t offset) = 0;
+};
+
+// @brief binfile written by pwrite, fd owned by caller
+class FileBinWriter : public BinWriter {
+public:
+    explicit FileBinWriter(int fd) : _fd(fd) {
+    }
+    virtual bool write(const void *buf, size_t len, off_t offset) override {
+        return PwriteFull(_fd, buf, len, offset);
+    }
+
+private:
+    int _fd;
+};
+
+// @brief binfile image written into memory region, as if loaded from binfile
+// file header and container are NOT adjacent in memory region
+class RegionBinWriter : public BinWriter {
+public:
+    RegionBinWriter(void *header, void *container, size_t container_size) :
+            _header((char*)header), _container((char*)container), _container_size(container_size) {
+    }
+    virtual bool write(const void *buf, size_t len, off_t offset) override {
+        const size_t header_size = sizeof(SharedFileHeader);
+        size_t pos = offset;
+        if (offset < 0 || pos + len > header_size + _container_size) {
+            LEVIN_CWARNING_LOG("write out of region. offset=%ld, len=%lu, container size=%lu",
+                    offset, len, _container_size);
+            return false;
+        }
+        const char *src = (const char*)buf;
+        if (pos < header_size) {
+            size_t header_len = std::min(len, header_size - pos);
+            memcpy(_header + pos, src, header_len);
+            pos += header_len;
+            src += header_len;
+            len -= header_len;
+        }
+        if (len > 0) {
+            memcpy(_container + (pos - header_size), src, len);
+        }
+        return true;
+    }
+
+private:
+    char *_header;
+    char *_container;
+    size_t _container_size;
+};
+
+}  // namespace levin
+
+#endif  // LEVIN_BIN_WRITER_H
@@ -1,42 +1,131 @@
 #include "check_file.h"
-#include <fstream>
+#include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <unistd.h>
-#include "openssl/md5.h"
+#include <sys/stat.h>
+#include <fstream>
+#include <vector>
 #include "levin_logger.h"
 
 namespace levin {
 
-bool GetFileMD5(const std::string& file_name, std::string& md5) {
-    int fd = open(file_name.c_str(), O_RDONLY);
+bool Md5Digest::UpdateFromFile(const std::string &file, off_t offset) {
+    int fd = open(file.c_str(), O_RDONLY);
     if (fd < 0) {
         return false;
     }
+    // large buffer, a few syscalls per MB instead of one per 4KB
+    const size_t MD5_BUFF_SIZE = 1UL << 20;
+    std::vector<char> buff(MD5_BUFF_SIZE);
+    ssize_t bytes = 0;
+    while ((bytes = pread(fd, buff.data(), MD5_BUFF_SIZE, offset)) != 0) {
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0) {
+            LEVIN_CWARNING_LOG("read file for md5 fail. file=%s, offset=%ld, errno=%d",
+                    file.c_str(), (long)offset, errno);
+            close(fd);
+            return false;
+        }
+        Update(buff.data(), bytes);
+        offset += bytes;
+    }
+    close(fd);
+    return true;
+}
 
-    MD5_CTX    ctx;
-    ssize_t    bytes;
-    const uint32_t MAX_MD5_BUFF_SIZE = 4096;
-    char       buff[MAX_MD5_BUFF_SIZE];
+std::string Md5Digest::HexDigest() {
     unsigned char out[MD5_DIGEST_LENGTH];
     char sz_result[2 * MD5_DIGEST_LENGTH + 1];
+    MD5_Final(out, &_ctx);
+    for (int i = 0; i < MD5_DIGEST_LENGTH; ++i) {
+        snprintf(sz_result + i * 2, 3, "%02x", out[i]);
+    }
+    sz_result[2 * MD5_DIGEST_LENGTH] = '\0';
+    return std::string(sz_result);
+}
 
-    MD5_Init(&ctx);
-    while ((bytes = read(fd, buff, MAX_MD5_BUFF_SIZE)) != 0) {
-        MD5_Update(&ctx, buff, bytes);
+bool GetFileIdentity(const std::string &file, FileIdentity &identity) {
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0) {
+        return false;
     }
-    MD5_Final(out, &ctx);
+    identity.dev = st.st_dev;
+    identity.ino = st.st_ino;
+    identity.size = st.st_size;
+    identity.mtime = st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec;
+    return true;
+}
 
-    for (int i = 0; i < MD5_DIGEST_LENGTH; ++i) {
-        sprintf(sz_result + i * 2, "%02x", out[i]); 
+const char* DigestCache::DEFAULT_DIR = "/tmp/levin_digest_cache";
+
+std::string DigestCache::entry_path(const FileIdentity &identity) const {
+    char name[128];
+    snprintf(name, sizeof(name), "/%lx_%lx_%lx_%lx", identity.dev, identity.ino, identity.size,
+            (uint64_t)identity.mtime);
+    return _dir + name;
+}
+
+bool DigestCache::IsVerified(const std::string &file, const std::string &md5) const {
+    FileIdentity identity;
+    if (_dir.empty() || md5.empty() || !GetFileIdentity(file, identity)) {
+        return false;
     }
-    sz_result[2 * MD5_DIGEST_LENGTH] = '\0';
-    md5 = sz_result;
-    close(fd);
+    std::ifstream fin(entry_path(identity));
+    std::string cached;
+    if (!(fin >> cached) || cached != md5) {
+        return false;
+    }
+    LEVIN_CINFO_LOG("md5 verified before with the same file identity, file=[%s]", file.c_str());
+    return true;
+}
+
+bool DigestCache::SetVerified(const std::string &file, const std::string &md5, const FileIdentity &identity) {
+    FileIdentity current;
+    if (_dir.empty() || !GetFileIdentity(file, current) || !(current == identity)) {
+        return false;
+    }
+    if (mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        LEVIN_CWARNING_LOG("create digest cache dir fail. dir=%s, errno=%d", _dir.c_str(), errno);
+        return false;
+    }
+    std::string path = entry_path(identity);
+    std::string tmp_path = path + "." + std::to_string(getpid()) + ".tmp";
+    std::ofstream fout(tmp_path, std::ios::out | std::ios::trunc);
+    fout << md5 << "\n";
+    fout.close();
+    if (!fout) {
+        LEVIN_CWARNING_LOG("write digest cache fail. path=%s", tmp_path.c_str());
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LEVIN_CWARNING_LOG("publish digest cache fail. path=%s, errno=%d", path.c_str(), errno);
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
 
+bool GetFileMD5(const std::string& file_name, std::string& md5) {
+    Md5Digest digest;
+    if (!digest.UpdateFromFile(file_name, 0)) {
+        return false;
+    }
+    md5 = digest.HexDigest();
     return true;
 }
 
 bool CheckFileMD5(const std::string file_path, const std::string verify_data) {
+    DigestCache &cache = DigestCache::GetInstance();
+    if (cache.IsVerified(file_path, verify_data)) {
+        return true;
+    }
+    // identity before read, cached only if file unchanged while read
+    FileIdentity identity;
+    bool is_identified = GetFileIdentity(file_path, identity);
     std::string md5;
     if (!GetFileMD5(file_path, md5)) {
         LEVIN_CWARNING_LOG("calculate md5 failed, file=[%s]", file_path.c_str());
@@ -44,6 +133,9 @@ bool CheckFileMD5(const std::string file_path, const std::string verify_data) {
     }
     if (md5 == verify_data) {
         LEVIN_CINFO_LOG("check file md5 success, file path=[%s]", file_path.c_str());
+        if (is_identified) {
+            cache.SetVerified(file_path, md5, identity);
+        }
         return true;
     } else {
         LEVIN_CWARNING_LOG(
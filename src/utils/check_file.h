@@ -1,13 +1,90 @@
 #ifndef  LEVIN_CHECK_FILE_H
 #define  LEVIN_CHECK_FILE_H
 
+#include <stdint.h>
+#include <sys/types.h>
 #include <string>
+#include "openssl/md5.h"
 
 namespace levin {
 
+// @brief md5 of a file, fed by ranges of the file in order
+// ranges maybe fed from memory the file is loaded into, so the file is read only once
+class Md5Digest {
+public:
+    Md5Digest() {
+        MD5_Init(&_ctx);
+    }
+
+    void Update(const void *data, size_t len) {
+        MD5_Update(&_ctx, data, len);
+    }
+    // @brief feed file content from offset to end of file
+    // retval succ: true fail: false (Never throws)
+    bool UpdateFromFile(const std::string &file, off_t offset);
+    // @brief lowercase hex digest, digest finalized
+    std::string HexDigest();
+
+private:
+    MD5_CTX _ctx;
+};
+
+// @brief identity of a file, content of an immutable file unchanged while identity unchanged
+struct FileIdentity {
+    uint64_t dev = 0;
+    uint64_t ino = 0;
+    uint64_t size = 0;
+    int64_t mtime = 0;      // nanoseconds
+
+    bool operator==(const FileIdentity &rhs) const {
+        return dev == rhs.dev && ino == rhs.ino && size == rhs.size && mtime == rhs.mtime;
+    }
+};
+
+bool GetFileIdentity(const std::string &file, FileIdentity &identity);
+
+// @brief persistent cache of verified file md5, keyed by file identity(dev, inode, size, mtime)
+// one small entry file per identity under cache dir, md5 as content, published by rename
+// so concurrent processes never read a partial entry; kept across process restarts,
+// entries of replaced files are never hit again
+class DigestCache {
+public:
+    static const char* DEFAULT_DIR;
+
+    static DigestCache& GetInstance() {
+        static DigestCache instance;
+        return instance;
+    }
+
+    // @brief empty dir disables cache, NOT thread safe, set before files verified
+    void SetDir(const std::string &dir) {
+        _dir = dir;
+    }
+    const std::string& GetDir() const {
+        return _dir;
+    }
+
+    // @brief md5 of file with current identity verified before
+    bool IsVerified(const std::string &file, const std::string &md5) const;
+    // @brief record md5 of file verified with identity, ignored if file changed since then
+    // retval succ: true fail: false (Never throws)
+    bool SetVerified(const std::string &file, const std::string &md5, const FileIdentity &identity);
+
+private:
+    DigestCache() : _dir(DEFAULT_DIR) {
+    }
+    std::string entry_path(const FileIdentity &identity) const;
+
+private:
+    std::string _dir;
+};
+
+bool GetFileMD5(const std::string& file_name, std::string& md5);
+
+// @brief md5 of file matches verify_data, skipped if verified before with the same file identity
+
 bool CheckFileMD5(const std::string file_path, const std::string verify_data);
 
 }
 
 #endif  // LEVIN_CHECK_FILE_H
-
@@ -0,0 +1,97 @@
+#include "checksum.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "parallel_utils.h"
+#include "levin_logger.h"
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace levin {
+
+static const uint32_t CRC32C_POLY = 0x82f63b78;    // reflected Castagnoli polynomial
+
+struct Crc32cTable {
+    uint32_t table[256];
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : (crc >> 1);
+            }
+            table[i] = crc;
+        }
+    }
+};
+
+static uint32_t Crc32cSoft(uint32_t crc, const unsigned char *ptr, size_t len) {
+    static const Crc32cTable crc_table;
+    while (len-- > 0) {
+        crc = crc_table.table[(crc ^ *ptr++) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t Crc32cHard(uint32_t crc, const unsigned char *ptr, size_t len) {
+    uint64_t crc64 = crc;
+    while (len > 0 && ((size_t)ptr & 7) != 0) {
+        crc64 = _mm_crc32_u8((uint32_t)crc64, *ptr++);
+        --len;
+    }
+    for (; len >= 8; len -= 8, ptr += 8) {
+        uint64_t word;
+        memcpy(&word, ptr, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    for (; len > 0; --len) {
+        crc64 = _mm_crc32_u8((uint32_t)crc64, *ptr++);
+    }
+    return (uint32_t)crc64;
+}
+#endif
+
+uint32_t Crc32c(uint32_t crc, const void *data, size_t len) {
+    const unsigned char *ptr = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if defined(__x86_64__)
+    static const bool is_sse42 = __builtin_cpu_supports("sse4.2");
+    if (is_sse42) {
+        return ~Crc32cHard(crc, ptr, len);
+    }
+#endif
+    return ~Crc32cSoft(crc, ptr, len);
+}
+
+bool BlockCrc32c(const void *addr, size_t len, size_t block_size, uint32_t thread_num, std::string &digest) {
+    if (block_size == 0) {
+        block_size = len;
+    }
+    if (thread_num == 0) {
+        thread_num = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    const size_t block_num = (len + block_size - 1) / block_size;
+    std::vector<uint32_t> block_crc(block_num, 0);
+    const char *base = static_cast<const char*>(addr);
+    bool succ = ParallelRun(block_num, thread_num, [&](size_t idx) {
+        size_t lower = idx * block_size;
+        size_t upper = std::min(lower + block_size, len);
+        block_crc[idx] = Crc32c(0, base + lower, upper - lower);
+        return true;
+    });
+    if (!succ) {
+        return false;
+    }
+    uint32_t root = Crc32c(0, block_crc.data(), block_num * sizeof(uint32_t));
+    char buf[32] = {0};
+    snprintf(buf, sizeof(buf), "%08x%016lx", root, (unsigned long)len);
+    digest = buf;
+    LEVIN_CDEBUG_LOG("BlockCrc32c. area=%p, len=%lu, blocks=%lu, digest=%s", addr, len, block_num, buf);
+    return true;
+}
+
+}  // namespace levin
@@ -0,0 +1,21 @@
+#ifndef LEVIN_CHECKSUM_H
+#define LEVIN_CHECKSUM_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace levin {
+
+// @brief CRC32C(Castagnoli) of data, continued from crc
+// computed by SSE4.2 crc32 instruction if supported by cpu, otherwise by table
+uint32_t Crc32c(uint32_t crc, const void *data, size_t len);
+
+// @brief region [addr, addr + len) splitted into blocks of block_size, CRC32C of blocks computed
+// by a pool of thread_num threads(0 means online cpus), block checksums folded with len into digest(hex)
+// retval succ: true fail: false (Never throws)
+bool BlockCrc32c(const void *addr, size_t len, size_t block_size, uint32_t thread_num, std::string &digest);
+
+}  // namespace levin
+
+#endif  // LEVIN_CHECKSUM_H
@@ -0,0 +1,76 @@
+#ifndef LEVIN_CONTAINER_OPTIONS_H
+#define LEVIN_CONTAINER_OPTIONS_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+namespace levin {
+
+// @brief page warm-up policy of memory region after attached or loaded
+enum class WarmupPolicy {
+    None,           // pages faulted in by first requests
+    Sequential,     // touch every page by current thread
+    Parallel,       // touch pages by a pool of warmup_threads threads
+    Populate        // populate page tables by kernel: MAP_POPULATE/MADV_POPULATE_READ/MADV_WILLNEED
+};
+
+// @brief NUMA placement policy of memory region
+enum class NumaPolicy {
+    None,           // first touch, usually all pages on node of the loader
+    Interleave,     // pages interleaved across all online nodes
+    Bind,           // pages bound to numa_node
+    Replicate       // one replica per node, each bound to its node (replica of numa_node if standalone)
+};
+
+// @brief shared container options, specified per container or per SharedContainerManager
+struct ContainerOptions {
+    // binfile loader: load_threads > 1 means container bin is splitted into chunks
+    // which are read by a pool of threads with pread straight into the memory region
+    uint32_t load_threads = 1;
+    size_t load_chunk_size = 64UL << 20;
+    // binfile loader: load_direct means container bin is read with O_DIRECT, NOT polluting page cache
+    // load_queue_depth requests of load_io_size are kept in flight by io_uring,
+    // or by a pool of load_threads threads if io_uring unavailable or load_queue_depth is 0
+    bool load_direct = false;
+    uint32_t load_queue_depth = 32;
+    size_t load_io_size = 1UL << 20;
+    // memory region backed by huge pages: 0 means normal pages, otherwise 2MB/1GB etc.
+    // SysV shm is created with SHM_HUGETLB, falls back to normal pages if no hugetlbfs pages available
+    // heap and mmap-backed regions are advised with MADV_HUGEPAGE
+    size_t huge_page_size = 0;
+    // SegmentedSharedMemory: memory region splitted into SysV segments of shm_segment_size,
+    // attached contiguously. 0 means min(shmmax, MAX_MEM_SIZE)
+    size_t shm_segment_size = 0;
+    // warm-up after attached or loaded, warmup_lock means pages locked in memory by mlock
+    // warmup_async means warm-up in background thread, otherwise SharedContainerManager::Register
+    // blocks until the container is warm
+    WarmupPolicy warmup = WarmupPolicy::None;
+    uint32_t warmup_threads = 4;
+    bool warmup_lock = false;
+    bool warmup_async = false;
+    // NUMA placement of memory region, applied when region created
+    // with Replicate, SharedContainerManager registers one replica per node,
+    // and resolves container handle to the replica local to the calling thread's node
+    NumaPolicy numa_policy = NumaPolicy::None;
+    int numa_node = 0;
+    // reader role: only attach existing and verified memory region read-only, never create or load
+    // Init returns SC_RET_SHM_NOEXIST if region missing, Destroy detaches without removing it
+    bool read_only = false;
+    // shm loaded by another process(Loading in catalog) is waited at most load_wait_timeout_ms
+    // until it is published Ready, then attached; Init returns SC_RET_LOADING if timeout
+    uint32_t load_wait_timeout_ms = 300000;
+    // expected md5(hex) of binfile, verified in the same pass the binfile is loaded:
+    // bytes loaded in place are fed into the digest in file order, no separate read of the binfile
+    // Load fails with SC_RET_FILE_CHECK before region published Ready if mismatched
+    std::string load_md5;
+    // existing region readable right after cheap structural checks(type hash, version, bounds),
+    // region checksum(CheckFunc) verified by a low priority background thread;
+    // region found corrupted is quarantined: removed from the system, later Init creates and reloads it,
+    // SharedContainerManager reloads it and replaces the corrupted one
+    bool verify_lazy = false;
+};
+
+}  // namespace levin
+
+#endif  // LEVIN_CONTAINER_OPTIONS_H
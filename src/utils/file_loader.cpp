@@ -0,0 +1,465 @@
+#include "file_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <boost/atomic.hpp>
+#include "parallel_utils.h"
+#include "levin_logger.h"
+#include "levin_timer.hpp"
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define LEVIN_HAS_IO_URING 1
+#endif
+#endif
+
+namespace levin {
+
+bool PreadFull(int fd, void *buf, size_t len, off_t offset) {
+    char *ptr = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t bytes = pread(fd, ptr, len, offset);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            LEVIN_CWARNING_LOG("pread fail. fd=%d, offset=%ld, left=%lu, errno=%d",
+                    fd, (long)offset, len, (bytes < 0 ? errno : 0));
+            return false;
+        }
+        ptr += bytes;
+        len -= bytes;
+        offset += bytes;
+    }
+    return true;
+}
+
+bool PwriteFull(int fd, const void *buf, size_t len, off_t offset) {
+    const char *ptr = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t bytes = pwrite(fd, ptr, len, offset);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            LEVIN_CWARNING_LOG("pwrite fail. fd=%d, offset=%ld, left=%lu, errno=%d",
+                    fd, (long)offset, len, (bytes < 0 ? errno : 0));
+            return false;
+        }
+        ptr += bytes;
+        len -= bytes;
+        offset += bytes;
+    }
+    return true;
+}
+
+bool ParallelPread(const std::string &file, int fd, void *dst, size_t len, off_t offset,
+        size_t chunk_size, uint32_t thread_num, const CommitFunc &commit) {
+    if (len == 0) {
+        return true;
+    }
+    if (chunk_size == 0) {
+        chunk_size = len;
+    }
+    // chunk i covers file range [i * chunk_size, (i + 1) * chunk_size) clipped by [offset, end)
+    const size_t begin = offset;
+    const size_t end = begin + len;
+    const size_t first_chunk = begin / chunk_size;
+    const size_t chunk_num = (end + chunk_size - 1) / chunk_size - first_chunk;
+    TimerGuard tg(file, __func__, len);
+    // chunks finished out of order, committed over finished prefix
+    std::vector<char> done(commit ? chunk_num : 0, 0);
+    size_t next = 0;
+    std::mutex mutex;
+    return ParallelRun(chunk_num, thread_num, [&](size_t idx) {
+        size_t lower = std::max((first_chunk + idx) * chunk_size, begin);
+        size_t upper = std::min((first_chunk + idx + 1) * chunk_size, end);
+        if (!PreadFull(fd, (char*)dst + (lower - begin), upper - lower, lower)) {
+            return false;
+        }
+        if (commit) {
+            std::lock_guard<std::mutex> guard(mutex);
+            done[idx] = 1;
+            size_t first = next;
+            while (next < chunk_num && done[next]) {
+                ++next;
+            }
+            if (next > first) {
+                commit(std::max((first_chunk + first) * chunk_size, begin),
+                        std::min((first_chunk + next) * chunk_size, end));
+            }
+        }
+        return true;
+    });
+}
+
+// @brief O_DIRECT read of one io unit, file range [start, start + len) aligned
+// at least `need` bytes must be read, the rest may be cut by end of file
+static bool DirectPreadAtLeast(int fd, char *buf, size_t len, size_t start, size_t need, size_t got = 0) {
+    while (got < need) {
+        ssize_t bytes = pread(fd, buf + got, len - got, start + got);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            LEVIN_CWARNING_LOG("direct pread fail. fd=%d, offset=%lu, left=%lu, errno=%d",
+                    fd, start + got, need - got, (bytes < 0 ? errno : 0));
+            return false;
+        }
+        got += bytes;
+    }
+    return true;
+}
+
+// @brief split file range [offset, offset + len) into io units aligned to io_size
+// io unit is read straight into dst when both file range and destination are aligned,
+// otherwise read into an aligned bounce buffer and copied into dst
+class DirectReadPlan {
+public:
+    DirectReadPlan(void *dst, size_t len, off_t offset, size_t io_size, size_t align) :
+            _dst((char*)dst), _begin(offset), _end(offset + len), _align(align) {
+        _io_size = std::max((io_size + align - 1) / align * align, align);
+        _first = _begin / _io_size;
+        _num = (_end + _io_size - 1) / _io_size - _first;
+    }
+
+    size_t io_num() const { return _num; }
+    size_t io_size() const { return _io_size; }
+
+    // aligned file range to read, and bytes must be read of it
+    size_t start(size_t idx) const { return (_first + idx) * _io_size; }
+    size_t length(size_t idx) const {
+        size_t aligned_end = (_end + _align - 1) / _align * _align;
+        return std::min(start(idx) + _io_size, aligned_end) - start(idx);
+    }
+    size_t need(size_t idx) const {
+        return std::min(start(idx) + _io_size, _end) - start(idx);
+    }
+    // destination address if io unit can be read in place, otherwise nullptr
+    char* target(size_t idx) const {
+        char *addr = _dst + start(idx) - _begin;
+        if (start(idx) < _begin || need(idx) != length(idx) || (size_t)addr % _align != 0) {
+            return nullptr;
+        }
+        return addr;
+    }
+    // copy valid part of io unit from bounce buffer into destination
+    void copy(size_t idx, const char *buf) const {
+        size_t lower = std::max(start(idx), _begin);
+        size_t upper = start(idx) + need(idx);
+        memcpy(_dst + (lower - _begin), buf + (lower - start(idx)), upper - lower);
+    }
+
+private:
+    char *_dst;
+    size_t _begin;
+    size_t _end;
+    size_t _align;
+    size_t _io_size;
+    size_t _first;
+    size_t _num;
+};
+
+// @brief aligned bounce buffers, one for each in-flight request
+class AlignedBuffers {
+public:
+    AlignedBuffers(size_t num, size_t size, size_t align) : _bufs(num, nullptr) {
+        for (auto &buf : _bufs) {
+            void *ptr = nullptr;
+            if (posix_memalign(&ptr, align, size) != 0) {
+                ptr = nullptr;
+            }
+            buf = static_cast<char*>(ptr);
+        }
+    }
+    ~AlignedBuffers() {
+        for (auto buf : _bufs) {
+            free(buf);
+        }
+    }
+    bool valid() const {
+        return std::find(_bufs.begin(), _bufs.end(), nullptr) == _bufs.end();
+    }
+    char* operator[](size_t idx) const { return _bufs[idx]; }
+
+private:
+    std::vector<char*> _bufs;
+};
+
+#ifdef LEVIN_HAS_IO_URING
+// @brief minimal io_uring submission/completion rings over raw syscalls
+class IoUring {
+public:
+    IoUring() {}
+    ~IoUring() {
+        if (_sqes != nullptr) {
+            munmap(_sqes, _sqes_len);
+        }
+        if (_cq_ptr != nullptr && _cq_ptr != _sq_ptr) {
+            munmap(_cq_ptr, _cq_len);
+        }
+        if (_sq_ptr != nullptr) {
+            munmap(_sq_ptr, _sq_len);
+        }
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+    // retval succ: 0 fail: errno (Never throws)
+    int init(unsigned entries) {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        _fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (_fd < 0) {
+            return errno;
+        }
+        _sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            _sq_len = _cq_len = std::max(_sq_len, _cq_len);
+        }
+        _sq_ptr = mmap(nullptr, _sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                _fd, IORING_OFF_SQ_RING);
+        if (_sq_ptr == MAP_FAILED) {
+            _sq_ptr = nullptr;
+            return errno;
+        }
+        _cq_ptr = _sq_ptr;
+        if (!single_mmap) {
+            _cq_ptr = mmap(nullptr, _cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    _fd, IORING_OFF_CQ_RING);
+            if (_cq_ptr == MAP_FAILED) {
+                _cq_ptr = nullptr;
+                return errno;
+            }
+        }
+        _sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+        void *sqes = mmap(nullptr, _sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                _fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return errno;
+        }
+        _sqes = static_cast<struct io_uring_sqe*>(sqes);
+        char *sq = static_cast<char*>(_sq_ptr);
+        char *cq = static_cast<char*>(_cq_ptr);
+        _sq_tail = (unsigned*)(sq + params.sq_off.tail);
+        _sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+        _sq_array = (unsigned*)(sq + params.sq_off.array);
+        _cq_head = (unsigned*)(cq + params.cq_off.head);
+        _cq_tail = (unsigned*)(cq + params.cq_off.tail);
+        _cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+        _cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+        _entries = params.sq_entries;
+        return 0;
+    }
+
+    unsigned entries() const { return _entries; }
+
+    // @brief queue a readv request, caller keeps in-flight requests no more than entries
+    void prep_readv(int fd, const struct iovec *iov, size_t offset, uint64_t user_data) {
+        unsigned tail = *_sq_tail;
+        unsigned idx = tail & _sq_mask;
+        struct io_uring_sqe *sqe = &_sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = fd;
+        sqe->addr = (uint64_t)(uintptr_t)iov;
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = user_data;
+        _sq_array[idx] = idx;
+        __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+        ++_to_submit;
+    }
+
+    // @brief submit queued requests and wait for at least one completion
+    // retval succ: 0 fail: errno (Never throws)
+    int submit_and_wait() {
+        while (true) {
+            int ret = syscall(__NR_io_uring_enter, _fd, _to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret >= 0) {
+                _to_submit -= std::min((unsigned)ret, _to_submit);
+                return 0;
+            }
+            if (errno != EINTR) {
+                return errno;
+            }
+        }
+    }
+
+    // @brief pop a completion, retval false if completion queue is empty
+    bool pop_cqe(uint64_t &user_data, int &res) {
+        unsigned head = *_cq_head;
+        if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const struct io_uring_cqe &cqe = _cqes[head & _cq_mask];
+        user_data = cqe.user_data;
+        res = cqe.res;
+        __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int _fd = -1;
+    unsigned _entries = 0;
+    unsigned _to_submit = 0;
+    void *_sq_ptr = nullptr;
+    void *_cq_ptr = nullptr;
+    size_t _sq_len = 0;
+    size_t _cq_len = 0;
+    size_t _sqes_len = 0;
+    struct io_uring_sqe *_sqes = nullptr;
+    unsigned *_sq_tail = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned *_sq_array = nullptr;
+    unsigned *_cq_head = nullptr;
+    unsigned *_cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    struct io_uring_cqe *_cqes = nullptr;
+};
+
+// @brief keep queue_depth requests in flight with a single thread
+// retval succ: 0 io_uring unavailable: ENOSYS etc. read fail: EIO (Never throws)
+static int DirectReadUring(int fd, const DirectReadPlan &plan, uint32_t queue_depth, size_t align) {
+    IoUring ring;
+    int ret = ring.init(queue_depth);
+    if (ret != 0) {
+        return ret;
+    }
+    const size_t depth = std::min((size_t)ring.entries(), plan.io_num());
+    AlignedBuffers bufs(depth, plan.io_size(), align);
+    if (!bufs.valid()) {
+        return ENOMEM;
+    }
+    std::vector<struct iovec> iovs(depth);
+    std::vector<size_t> slot_io(depth);
+    std::vector<size_t> free_slots;
+    for (size_t slot = depth; slot > 0; --slot) {
+        free_slots.push_back(slot - 1);
+    }
+    size_t next = 0;
+    size_t done = 0;
+    while (done < plan.io_num()) {
+        while (!free_slots.empty() && next < plan.io_num()) {
+            size_t slot = free_slots.back();
+            free_slots.pop_back();
+            char *target = plan.target(next);
+            iovs[slot].iov_base = (target != nullptr ? target : bufs[slot]);
+            iovs[slot].iov_len = plan.length(next);
+            slot_io[slot] = next;
+            ring.prep_readv(fd, &iovs[slot], plan.start(next), slot);
+            ++next;
+        }
+        ret = ring.submit_and_wait();
+        if (ret != 0) {
+            LEVIN_CWARNING_LOG("io_uring enter fail. errno=%d", ret);
+            return EIO;
+        }
+        uint64_t slot = 0;
+        int res = 0;
+        while (ring.pop_cqe(slot, res)) {
+            size_t idx = slot_io[slot];
+            char *buf = (char*)iovs[slot].iov_base;
+            if (res < 0) {
+                LEVIN_CWARNING_LOG("io_uring read fail. offset=%lu, errno=%d", plan.start(idx), -res);
+                return EIO;
+            }
+            // short read before end of file, read remaining synchronously
+            if (!DirectPreadAtLeast(fd, buf, plan.length(idx), plan.start(idx), plan.need(idx), res)) {
+                return EIO;
+            }
+            if (buf == bufs[slot]) {
+                plan.copy(idx, buf);
+            }
+            free_slots.push_back(slot);
+            ++done;
+        }
+    }
+    return 0;
+}
+#endif
+
+// @brief a pool of threads, each thread holds one bounce buffer and blocks on pread
+static bool DirectReadThreads(int fd, const DirectReadPlan &plan, uint32_t thread_num, size_t align) {
+    thread_num = std::max(std::min((size_t)thread_num, plan.io_num()), (size_t)1);
+    boost::atomic<size_t> next_io(0);
+    return ParallelRun(thread_num, thread_num, [&](size_t) {
+        AlignedBuffers buf(1, plan.io_size(), align);
+        if (!buf.valid()) {
+            LEVIN_CWARNING_LOG("alloc aligned buffer fail. size=%lu", plan.io_size());
+            return false;
+        }
+        for (size_t idx = next_io++; idx < plan.io_num(); idx = next_io++) {
+            char *target = plan.target(idx);
+            if (!DirectPreadAtLeast(fd, (target != nullptr ? target : buf[0]),
+                        plan.length(idx), plan.start(idx), plan.need(idx))) {
+                return false;
+            }
+            if (target == nullptr) {
+                plan.copy(idx, buf[0]);
+            }
+        }
+        return true;
+    });
+}
+
+bool DirectPread(const std::string &file, void *dst, size_t len, off_t offset,
+        size_t io_size, uint32_t queue_depth, uint32_t thread_num) {
+    (void)queue_depth;
+    if (len == 0) {
+        return true;
+    }
+    int fd = open(file.c_str(), O_RDONLY | O_DIRECT);
+    if (fd < 0) {
+        // filesystem not support O_DIRECT, eg. tmpfs
+        LEVIN_CWARNING_LOG("open file with O_DIRECT fail, fallback to buffered read. file=%s, errno=%d",
+                file.c_str(), errno);
+        fd = open(file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LEVIN_CWARNING_LOG("open file for read fail. file=%s", file.c_str());
+            return false;
+        }
+        bool succ = ParallelPread(file, fd, dst, len, offset, io_size, thread_num);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        return succ;
+    }
+    const size_t align = sysconf(_SC_PAGESIZE);
+    DirectReadPlan plan(dst, len, offset, io_size, align);
+    bool succ = true;
+    {
+        TimerGuard tg(file, __func__, len);
+        int ret = ENOSYS;
+#ifdef LEVIN_HAS_IO_URING
+        if (queue_depth > 0) {
+            ret = DirectReadUring(fd, plan, queue_depth, align);
+        }
+#endif
+        if (ret == EIO) {
+            succ = false;
+        } else if (ret != 0) {
+            LEVIN_CINFO_LOG("io_uring unavailable or disabled, fallback to thread pool. file=%s, errno=%d, threads=%u",
+                    file.c_str(), ret, thread_num);
+            succ = DirectReadThreads(fd, plan, thread_num, align);
+        }
+    }
+    // drop page cache of the file (e.g. header read by buffered io), avoid double residency
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    return succ;
+}
+
+}  // namespace levin
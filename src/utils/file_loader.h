@@ -0,0 +1,39 @@
+#ifndef LEVIN_FILE_LOADER_H
+#define LEVIN_FILE_LOADER_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace levin {
+
+// @brief read exactly len bytes at file offset, retry on EINTR and short read
+// retval succ: true fail: false (Never throws)
+bool PreadFull(int fd, void *buf, size_t len, off_t offset);
+// @brief write exactly len bytes at file offset, retry on EINTR and short write
+// retval succ: true fail: false (Never throws)
+bool PwriteFull(int fd, const void *buf, size_t len, off_t offset);
+
+// @brief read file range [offset, offset + len) into dst by chunks with a pool of threads
+// chunk boundaries are aligned to file offset multiple of chunk_size
+// time cost and throughput are logged with file path
+// chunks finish out of order, commit(if specified) is called with file ranges [begin, end) read in place,
+// serialized and in file order, e.g. to advance resume offset or feed digest of the file
+// retval succ: true fail: false (Never throws)
+typedef std::function<void(uint64_t begin, uint64_t end)> CommitFunc;
+bool ParallelPread(const std::string &file, int fd, void *dst, size_t len, off_t offset,
+        size_t chunk_size, uint32_t thread_num, const CommitFunc &commit = nullptr);
+
+// @brief read file range [offset, offset + len) into dst with O_DIRECT, bypass page cache
+// keep queue_depth requests of io_size in flight by io_uring, or fallback to a pool of threads
+// if io_uring unavailable or queue_depth is 0
+// page cache of the file is dropped by posix_fadvise(DONTNEED) after read
+// retval succ: true fail: false (Never throws)
+bool DirectPread(const std::string &file, void *dst, size_t len, off_t offset,
+        size_t io_size, uint32_t queue_depth, uint32_t thread_num);
+
+}  // namespace levin
+
+#endif  // LEVIN_FILE_LOADER_H
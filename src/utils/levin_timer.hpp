@@ -2,6 +2,7 @@
 #define LEVIN_TIMER_H
 
 #include <stdint.h>
+#include <string>
 #include <sys/time.h>
 #include "levin_logger.h"
 
@@ -36,17 +37,29 @@ private:
     timeval te;
 };
 
+// @brief log time cost of a step, and throughput if bytes processed is specified
 class TimerGuard {
 public:
-    TimerGuard(const std::string &path, const std::string &func): _timer(Timer()), _path(path), _func(func) {}
+    TimerGuard(const std::string &path, const std::string &func, size_t bytes = 0):
+        _timer(Timer()), _path(path), _func(func), _bytes(bytes) {}
     ~TimerGuard() {
         double latency_ms = (double)_timer.get_time_ms();
-        LEVIN_CINFO_LOG("step=[func=%s, path=%s], time_cost=[%.1f s]", _func.c_str(), _path.c_str(), latency_ms / 1000.0);
+        if (_bytes == 0) {
+            LEVIN_CINFO_LOG("step=[func=%s, path=%s], time_cost=[%.1f s]", _func.c_str(), _path.c_str(), latency_ms / 1000.0);
+            return;
+        }
+        // us precision for short step
+        double latency_s = (latency_ms < 1000 ? _timer.get_time_us() / 1000000.0 : latency_ms / 1000.0);
+        double gbps = (double)_bytes / (1UL << 30) / (latency_s > 0 ? latency_s : 0.000001);
+        LEVIN_CINFO_LOG("step=[func=%s, path=%s], time_cost=[%.1f s], bytes=[%lu], throughput=[%.2f GB/s]",
+                _func.c_str(), _path.c_str(), latency_ms / 1000.0, _bytes, gbps);
     }
+    void set_bytes(size_t bytes) { _bytes = bytes; }
 private:
     Timer _timer;
     std::string _path;
     std::string _func;
+    size_t _bytes;
 };
 
 }
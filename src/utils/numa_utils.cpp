@@ -0,0 +1,120 @@
+#include "numa_utils.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <vector>
+#include "levin_logger.h"
+
+namespace levin {
+
+// memory policy modes, see mbind(2)
+static const int LEVIN_MPOL_BIND = 2;
+static const int LEVIN_MPOL_INTERLEAVE = 3;
+static const std::string NUMA_REPLICA_SEPARATOR = "#numa";
+
+// @brief online nodes bitmask, parsed from node list like "0-1,3"
+static std::vector<unsigned long> OnlineNodeMask() {
+    static const size_t BITS = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask(1, 0);
+    FILE *fp = fopen("/sys/devices/system/node/online", "r");
+    if (fp == nullptr) {
+        mask[0] = 1;
+        return mask;
+    }
+    int lower = 0;
+    int upper = 0;
+    while (fscanf(fp, "%d", &lower) == 1) {
+        upper = lower;
+        int ch = fgetc(fp);
+        if (ch == '-' && fscanf(fp, "%d", &upper) == 1) {
+            ch = fgetc(fp);
+        }
+        for (int node = lower; node <= upper; ++node) {
+            if (mask.size() <= node / BITS) {
+                mask.resize(node / BITS + 1, 0);
+            }
+            mask[node / BITS] |= 1UL << (node % BITS);
+        }
+        if (ch != ',') {
+            break;
+        }
+    }
+    fclose(fp);
+    if (mask.size() == 1 && mask[0] == 0) {
+        mask[0] = 1;
+    }
+    return mask;
+}
+
+int NumaNodeNum() {
+    static const int node_num = []() {
+        std::vector<unsigned long> mask = OnlineNodeMask();
+        static const int BITS = sizeof(unsigned long) * 8;
+        for (int idx = mask.size() - 1; idx >= 0; --idx) {
+            if (mask[idx] != 0) {
+                return idx * BITS + (BITS - 1 - __builtin_clzl(mask[idx])) + 1;
+            }
+        }
+        return 1;
+    }();
+    return node_num;
+}
+
+int CurrentNumaNode() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+bool NumaBindRegion(void *addr, size_t len, NumaPolicy policy, int node) {
+    static const size_t BITS = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> mask;
+    int mode = 0;
+    switch (policy) {
+    case NumaPolicy::None:
+        return true;
+    case NumaPolicy::Interleave:
+        mode = LEVIN_MPOL_INTERLEAVE;
+        mask = OnlineNodeMask();
+        break;
+    case NumaPolicy::Bind:
+    case NumaPolicy::Replicate:
+        if (node < 0 || node >= NumaNodeNum()) {
+            LEVIN_CWARNING_LOG("invalid numa node=%d, node num=%d", node, NumaNodeNum());
+            return false;
+        }
+        mode = LEVIN_MPOL_BIND;
+        mask.resize(node / BITS + 1, 0);
+        mask[node / BITS] |= 1UL << (node % BITS);
+        break;
+    default:
+        LEVIN_CWARNING_LOG("Invalid numa policy, policy=%d", (int)policy);
+        return false;
+    }
+    if (syscall(SYS_mbind, addr, len, mode, mask.data(), mask.size() * BITS + 1, 0) != 0) {
+        LEVIN_CWARNING_LOG("mbind fail. addr=%p, len=%lu, policy=%d, node=%d, errno=%d",
+                addr, len, (int)policy, node, errno);
+        return false;
+    }
+    return true;
+}
+
+std::string NumaReplicaName(const std::string &path, int node) {
+    return path + NUMA_REPLICA_SEPARATOR + std::to_string(node);
+}
+
+std::string NumaReplicaPath(const std::string &name) {
+    size_t pos = name.rfind(NUMA_REPLICA_SEPARATOR);
+    if (pos == std::string::npos ||
+            name.find_first_not_of("0123456789", pos + NUMA_REPLICA_SEPARATOR.size()) != std::string::npos) {
+        return name;
+    }
+    return name.substr(0, pos);
+}
+
+}  // namespace levin
@@ -0,0 +1,29 @@
+#ifndef LEVIN_NUMA_UTILS_H
+#define LEVIN_NUMA_UTILS_H
+
+#include <cstddef>
+#include <string>
+#include "container_options.h"
+
+namespace levin {
+
+// @brief number of NUMA nodes, 1 if NUMA not supported
+int NumaNodeNum();
+
+// @brief NUMA node of the cpu calling thread running on, 0 if unknown
+int CurrentNumaNode();
+
+// @brief set memory policy of page aligned region [addr, addr + len) before pages faulted in
+// implemented by mbind(2) syscall, no libnuma dependency
+// retval succ: true fail: false (Never throws)
+bool NumaBindRegion(void *addr, size_t len, NumaPolicy policy, int node);
+
+// @brief name of replica on specified node, eg. /data/map.dat#numa1
+std::string NumaReplicaName(const std::string &path, int node);
+
+// @brief path of the binfile which replica loaded from
+std::string NumaReplicaPath(const std::string &name);
+
+}  // namespace levin
+
+#endif  // LEVIN_NUMA_UTILS_H
@@ -0,0 +1,62 @@
+#include "parallel_utils.h"
+#include <boost/atomic.hpp>
+#include <boost/thread.hpp>
+#include <unistd.h>
+#include <algorithm>
+
+namespace levin {
+
+static void ParallelRunProcess(size_t task_num,
+        boost::atomic<size_t> &next_task,
+        boost::atomic<bool> &is_fail,
+        const std::function<bool(size_t)> &task) {
+    while (!is_fail) {
+        size_t idx = next_task++;
+        if (idx >= task_num) {
+            return;
+        }
+        if (!task(idx)) {
+            is_fail = true;
+        }
+    }
+}
+
+bool ParallelRun(size_t task_num, uint32_t thread_num, const std::function<bool(size_t)> &task) {
+    if (thread_num > task_num) {
+        thread_num = task_num;
+    }
+    boost::atomic<size_t> next_task(0);
+    boost::atomic<bool> is_fail(false);
+    if (thread_num <= 1) {
+        ParallelRunProcess(task_num, next_task, is_fail, task);
+        return !is_fail;
+    }
+    boost::thread_group threads;
+    for (uint32_t i = 0; i < thread_num; ++i) {
+        threads.create_thread(boost::bind(&ParallelRunProcess,
+                    task_num, boost::ref(next_task), boost::ref(is_fail), boost::cref(task)));
+    }
+    threads.join_all();
+    return !is_fail;
+}
+
+static boost::atomic<uint32_t> dump_threads(0);
+
+uint32_t GetDumpThreads() {
+    uint32_t thread_num = dump_threads;
+    if (thread_num == 0) {
+        long cpu_num = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_num = (cpu_num > 0 ? cpu_num : 1);
+    }
+    return thread_num;
+}
+
+void SetDumpThreads(uint32_t thread_num) {
+    dump_threads = thread_num;
+}
+
+uint32_t DumpThreadNum(size_t elem_num) {
+    return std::max<size_t>(1, std::min<size_t>(GetDumpThreads(), elem_num / DUMP_ELEMS_PER_THREAD));
+}
+
+}  // namespace levin
@@ -0,0 +1,25 @@
+#ifndef LEVIN_PARALLEL_UTILS_H
+#define LEVIN_PARALLEL_UTILS_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <functional>
+
+namespace levin {
+
+// @brief run tasks [0, task_num) by a pool of thread_num threads
+// task returns false means failed, remaining tasks will NOT be scheduled
+// retval true if all tasks succeed
+bool ParallelRun(size_t task_num, uint32_t thread_num, const std::function<bool(size_t)> &task);
+
+// @brief threads of dumping binfile(partition, sort and write), default number of online cpus
+// small binfile dumped by fewer threads, at least DUMP_ELEMS_PER_THREAD elements per thread
+const size_t DUMP_ELEMS_PER_THREAD = 1UL << 16;
+uint32_t GetDumpThreads();
+void SetDumpThreads(uint32_t thread_num);
+// @brief threads of dumping elem_num elements
+uint32_t DumpThreadNum(size_t elem_num);
+
+}  // namespace levin
+
+#endif  // LEVIN_PARALLEL_UTILS_H
@@ -8,8 +8,10 @@
 #include <unordered_map>
 #include <functional>
 #include <algorithm>
+#include <cmath>
 #include <openssl/md5.h>
 #include "levin_logger.h"
+#include "checksum.h"
 
 namespace levin {
 
@@ -31,7 +33,8 @@ enum {
     SC_RET_FILE_CHECK,          // 文件校验出错
     SC_RET_EXCEPTION,           // 有异常抛出
     SC_RET_ERR_SYS,             // 获取系统信息出错
-    SC_RET_SHM_KEY_CONFLICT     // 不同文件生成key冲突
+    SC_RET_SHM_KEY_CONFLICT,    // 不同文件生成key冲突
+    SC_RET_SHM_NOEXIST          // 只读模式SHM不存在
 };
 
 inline const char* CodeToMsg(int code) {
@@ -52,7 +55,8 @@ inline const char* CodeToMsg(int code) {
         {SC_RET_FILE_CHECK,       "File MD5 check fail"                              },
         {SC_RET_EXCEPTION,        "Container internal exception"                     },
         {SC_RET_ERR_SYS,          "Xsi share memory system error"                    },
-        {SC_RET_SHM_KEY_CONFLICT, "Different files generate conflict shm key"        }
+        {SC_RET_SHM_KEY_CONFLICT, "Different files generate conflict shm key"        },
+        {SC_RET_SHM_NOEXIST,      "Shm no exist, read only container NOT loaded"     }
     };
     auto ret = code_msg_pairs.find(code);
     if (ret != code_msg_pairs.end()) {
@@ -80,10 +84,19 @@ inline std::string demangle(const char *name) {
 // meta.flags    = 72057594037927936                 container flags(version etc.)
 // meta.label    = 4886718345                        magic num:0x123456789, for notify container integrity
 // meta.checksum = 626738dd02fccd46b2d9ed8d093014d7  container memory region checksum, for one-by-one byte check
+// meta.state    = Ready                             load state, Ready published after loaded and checksummed
+// meta.loaded_offset = 4096                         binfile loaded in place up to offset, load resumed from it
 const size_t PATH_LENGTH = 1024;
 const size_t TYPENAME_ID_LENGTH = 128;
 const size_t GROUP_ID_LENGTH = 128;
 const size_t MD5SUM_DIGEST_LENGTH = 16;
+// @brief load state of memory region, region NOT Ready is partially loaded
+enum class LoadState : uint32_t {
+    Empty = 0,
+    Loading,
+    Ready
+};
+
 typedef struct Meta {
     char path[PATH_LENGTH + 1];
     uint64_t flags;
@@ -93,14 +106,21 @@ typedef struct Meta {
     uint64_t hashcode;
     uint64_t label;
     char checksum[MD5SUM_DIGEST_LENGTH * 2 + 1];
-    Meta() : flags(0), hashcode(0), label(0) {
+    LoadState state;
+    uint32_t generation;        // number of loads into the region
+    uint64_t loaded_offset;
+    uint64_t file_size;         // binfile being loaded, identified by size and mtime
+    int64_t file_mtime;
+    Meta() : flags(0), hashcode(0), label(0), state(LoadState::Empty), generation(0),
+            loaded_offset(0), file_size(0), file_mtime(0) {
         memset(path, 0, sizeof(path));
         memset(summary, 0, sizeof(path));
         memset(checksum, 0, sizeof(checksum));
     }
     Meta(const char *name, const char *type, const char *group_name,
          const int appid, const size_t hash, const uint64_t flg) :
-            flags(flg), id(appid), hashcode(hash), label(0) {
+            flags(flg), id(appid), hashcode(hash), label(0), state(LoadState::Empty), generation(0),
+            loaded_offset(0), file_size(0), file_mtime(0) {
         strncpy(path, name, PATH_LENGTH);
         path[PATH_LENGTH] = '\0';
         strncpy(summary, demangle(type).c_str(), TYPENAME_ID_LENGTH);
@@ -129,7 +149,9 @@ inline std::string SharedMeta::layout() const {
        << "[" << (void*)&hashcode << "]\t\tmeta.hashcode=" << hashcode << std::endl
        << "[" << (void*)&flags << "]\t\tmeta.flags=" << flags << std::endl
        << "[" << (void*)&label << "]\t\tmeta.label=" << label << std::endl
-       << "[" << (void*)&checksum << "]\t\tmeta.checksum=" << checksum;
+       << "[" << (void*)&checksum << "]\t\tmeta.checksum=" << checksum << std::endl
+       << "[" << (void*)&state << "]\t\tmeta.state=" << (uint32_t)state << std::endl
+       << "[" << (void*)&loaded_offset << "]\t\tmeta.loaded_offset=" << loaded_offset;
     return ss.str();
 }
 
@@ -174,6 +196,133 @@ inline uint64_t getPrime(uint64_t i) {
     return i;
 }
 
+// @brief hash mixed(murmur3 fmix64), bijective, as std hash of integer is identity
+LEVIN_INLINE uint64_t HashMix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdUL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53UL;
+    h ^= h >> 33;
+    return h;
+}
+
+// @brief x scaled into [0, n) by multiply-shift(Lemire fast range), high bits of x used, no division
+LEVIN_INLINE uint64_t FastRange64(uint64_t x, uint64_t n) {
+    return ((unsigned __int128)x * n) >> 64;
+}
+
+// @brief x % n by precomputed magic = UINT128_MAX / n + 1 (Lemire fastmod), exact for all 64-bit x and n > 0
+// 4 multiplications instead of 64-bit division
+LEVIN_INLINE uint64_t FastMod64(uint64_t x, unsigned __int128 magic, uint64_t n) {
+    unsigned __int128 lowbits = magic * x;
+    unsigned __int128 bottom = ((unsigned __int128)(uint64_t)lowbits * n) >> 64;
+    unsigned __int128 top = (lowbits >> 64) * n;
+    return (uint64_t)((bottom + top) >> 64);
+}
+
+// @brief keys of batched find(find_batch) resolved group by group, misses of a group overlapped
+static const size_t FIND_BATCH_GROUP = 64;
+// @brief bucket records prefetched up to this size in batched find
+static const size_t FIND_BATCH_PREFETCH_BYTES = 256;
+
+// @brief cache lines of [addr, addr + len) prefetched, len capped by FIND_BATCH_PREFETCH_BYTES
+LEVIN_INLINE void PrefetchRange(const void *addr, size_t len) {
+    const char *begin = (const char*)((size_t)addr & ~(size_t)63);
+    const char *end = (const char*)addr + std::min(len, FIND_BATCH_PREFETCH_BYTES);
+    for (const char *line = begin; line < end; line += 64) {
+        __builtin_prefetch(line);
+    }
+}
+
+// @brief reduction of hash into bucket of HashMap/HashSet/NestedHashMap, chosen at Dump
+// recorded in low byte of SharedFileHeader flags, binfiles of earlier versions are Mod(0)
+enum class BucketReduce : uint8_t {
+    Mod = 0,    // hash % bucket count, computed by fastmod
+    Pow2 = 1,   // mixed hash & (bucket count - 1), bucket count rounded up to power of 2
+};
+
+// @brief layout of bucket records of HashMap/NestedHashMap, chosen at Dump
+// recorded in 2nd low byte of SharedFileHeader flags, binfiles of earlier versions are Pair(0)
+enum class BucketLayout : uint8_t {
+    Pair = 0,   // records of pair<key, value>
+    Split = 1,  // keys of all records followed by their values, see SplitRecords
+};
+
+// @brief bucket count, reduction and record layout of hashed containers, passed to Dump/builder
+struct BucketOptions {
+    BucketReduce reduce;
+    // keys per bucket, 0: default bucket count of container
+    double load_factor;
+    // bucket count, overrides load_factor if NOT 0
+    size_t bucket_count;
+    // HashMap/NestedHashMap only
+    BucketLayout layout;
+
+    BucketOptions(BucketReduce reduce_ = BucketReduce::Mod, double load_factor_ = 0, size_t bucket_count_ = 0,
+            BucketLayout layout_ = BucketLayout::Pair) :
+            reduce(reduce_), load_factor(load_factor_), bucket_count(bucket_count_), layout(layout_) {
+    }
+};
+
+// @brief records area of n pair<Key, Value> in split layout, the same size and bucket headers as pair layout:
+// keys of records in bucket order, then values aligned in the same order, zero padded to n pairs,
+// so a lookup searches dense keys and touches one value only; record i is keys[i] and values[i]
+template <class Key, class Value>
+struct SplitRecords {
+    static size_t ValuesOffset(size_t n) {
+        return (n * sizeof(Key) + alignof(Value) - 1) / alignof(Value) * alignof(Value);
+    }
+    static const Key* Keys(const void *records) { return (const Key*)records; }
+    static const Value* Values(const void *records, size_t n) {
+        return (const Value*)((const char*)records + ValuesOffset(n));
+    }
+    static_assert(sizeof(std::pair<Key, Value>) >= sizeof(Key) + sizeof(Value), "split records exceed pairs");
+};
+
+// @brief bucket count of size keys by options, default_count if neither load factor nor bucket count set
+inline size_t BucketCountOf(const BucketOptions &options, size_t size, size_t default_count) {
+    size_t count = options.bucket_count;
+    if (count == 0) {
+        count = (options.load_factor > 0 ? (size_t)std::ceil(size / options.load_factor) : default_count);
+    }
+    count = std::max<size_t>(count, 1);
+    if (options.reduce == BucketReduce::Pow2) {
+        size_t pow2 = 1;
+        while (pow2 < count) {
+            pow2 <<= 1;
+        }
+        count = pow2;
+    }
+    return count;
+}
+
+// @brief hash to bucket index of bucket_count buckets by reduction, precomputed when container loaded
+class BucketReducer {
+public:
+    BucketReducer() : BucketReducer(BucketReduce::Mod, 1) {
+    }
+    BucketReducer(BucketReduce reduce, uint64_t bucket_count) :
+            _reduce(reduce),
+            _bucket_count(bucket_count),
+            _mask(bucket_count - 1),
+            _magic(~(unsigned __int128)0 / bucket_count + 1) {
+    }
+    LEVIN_INLINE uint64_t operator()(uint64_t hash) const {
+        if (_reduce == BucketReduce::Pow2) {
+            return HashMix64(hash) & _mask;
+        }
+        return FastMod64(hash, _magic, _bucket_count);
+    }
+    BucketReduce reduce() const { return _reduce; }
+    uint64_t bucket_count() const { return _bucket_count; }
+
+private:
+    BucketReduce _reduce;
+    uint64_t _bucket_count;
+    uint64_t _mask;
+    unsigned __int128 _magic;
+};
+
 // @brief shm checksum struct typedef
 typedef struct ChecksumInfo {
     void *area;
@@ -228,6 +377,27 @@ protected:
     static const uint64_t label_magic_num = 0x123456789;
 };
 
+// @brief region splitted into blocks, CRC32C of blocks computed in parallel by hardware crc32
+// cost scales with cores, block checksums folded into meta.checksum
+class BlockCrc32cChecker {
+public:
+    static const size_t BLOCK_SIZE = 4UL << 20;
+
+    bool operator()(const ChecksumInfo &info, SharedMeta *meta, bool is_upd = false) {
+        LEVIN_CDEBUG_LOG("BlockCrc32cChecker. area=%p, len=%ld", info.area, info.length);
+        std::string cur_sum;
+        if (!BlockCrc32c(info.area, info.length, BLOCK_SIZE, 0, cur_sum)) {
+            return false;
+        }
+        if (is_upd) {
+            strncpy(meta->checksum, cur_sum.c_str(), sizeof(meta->checksum) - 1);
+            meta->checksum[sizeof(meta->checksum) - 1] = '\0';
+            return true;
+        }
+        return cur_sum.compare(meta->checksum) == 0;
+    }
+};
+
 template <class Key, class Value>
 bool CMP(const std::pair<Key, Value> &a, const std::pair<Key, Value> &b) {
     return a.first < b.first;
@@ -250,6 +420,24 @@ static int32_t binary_search(const std::pair<Key, Value>* data, int right, Key k
     return -1;
 }
 
+// @brief position of key in sorted keys[0, right], -1 if NOT found
+template <class Key>
+static int32_t binary_search(const Key* keys, int right, Key key) {
+    int left = 0, mid;
+    while (left <= right) {
+        mid = (left + right) / 2;
+        if (keys[mid] == key) {
+            return mid;
+        }
+        if (keys[mid] < key) {
+            left = mid + 1;
+        } else {
+            right = mid - 1;
+        }
+    }
+    return -1;
+}
+
 template <class Key, class Value, class Compare>
 struct PairCompare {
     bool operator() (const std::pair<Key, Value> &data, const Key &key) const {
@@ -286,6 +474,15 @@ inline uint8_t VersionOfFlags(const uint64_t flags) {
 inline uint64_t makeFlags(uint8_t version) {
     return (uint64_t)(((uint64_t)version << 56) | 0x0);
 }
+inline BucketReduce ReduceOfFlags(const uint64_t flags) {
+    return (BucketReduce)(flags & 0xff);
+}
+inline BucketLayout LayoutOfFlags(const uint64_t flags) {
+    return (BucketLayout)((flags >> 8) & 0xff);
+}
+inline uint64_t makeFlags(uint8_t version, BucketReduce reduce, BucketLayout layout = BucketLayout::Pair) {
+    return makeFlags(version) | (uint64_t)reduce | ((uint64_t)layout << 8);
+}
 
 }  // namespace levin
 
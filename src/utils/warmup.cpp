@@ -0,0 +1,79 @@
+#include "warmup.h"
+#include <errno.h>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "parallel_utils.h"
+#include "levin_logger.h"
+#include "levin_timer.hpp"
+
+namespace levin {
+
+static const size_t WARMUP_CHUNK_SIZE = 64UL << 20;
+
+// @brief read one byte of every page in [addr, addr + len)
+static bool TouchPages(const char *addr, size_t len, size_t page_size, const boost::atomic<bool> *stop) {
+    const char *end = addr + len;
+    const char *page = addr;
+    while (page < end) {
+        if (stop != nullptr && *stop) {
+            return false;
+        }
+        const char *chunk_end = std::min(page + WARMUP_CHUNK_SIZE, end);
+        for (; page < chunk_end; page = (const char*)(((size_t)page + page_size) / page_size * page_size)) {
+            (void)*(volatile const char*)page;
+        }
+    }
+    return true;
+}
+
+static bool PopulatePages(const char *addr, size_t len, size_t page_size, const boost::atomic<bool> *stop) {
+    char *lower = (char*)((size_t)addr / page_size * page_size);
+    size_t length = addr + len - lower;
+#ifdef MADV_POPULATE_READ
+    if (madvise(lower, length, MADV_POPULATE_READ) == 0) {
+        return true;
+    }
+#endif
+    // kernel before 5.14: readahead file-backed pages, then fault in by touch
+    (void)madvise(lower, length, MADV_WILLNEED);
+    return TouchPages(addr, len, page_size, stop);
+}
+
+bool WarmupRegion(const std::string &path, const void *addr, size_t len,
+        const ContainerOptions &options, const boost::atomic<bool> *stop) {
+    if (addr == nullptr || len == 0 || (options.warmup == WarmupPolicy::None && !options.warmup_lock)) {
+        return true;
+    }
+    const char *base = static_cast<const char*>(addr);
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    TimerGuard tg(path, __func__, len);
+    bool succ = true;
+    switch (options.warmup) {
+    case WarmupPolicy::None:
+        break;
+    case WarmupPolicy::Sequential:
+        succ = TouchPages(base, len, page_size, stop);
+        break;
+    case WarmupPolicy::Parallel:
+        succ = ParallelRun((len + WARMUP_CHUNK_SIZE - 1) / WARMUP_CHUNK_SIZE, options.warmup_threads,
+                [=](size_t idx) {
+                    size_t offset = idx * WARMUP_CHUNK_SIZE;
+                    return TouchPages(base + offset, std::min(WARMUP_CHUNK_SIZE, len - offset), page_size, stop);
+                });
+        break;
+    case WarmupPolicy::Populate:
+        succ = PopulatePages(base, len, page_size, stop);
+        break;
+    default:
+        LEVIN_CWARNING_LOG("Invalid warmup policy, policy=%d", (int)options.warmup);
+        return false;
+    }
+    if (succ && options.warmup_lock && mlock(addr, len) != 0) {
+        // RLIMIT_MEMLOCK exceeded or no CAP_IPC_LOCK, pages warm but NOT locked
+        LEVIN_CWARNING_LOG("mlock fail. path=%s, len=%lu, errno=%d", path.c_str(), len, errno);
+    }
+    return succ;
+}
+
+}  // namespace levin
@@ -0,0 +1,21 @@
+#ifndef LEVIN_WARMUP_H
+#define LEVIN_WARMUP_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+#include <boost/atomic.hpp>
+#include "container_options.h"
+
+namespace levin {
+
+// @brief fault in pages of region [addr, addr + len) by options.warmup policy,
+// and lock them in memory if options.warmup_lock
+// warm-up stops early once stop is set, time cost and throughput are logged with path
+// retval succ: true fail or stopped: false (Never throws)
+bool WarmupRegion(const std::string &path, const void *addr, size_t len,
+        const ContainerOptions &options, const boost::atomic<bool> *stop = nullptr);
+
+}  // namespace levin
+
+#endif  // LEVIN_WARMUP_H
@@ -8,6 +8,10 @@
 #include <boost/noncopyable.hpp>
 #include "levin_logger.h"
 
+#ifndef SHM_HUGE_SHIFT
+#define SHM_HUGE_SHIFT 26
+#endif
+
 namespace levin {
 
 // @brief XSI shm create mode enum typedef
@@ -26,8 +30,10 @@ public:
     }
 
     // @brief allocates a shared memory segment
+    // huge_page_size > 0 means segment created with SHM_HUGETLB of the specified page size
     // retval succ: 0 fail: errno (Never throws)
-    int open(XsiShmCreateMode mode, key_t key, size_t size = 0, int shmperm = 0644);
+    int open(XsiShmCreateMode mode, key_t key, size_t size = 0, int shmperm = 0644,
+            size_t huge_page_size = 0);
 
     // @biref erase the XSI shared memory object identified by shmid from the system
     // retval succ: true fail: false (Never throws)
@@ -39,9 +45,14 @@ protected:
     int _shmid = -1;
 };
 
-inline int XsiSharedMemory::open(XsiShmCreateMode mode, key_t key, size_t size, int shmperm) {
+inline int XsiSharedMemory::open(XsiShmCreateMode mode, key_t key, size_t size, int shmperm,
+        size_t huge_page_size) {
     int shmflg = shmperm;
     shmflg &= 0x01FF;
+    if (huge_page_size > 0) {
+        // page size encoded as log2 in flags, see shmget(2)
+        shmflg |= SHM_HUGETLB | (__builtin_ctzl(huge_page_size) << SHM_HUGE_SHIFT);
+    }
     switch (mode) {
     case XsiShmCreateMode::Open:
         shmflg |= 0;
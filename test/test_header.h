@@ -2,6 +2,8 @@
 #define __LEVIN_TEST_HEADER_H__
 
 #include <sys/types.h>
+#include <fstream>
+#include <iterator>
 #include <gtest/gtest.h>
 #include "shared_memory.hpp"
 #include "levin_logger.h"
@@ -50,6 +52,12 @@ void CleanEnvShm(std::vector<std::string> names) {
     }
 }
 
+// @brief whole content of file, for byte comparison of dumped files
+inline std::string read_file(const std::string &file) {
+    std::ifstream fin(file, std::ios::in | std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
 }  // namespace levin
 
 #endif  // __LEVIN_TEST_HEADER_H__
@@ -2,6 +2,7 @@
 #include "smap.hpp"
 #include "shashset.hpp"
 #include "shashmap.hpp"
+#include "svec.hpp"
 #include <set>
 #include <map>
 #include <unordered_set>
@@ -155,6 +156,21 @@ TEST_F(HeapMemoryTest, test_Load_nestvec) {
     }
 }
 
+TEST_F(HeapMemoryTest, test_huge_page) {
+    std::string name = "./heap_huge_page_vec.dat";
+    std::vector<uint64_t> in(100000, 7);
+    EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    levin::SharedVector<uint64_t, HeapMemory> vec(name);
+    ContainerOptions options;
+    options.huge_page_size = 2UL << 20;
+    vec.SetOptions(options);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_EQ((size_t)vec._info->_mem->get_address() % options.huge_page_size, 0);
+    EXPECT_EQ(vec._info->_mem->reserved_size(), options.huge_page_size);
+    EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
@@ -7,6 +7,8 @@
 #include <gtest/gtest.h>
 #include <memory>
 #include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <iostream>
 
 namespace levin {
@@ -123,6 +125,272 @@ TEST_F(SharedManagerTest, test_manager) {
     EXPECT_TRUE(shmid_info.size() == 0);
 }
 
+TEST_F(SharedManagerTest, test_register_options) {
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    ContainerOptions options;
+    options.load_threads = 2;
+    options.load_chunk_size = 8;
+    manager_ptr->SetOptions(options);
+    EXPECT_EQ(manager_ptr->GetOptions().load_threads, 2);
+
+    std::shared_ptr<SharedVector<int> > vec_ptr;
+    std::shared_ptr<SharedMap<int, int> > map_ptr;
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr), SC_RET_OK);
+    EXPECT_EQ(vec_ptr->GetOptions().load_chunk_size, 8);
+    EXPECT_EQ(vec_ptr->size(), 5);
+    // options specified per container
+    options.load_threads = 3;
+    EXPECT_EQ(manager_ptr->Register(TEST_MAP_PATH, map_ptr, options), SC_RET_OK);
+    EXPECT_EQ(map_ptr->GetOptions().load_threads, 3);
+    EXPECT_EQ(map_ptr->at(2), 20);
+
+    manager_ptr->Release();
+    manager_ptr.reset();
+    vec_ptr.reset();
+    map_ptr.reset();
+    sleep(2);
+}
+
+TEST_F(SharedManagerTest, test_register_read_only) {
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    ContainerOptions options;
+    options.read_only = true;
+    manager_ptr->SetOptions(options);
+    // reader never loads missing container
+    std::shared_ptr<SharedVector<int> > vec_ptr;
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr), SC_RET_SHM_NOEXIST);
+    EXPECT_EQ(SharedContainerManager::GetContanerPtr(TEST_VEC_PATH, vec_ptr), SC_RET_NO_REGISTER);
+
+    // loaded by writer, attached read only by reader
+    char path[PATH_MAX] = {0};
+    ASSERT_TRUE(realpath(TEST_VEC_PATH, path) != nullptr);
+    SharedVector<int> writer(path, TEST_GROUP_ID, TEST_APP_ID);
+    ASSERT_EQ(writer.Init(), SC_RET_OK);
+    ASSERT_EQ(writer.Load(), SC_RET_OK);
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr), SC_RET_OK);
+    EXPECT_TRUE(vec_ptr->IsExist());
+    EXPECT_EQ(vec_ptr->size(), 5);
+    EXPECT_EQ((*vec_ptr)[4], 5);
+    EXPECT_NE((void*)&(*vec_ptr)[0], (void*)&writer[0]);
+
+    // reader released, shm detached but NOT removed
+    manager_ptr->Release();
+    manager_ptr.reset();
+    vec_ptr.reset();
+    sleep(2);
+    int shmid = 0;
+    EXPECT_TRUE(IdManager::GetInstance().GetId(path, shmid));
+    EXPECT_EQ(writer[4], 5);
+    writer.Destroy();
+    EXPECT_FALSE(IdManager::GetInstance().GetId(path, shmid));
+}
+
+TEST_F(SharedManagerTest, test_register_verify_in_load) {
+    char path[PATH_MAX] = {0};
+    ASSERT_TRUE(realpath(TEST_VEC_PATH, path) != nullptr);
+    std::string md5;
+    ASSERT_TRUE(GetFileMD5(path, md5));
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    // mismatched md5 NOT checked by VerifyFiles, but by Register in load
+    std::map<std::string, std::string> verify_data = {{TEST_VEC_PATH, "0123456789abcdef0123456789abcdef"}};
+    EXPECT_EQ(SharedContainerManager::VerifyFiles(verify_data, CheckFileMD5, TEST_APP_ID, true), SC_RET_OK);
+    std::shared_ptr<SharedVector<int> > vec_ptr;
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr), SC_RET_FILE_CHECK);
+
+    verify_data[TEST_VEC_PATH] = md5;
+    EXPECT_EQ(SharedContainerManager::VerifyFiles(verify_data, CheckFileMD5, TEST_APP_ID, true), SC_RET_OK);
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr), SC_RET_OK);
+    EXPECT_EQ(vec_ptr->GetOptions().load_md5, md5);
+    EXPECT_EQ(vec_ptr->size(), 5);
+    EXPECT_TRUE(SharedContainerManager::_has_checked_file_list.count(path) > 0);
+
+    manager_ptr->Release();
+    manager_ptr.reset();
+    vec_ptr.reset();
+    sleep(2);
+}
+
+TEST_F(SharedManagerTest, test_verify_digest_cache) {
+    DigestCache &cache = DigestCache::GetInstance();
+    std::string dir = "./levin_digest_cache_test";
+    cache.SetDir(dir);
+    std::string name = "./digest_cache_vec.dat";
+    std::vector<int> in(1000, 2);
+    ASSERT_TRUE(SharedVector<int>::Dump(name, in));
+    std::string md5;
+    ASSERT_TRUE(GetFileMD5(name, md5));
+    EXPECT_FALSE(cache.IsVerified(name, md5));
+    EXPECT_TRUE(CheckFileMD5(name, md5));
+    EXPECT_TRUE(cache.IsVerified(name, md5));
+    EXPECT_FALSE(cache.IsVerified(name, "0123456789abcdef0123456789abcdef"));
+    // identity keyed entry: hit without read, mismatched md5 still fails
+    FileIdentity identity;
+    ASSERT_TRUE(GetFileIdentity(name, identity));
+    EXPECT_EQ(access(cache.entry_path(identity).c_str(), R_OK), 0);
+    EXPECT_FALSE(CheckFileMD5(name, "0123456789abcdef0123456789abcdef"));
+    // file touched: identity changed, verified again
+    struct timespec times[2] = {{0, UTIME_OMIT}, {12345, 0}};
+    ASSERT_EQ(utimensat(AT_FDCWD, name.c_str(), times, 0), 0);
+    EXPECT_FALSE(cache.IsVerified(name, md5));
+    EXPECT_TRUE(SharedContainerManager::VerifyFiles({{name, md5}}) == SC_RET_OK);
+    EXPECT_TRUE(cache.IsVerified(name, md5));
+    // stale identity never cached
+    EXPECT_FALSE(cache.SetVerified(name, md5, FileIdentity()));
+
+    cache.SetDir("");
+    EXPECT_FALSE(cache.IsVerified(name, md5));
+    cache.SetDir(DigestCache::DEFAULT_DIR);
+    EXPECT_EQ(system(("rm -rf " + dir).c_str()), 0);
+}
+
+TEST_F(SharedManagerTest, test_register_verify_lazy) {
+    typedef SharedVector<int, SharedMemory, BlockCrc32cChecker> CrcVec;
+    std::string name = "./manager_lazy_vec.dat";
+    std::vector<int> in(100000, 3);
+    ASSERT_TRUE(SharedVector<int>::Dump(name, in));
+    char path[PATH_MAX] = {0};
+    ASSERT_TRUE(realpath(name.c_str(), path) != nullptr);
+    // region loaded then corrupted
+    CrcVec vec(path, TEST_GROUP_ID, TEST_APP_ID);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    const_cast<int&>(vec[12345]) = 4;
+
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    ContainerOptions options;
+    options.verify_lazy = true;
+    std::shared_ptr<CrcVec> vec_ptr;
+    ASSERT_EQ(manager_ptr->Register(name, vec_ptr, options), SC_RET_OK);
+    EXPECT_TRUE(vec_ptr->IsExist());
+    // quarantined in background, reloaded by clear process and replaced
+    std::shared_ptr<CrcVec> reload_ptr;
+    for (int i = 0; i < 50; ++i) {
+        if (SharedContainerManager::GetContanerPtr(name, reload_ptr) == SC_RET_OK && reload_ptr != vec_ptr) {
+            break;
+        }
+        usleep(100000);
+    }
+    EXPECT_TRUE(vec_ptr->IsCorrupted());
+    ASSERT_NE(reload_ptr, vec_ptr);
+    EXPECT_FALSE(reload_ptr->IsExist());
+    EXPECT_EQ((*reload_ptr)[12345], 3);
+
+    manager_ptr->Release();
+    manager_ptr.reset();
+    vec_ptr.reset();
+    reload_ptr.reset();
+    vec.Destroy();
+    sleep(2);
+}
+
+TEST_F(SharedManagerTest, test_register_numa_replica) {
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    ContainerOptions options;
+    options.numa_policy = NumaPolicy::Replicate;
+    std::shared_ptr<SharedVector<int> > vec_ptr;
+    EXPECT_EQ(manager_ptr->Register(TEST_VEC_PATH, vec_ptr, options), SC_RET_OK);
+    EXPECT_EQ(vec_ptr->size(), 5);
+    EXPECT_EQ(vec_ptr->GetOptions().numa_node, CurrentNumaNode());
+    // one replica per node, handle resolved to local replica
+    std::shared_ptr<SharedVector<int> > local_ptr;
+    EXPECT_EQ(SharedContainerManager::GetContanerPtr(TEST_VEC_PATH, local_ptr), SC_RET_OK);
+    EXPECT_EQ(local_ptr, vec_ptr);
+    EXPECT_EQ(manager_ptr->_local_container_map.size(), (size_t)NumaNodeNum());
+
+    manager_ptr->Release();
+    manager_ptr.reset();
+    vec_ptr.reset();
+    local_ptr.reset();
+    sleep(2);
+    std::vector<SharedMidInfo> shmid_info;
+    SharedMemory::get_all_shmid(shmid_info);
+    for (const auto &info : shmid_info) {
+        EXPECT_EQ(NumaReplicaPath(info.path), info.path);
+    }
+}
+
+TEST_F(SharedManagerTest, test_publish) {
+    std::shared_ptr<SharedContainerManager> manager_ptr(
+            new SharedContainerManager(TEST_GROUP_ID, TEST_APP_ID));
+    typedef SharedHashMap<uint64_t, uint64_t> Map;
+    std::string name = "./manager_publish_map";
+    std::string export_file = "./manager_publish_map.dat";
+    unlink(export_file.c_str());
+    SharedHashMapBuilder<uint64_t, uint64_t> builder;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        builder.Add(i, i * 2);
+    }
+    std::shared_ptr<Map> map_ptr;
+    ASSERT_EQ(manager_ptr->Publish(name, builder, map_ptr, export_file), SC_RET_OK);
+    EXPECT_EQ(builder.size(), 0);
+    EXPECT_TRUE(map_ptr->IsVerified());
+    std::shared_ptr<Map> got_ptr;
+    ASSERT_EQ(SharedContainerManager::GetContanerPtr(name, got_ptr), SC_RET_OK);
+    EXPECT_EQ(got_ptr, map_ptr);
+    EXPECT_EQ(got_ptr->size(), 1000);
+    EXPECT_EQ(got_ptr->at(999), 1998);
+
+    // attached by another container of the same name, as if loaded from binfile
+    {
+        char path[PATH_MAX] = {0};
+        ASSERT_TRUE(realpath(".", path) != nullptr);
+        Map reader(std::string(path) + name.substr(1), TEST_GROUP_ID, TEST_APP_ID);
+        ContainerOptions options;
+        options.read_only = true;
+        reader.SetOptions(options);
+        ASSERT_EQ(reader.Init(), SC_RET_OK);
+        EXPECT_EQ(reader.at(10), 20);
+        reader.Destroy();
+    }
+
+    // exported in background, loadable as binfile
+    for (int i = 0; i < 50 && access(export_file.c_str(), R_OK) != 0; ++i) {
+        usleep(100000);
+    }
+    {
+        Map exported(export_file);
+        ASSERT_EQ(exported.Init(), SC_RET_OK);
+        ASSERT_EQ(exported.Load(), SC_RET_OK);
+        EXPECT_EQ(exported.size(), 1000);
+        EXPECT_EQ(exported.at(500), 1000);
+        exported.Destroy();
+    }
+
+    // republished: replaced, readers keep the old one
+    for (uint64_t i = 0; i < 10; ++i) {
+        builder.Add(i, i * 3);
+    }
+    std::shared_ptr<Map> new_ptr;
+    ASSERT_EQ(manager_ptr->Publish(name, builder, new_ptr), SC_RET_OK);
+    EXPECT_EQ(got_ptr->at(999), 1998);
+    std::shared_ptr<Map> new_got_ptr;
+    ASSERT_EQ(SharedContainerManager::GetContanerPtr(name, new_got_ptr), SC_RET_OK);
+    EXPECT_EQ(new_got_ptr->size(), 10);
+    EXPECT_EQ(new_got_ptr->at(9), 27);
+    EXPECT_EQ(manager_ptr->_local_container_map.size(), 1);
+
+    // vector built in place
+    std::shared_ptr<SharedVector<int> > vec_ptr;
+    std::vector<int> vec = {1, 2, 3};
+    ASSERT_EQ(manager_ptr->Publish("./manager_publish_vec", vec, vec_ptr), SC_RET_OK);
+    EXPECT_EQ(vec_ptr->size(), 3);
+    EXPECT_EQ((*vec_ptr)[2], 3);
+
+    manager_ptr->Release();
+    manager_ptr.reset();
+    map_ptr.reset();
+    got_ptr.reset();
+    new_ptr.reset();
+    new_got_ptr.reset();
+    vec_ptr.reset();
+    sleep(2);
+}
+
 } // namespace levin
 
 int main(int argc, char** argv) {
@@ -0,0 +1,112 @@
+#include "svec.hpp"
+#include "shashmap.hpp"
+#include "snested_hashmap.hpp"
+#include <vector>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class MappedFileTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+    }
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(MappedFileTest, test_svec) {
+    std::string name = "./mapped_vec.dat";
+    std::vector<uint64_t> in = {1, 3, 5, 7, 9, 11, 13};
+    EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    {
+        levin::SharedVector<uint64_t, MappedFileMemory, Md5Checker> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_FALSE(vec.IsExist());
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        ASSERT_EQ(vec.size(), in.size());
+        for (size_t i = 0; i < in.size(); ++i) {
+            EXPECT_EQ(vec[i], in[i]);
+        }
+        LEVIN_CDEBUG_LOG("%s", vec.layout().c_str());
+        // export from mapped region, same as origin binfile
+        EXPECT_TRUE(vec.Export("./mapped_vec_export.dat"));
+        vec.Destroy();
+    }
+    {
+        levin::SharedVector<uint64_t, MappedFileMemory> vec("./mapped_vec_export.dat");
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    }
+}
+
+TEST_F(MappedFileTest, test_shared_pages) {
+    std::string name = "./mapped_shared_pages.dat";
+    std::unordered_map<uint32_t, uint64_t> in;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        in[i * 7] = i;
+    }
+    EXPECT_TRUE((levin::SharedHashMap<uint32_t, uint64_t>::Dump(name, in)));
+    // two containers map the same binfile
+    levin::SharedHashMap<uint32_t, uint64_t, std::hash<uint32_t>, MappedFileMemory> map1(name);
+    levin::SharedHashMap<uint32_t, uint64_t, std::hash<uint32_t>, MappedFileMemory> map2(name);
+    ASSERT_EQ(map1.Init(), SC_RET_OK);
+    ASSERT_EQ(map1.Load(), SC_RET_OK);
+    ASSERT_EQ(map2.Init(), SC_RET_OK);
+    ASSERT_EQ(map2.Load(), SC_RET_OK);
+    EXPECT_EQ(map1.size(), in.size());
+    for (const auto &kv : in) {
+        ASSERT_EQ(map1.at(kv.first), kv.second);
+        ASSERT_EQ(map2.at(kv.first), kv.second);
+    }
+    EXPECT_TRUE(map1.find(1) == map1.end());
+}
+
+TEST_F(MappedFileTest, test_nested_hashmap) {
+    std::string name = "./mapped_nested_hashmap.dat";
+    std::unordered_map<uint32_t, std::vector<uint32_t> > in = {
+        {1, {1, 2, 3}}, {7, {}}, {100, {7, 7, 7, 7}}
+    };
+    EXPECT_TRUE((levin::SharedNestedHashMap<uint32_t, uint32_t>::Dump(name, in)));
+    levin::SharedNestedHashMap<uint32_t, uint32_t, std::hash<uint32_t>, MappedFileMemory> nmap(name);
+    ASSERT_EQ(nmap.Init(), SC_RET_OK);
+    ASSERT_EQ(nmap.Load(), SC_RET_OK);
+    for (const auto &kv : in) {
+        auto *row = nmap[kv.first];
+        ASSERT_EQ(row->size(), kv.second.size());
+        EXPECT_TRUE(std::equal(row->begin(), row->end(), kv.second.begin()));
+    }
+}
+
+TEST_F(MappedFileTest, test_load_fail) {
+    // no exist
+    {
+        levin::SharedVector<uint64_t, MappedFileMemory> vec("./mapped_no_exist.dat");
+        EXPECT_EQ(vec.Init(), SC_RET_FILE_NOEXIST);
+    }
+    // type hash not match
+    {
+        std::string name = "./mapped_type.dat";
+        EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, std::vector<uint64_t>({1, 2})));
+        levin::SharedVector<uint32_t, MappedFileMemory> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_EQ(vec.Load(), SC_RET_LOAD_FAIL);
+    }
+    // truncated file
+    {
+        std::string name = "./mapped_truncated.dat";
+        EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, std::vector<uint64_t>({1, 2, 3})));
+        EXPECT_EQ(truncate(name.c_str(), sizeof(SharedFileHeader) + 8), 0);
+        levin::SharedVector<uint64_t, MappedFileMemory> vec(name);
+        EXPECT_EQ(vec.Init(), SC_RET_READ_FAIL);
+    }
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
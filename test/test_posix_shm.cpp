@@ -0,0 +1,104 @@
+#include "svec.hpp"
+#include "shashmap.hpp"
+#include <vector>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class PosixShmTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+    }
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(PosixShmTest, test_shm_name) {
+    std::string name = PosixSharedMemory::shm_name("./posix_vec.dat", "default", 1);
+    EXPECT_EQ(name.find("/levin."), 0);
+    EXPECT_EQ(name, PosixSharedMemory::shm_name("./posix_vec.dat", "default", 1));
+    EXPECT_NE(name, PosixSharedMemory::shm_name("./posix_vec.dat", "default", 2));
+    EXPECT_NE(name, PosixSharedMemory::shm_name("./posix_vec.dat", "other", 1));
+    EXPECT_NE(name, PosixSharedMemory::shm_name("./posix_map.dat", "default", 1));
+}
+
+TEST_F(PosixShmTest, test_svec) {
+    std::string name = "./posix_vec.dat";
+    std::vector<uint64_t> in = {1, 3, 5, 7, 9, 11, 13};
+    EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    levin::SharedVector<uint64_t, PosixSharedMemory, Md5Checker> vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_FALSE(vec.IsExist());
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    // found again by name, no reload
+    {
+        levin::SharedVector<uint64_t, PosixSharedMemory, Md5Checker> other(name);
+        ASSERT_EQ(other.Init(), SC_RET_OK);
+        EXPECT_TRUE(other.IsExist());
+        ASSERT_EQ(other.Load(), SC_RET_OK);
+        EXPECT_TRUE(std::equal(other.begin(), other.end(), in.begin()));
+        EXPECT_NE((void*)other.begin(), (void*)vec.begin());
+    }
+    // reader attaches read only, never creates
+    {
+        ContainerOptions options;
+        options.read_only = true;
+        levin::SharedVector<uint64_t, PosixSharedMemory, Md5Checker> reader(name);
+        reader.SetOptions(options);
+        ASSERT_EQ(reader.Init(), SC_RET_OK);
+        EXPECT_TRUE(reader.IsExist());
+        EXPECT_TRUE(std::equal(reader.begin(), reader.end(), in.begin()));
+        reader.Destroy();
+        levin::SharedVector<uint64_t, PosixSharedMemory, Md5Checker> missing(name, "other_group");
+        missing.SetOptions(options);
+        EXPECT_EQ(missing.Init(), SC_RET_SHM_NOEXIST);
+    }
+    // different group, different shm
+    {
+        levin::SharedVector<uint64_t, PosixSharedMemory, Md5Checker> other(name, "other_group");
+        ASSERT_EQ(other.Init(), SC_RET_OK);
+        EXPECT_FALSE(other.IsExist());
+        other.Destroy();
+    }
+    std::string shm_file = "/dev/shm" + PosixSharedMemory::shm_name(name, "default", 1);
+    EXPECT_EQ(access(shm_file.c_str(), F_OK), 0);
+    vec.Destroy();
+    EXPECT_NE(access(shm_file.c_str(), F_OK), 0);
+}
+
+TEST_F(PosixShmTest, test_stale_shm) {
+    std::string name = "./posix_map.dat";
+    std::unordered_map<uint32_t, uint64_t> in = {{1, 10}, {2, 20}};
+    EXPECT_TRUE((levin::SharedHashMap<uint32_t, uint64_t>::Dump(name, in)));
+    levin::SharedHashMap<uint32_t, uint64_t, std::hash<uint32_t>, PosixSharedMemory> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    // binfile changed, size mismatched shm recreated
+    for (uint32_t i = 0; i < 1000; ++i) {
+        in[i] = i * 10;
+    }
+    EXPECT_TRUE((levin::SharedHashMap<uint32_t, uint64_t>::Dump(name, in)));
+    levin::SharedHashMap<uint32_t, uint64_t, std::hash<uint32_t>, PosixSharedMemory> other(name);
+    ASSERT_EQ(other.Init(), SC_RET_OK);
+    EXPECT_FALSE(other.IsExist());
+    ASSERT_EQ(other.Load(), SC_RET_OK);
+    EXPECT_EQ(other.size(), in.size());
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at(2), 20);
+    // stale one NOT unlink the recreated shm
+    map.Destroy();
+    std::string shm_file = "/dev/shm" + PosixSharedMemory::shm_name(name, "default", 1);
+    EXPECT_EQ(access(shm_file.c_str(), F_OK), 0);
+    other.Destroy();
+    EXPECT_NE(access(shm_file.c_str(), F_OK), 0);
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+#include "svec.hpp"
+#include "snested_hashmap.hpp"
+#include <vector>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class SegmentedShmTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        _options.shm_segment_size = 64UL << 10;
+    }
+    virtual void TearDown() {
+    }
+
+    ContainerOptions _options;
+};
+
+TEST_F(SegmentedShmTest, test_segment_key) {
+    key_t key = SegmentedSharedMemory::segment_key("./seg_vec.dat", 1);
+    EXPECT_NE(key, IPC_PRIVATE);
+    EXPECT_EQ(key, SegmentedSharedMemory::segment_key("./seg_vec.dat", 1));
+    EXPECT_NE(key, SegmentedSharedMemory::segment_key("./seg_vec.dat", 2));
+    EXPECT_NE(key, SegmentedSharedMemory::segment_key("./seg_map.dat", 1));
+}
+
+TEST_F(SegmentedShmTest, test_svec) {
+    std::string name = "./seg_vec.dat";
+    std::vector<uint64_t> in;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        in.push_back(i * 3);
+    }
+    EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    levin::SharedVector<uint64_t, SegmentedSharedMemory, Md5Checker> vec(name);
+    vec.SetOptions(_options);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_FALSE(vec.IsExist());
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_EQ(vec._info->_mem->segment_num(), 13);
+    EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    // found again by name, segments attached contiguously at another address, no reload
+    {
+        levin::SharedVector<uint64_t, SegmentedSharedMemory, Md5Checker> other(name);
+        other.SetOptions(_options);
+        ASSERT_EQ(other.Init(), SC_RET_OK);
+        EXPECT_TRUE(other.IsExist());
+        ASSERT_EQ(other.Load(), SC_RET_OK);
+        EXPECT_EQ(other._info->_mem->segment_num(), 13);
+        EXPECT_TRUE(std::equal(other.begin(), other.end(), in.begin()));
+        EXPECT_NE((void*)other.begin(), (void*)vec.begin());
+    }
+    vec.Destroy();
+    EXPECT_EQ(shmget(SegmentedSharedMemory::segment_key(name, 1), 0, 0), -1);
+    EXPECT_EQ(shmget(SegmentedSharedMemory::segment_key(name, 12), 0, 0), -1);
+}
+
+TEST_F(SegmentedShmTest, test_nested_hashmap) {
+    std::string name = "./seg_map.dat";
+    std::unordered_map<uint32_t, std::vector<uint32_t> > in;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        in[i] = std::vector<uint32_t>(i % 10 + 1, i);
+    }
+    EXPECT_TRUE((levin::SharedNestedHashMap<uint32_t, uint32_t>::Dump(name, in)));
+    levin::SharedNestedHashMap<uint32_t, uint32_t, std::hash<uint32_t>, SegmentedSharedMemory> map(name);
+    map.SetOptions(_options);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    EXPECT_GT(map._info->_mem->segment_num(), 1);
+    ASSERT_EQ(map.size(), in.size());
+    for (const auto &pair : in) {
+        auto it = map.find(pair.first);
+        ASSERT_TRUE(it != map.end());
+        EXPECT_TRUE(std::equal(it->second->begin(), it->second->end(), pair.second.begin()));
+    }
+    map.Destroy();
+}
+
+TEST_F(SegmentedShmTest, test_segment_removed) {
+    std::string name = "./seg_vec.dat";
+    std::vector<uint64_t> in(50000, 7);
+    EXPECT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    int shmid = IPC_PRIVATE;
+    {
+        levin::SharedVector<uint64_t, SegmentedSharedMemory> vec(name);
+        vec.SetOptions(_options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_TRUE(vec._info->_mem->verify());
+        shmid = static_cast<SegmentedSharedMemory*>(vec._info->_mem.get())->get_shmid();
+        // following segment removed by others, region no longer a whole
+        int seg_shmid = shmget(SegmentedSharedMemory::segment_key(name, 3), 0, 0);
+        ASSERT_NE(seg_shmid, -1);
+        EXPECT_TRUE(XsiSharedMemory::remove(seg_shmid));
+        EXPECT_FALSE(vec._info->_mem->verify());
+    }
+    // removed by shmid of the first segment, following segments removed together
+    EXPECT_TRUE(SharedMemory::remove_shared_memory(shmid));
+    EXPECT_EQ(shmget(SegmentedSharedMemory::segment_key(name, 1), 0, 0), -1);
+}
+
+TEST_F(SegmentedShmTest, test_max_size) {
+    SegmentedSharedMemory mem("./seg_vec.dat");
+    mem.set_options(_options);
+    EXPECT_EQ(mem.max_size(), _options.shm_segment_size * SegmentedSharedMemory::MAX_SEGMENT_NUM);
+    ContainerOptions options;
+    mem.set_options(options);
+    EXPECT_GE(mem.max_size(), MAX_MEM_SIZE);
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
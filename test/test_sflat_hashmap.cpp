@@ -0,0 +1,169 @@
+#include "sflat_hashmap.hpp"
+#include "sflat_hashset.hpp"
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class SharedFlatHashMapTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+    }
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(SharedFlatHashMapTest, test_group_probe) {
+    int8_t ctrl[FLAT_GROUP_WIDTH];
+    memset(ctrl, FLAT_CTRL_EMPTY, sizeof(ctrl));
+    ctrl[0] = 5;
+    ctrl[3] = 5;
+    ctrl[15] = 127;
+    EXPECT_EQ(FlatGroupMatch(ctrl, 5), (1U << 0) | (1U << 3));
+    EXPECT_EQ(FlatGroupMatch(ctrl, 127), 1U << 15);
+    EXPECT_EQ(FlatGroupMatch(ctrl, 6), 0U);
+    EXPECT_EQ(FlatGroupMatchEmpty(ctrl), 0xffffU & ~((1U << 0) | (1U << 3) | (1U << 15)));
+    // at least one empty slot left by max load factor
+    for (size_t n = 0; n < 1000; ++n) {
+        size_t groups = FlatHashMap<int, int>::GroupCount(n);
+        EXPECT_GT(groups * FLAT_GROUP_WIDTH, n);
+        EXPECT_LT((groups - 1) * FLAT_GROUP_WIDTH, n + n / 4 + 1);
+    }
+}
+
+TEST_F(SharedFlatHashMapTest, test_static_Dump_Load_empty) {
+    std::string name = "./flat_hashmap_empty.dat";
+    std::unordered_map<uint64_t, uint32_t> in;
+    EXPECT_TRUE((SharedFlatHashMap<uint64_t, uint32_t>::Dump(name, in)));
+    SharedFlatHashMap<uint64_t, uint32_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+    EXPECT_TRUE(map.find(1) == map.end());
+    EXPECT_EQ(map.count(1), 0);
+    EXPECT_THROW(map.at(1), std::out_of_range);
+    map.Destroy();
+}
+
+TEST_F(SharedFlatHashMapTest, test_Dump_Load) {
+    std::string name = "./flat_hashmap.dat";
+    std::unordered_map<uint64_t, uint32_t> in;
+    // multiples of 128: low bits of identity hash all the same
+    for (uint64_t i = 0; i < 10000; ++i) {
+        in[i * 128] = i + 100;
+    }
+    ASSERT_TRUE((SharedFlatHashMap<uint64_t, uint32_t>::Dump(name, in)));
+    SharedFlatHashMap<uint64_t, uint32_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    LEVIN_CDEBUG_LOG("%s", map.layout().c_str());
+    ASSERT_EQ(map.size(), in.size());
+    EXPECT_LE(map.load_factor(), 0.8);
+    for (const auto &kv : in) {
+        auto it = map.find(kv.first);
+        ASSERT_TRUE(it != map.end());
+        EXPECT_EQ(it->first, kv.first);
+        EXPECT_EQ(it->second, kv.second);
+        EXPECT_EQ(map.at(kv.first), kv.second);
+        EXPECT_EQ(map[kv.first], kv.second);
+    }
+    for (uint64_t i = 0; i < 10000; ++i) {
+        EXPECT_EQ(map.count(i * 128 + 1), 0);
+    }
+    // traversal visits each pair once
+    std::map<uint64_t, uint32_t> out;
+    for (const auto &kv : map) {
+        EXPECT_TRUE(out.insert(kv).second);
+    }
+    EXPECT_TRUE((out == std::map<uint64_t, uint32_t>(in.begin(), in.end())));
+    map.Destroy();
+}
+
+TEST_F(SharedFlatHashMapTest, test_Dump_vector_duplicated) {
+    std::string name = "./flat_hashmap_vec.dat";
+    std::vector<std::pair<int, int> > in = {{1, 10}, {2, 20}, {1, 30}};
+    ASSERT_TRUE((SharedFlatHashMap<int, int>::Dump(name, in)));
+    SharedFlatHashMap<int, int> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at(1), 10);
+    EXPECT_EQ(map.at(2), 20);
+    map.Destroy();
+}
+
+TEST_F(SharedFlatHashMapTest, test_type_hash) {
+    std::string name = "./flat_hashmap_type.dat";
+    std::map<int, int> in = {{1, 1}};
+    ASSERT_TRUE((SharedFlatHashMap<int, int>::Dump(name, in)));
+    SharedFlatHashMap<int, long> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    EXPECT_EQ(map.Load(), SC_RET_LOAD_FAIL);
+}
+
+TEST_F(SharedFlatHashMapTest, test_Build) {
+    std::map<int, int> in;
+    for (int i = 0; i < 1000; ++i) {
+        in[i] = -i;
+    }
+    SharedFlatHashMap<int, int> map("./build_flat_hashmap");
+    ASSERT_EQ(map.Build(in), SC_RET_OK);
+    ASSERT_EQ(map.size(), 1000);
+    EXPECT_EQ(map.at(7), -7);
+    // exported the same as dumped
+    ASSERT_TRUE((SharedFlatHashMap<int, int>::Dump("./build_flat_hashmap_dump.dat", in)));
+    ASSERT_TRUE(map.Export("./build_flat_hashmap_export.dat"));
+    EXPECT_TRUE(read_file("./build_flat_hashmap_dump.dat") == read_file("./build_flat_hashmap_export.dat"));
+    map.Destroy();
+}
+
+TEST_F(SharedFlatHashMapTest, test_set_Dump_Load) {
+    std::string name = "./flat_hashset.dat";
+    std::unordered_set<Cat, CatHash, CatEqual> in;
+    for (int i = 0; i < 500; ++i) {
+        in.emplace(Cat(std::to_string(i * 7).c_str()));
+    }
+    ASSERT_TRUE((SharedFlatHashSet<Cat, CatHash, CatEqual>::Dump(name, in)));
+    SharedFlatHashSet<Cat, CatHash, CatEqual> set(name);
+    ASSERT_EQ(set.Init(), SC_RET_OK);
+    ASSERT_EQ(set.Load(), SC_RET_OK);
+    ASSERT_EQ(set.size(), in.size());
+    for (int i = 0; i < 500 * 7; ++i) {
+        EXPECT_EQ(set.count(Cat(std::to_string(i).c_str())), (i % 7 == 0 ? 1 : 0));
+    }
+    auto it = set.find(Cat("14"));
+    ASSERT_TRUE(it != set.end());
+    EXPECT_STREQ(it->name, "14");
+    size_t n = 0;
+    for (auto it = set.begin(); it != set.end(); ++it) {
+        EXPECT_EQ(in.count(*it), 1);
+        ++n;
+    }
+    EXPECT_EQ(n, in.size());
+    set.Destroy();
+}
+
+TEST_F(SharedFlatHashMapTest, test_set_Dump_vector) {
+    std::string name = "./flat_hashset_vec.dat";
+    std::vector<int> in = {3, 1, 3, 2};
+    ASSERT_TRUE(SharedFlatHashSet<int>::Dump(name, in));
+    SharedFlatHashSet<int> set(name);
+    ASSERT_EQ(set.Init(), SC_RET_OK);
+    ASSERT_EQ(set.Load(), SC_RET_OK);
+    EXPECT_EQ(set.size(), 3);
+    EXPECT_EQ(set.count(2), 1);
+    EXPECT_EQ(set.count(4), 0);
+    set.Destroy();
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
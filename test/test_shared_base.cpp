@@ -1,6 +1,8 @@
 #include "shared_base.hpp"
 #include "svec.hpp"
 #include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <gtest/gtest.h>
 #include "test_header.h"
 
@@ -172,6 +174,351 @@ TEST_F(SharedBaseTest, test__file2bin) {
     }
 }
 
+TEST_F(SharedBaseTest, test__file2bin_parallel) {
+    std::string name = "./parallel_load.dat";
+    std::vector<uint64_t> in(100000);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = i * i;
+    }
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    // chunk size unaligned with file header, less or greater than container size
+    for (size_t chunk_size : {4096UL, 10000UL, 1UL << 30}) {
+        levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+        ContainerOptions options;
+        options.load_threads = 4;
+        options.load_chunk_size = chunk_size;
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        ASSERT_EQ(vec.size(), in.size());
+        EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    }
+    // truncated file
+    {
+        std::string name = "./parallel_load_truncated.dat";
+        ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+        ASSERT_EQ(truncate(name.c_str(), sizeof(SharedFileHeader) + 4096), 0);
+        levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+        ContainerOptions options;
+        options.load_threads = 4;
+        options.load_chunk_size = 1024;
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_EQ(vec.Load(), SC_RET_LOAD_FAIL);
+    }
+}
+
+TEST_F(SharedBaseTest, test__file2bin_direct) {
+    std::string name = "./direct_load.dat";
+    std::vector<uint64_t> in(300000);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = i * i;
+    }
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    // io size unaligned with page, less or greater than container size; thread pool and io_uring
+    for (size_t io_size : {4096UL, 10000UL, 1UL << 30}) {
+        for (uint32_t queue_depth : {0U, 4U}) {
+            levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+            ContainerOptions options;
+            options.load_direct = true;
+            options.load_io_size = io_size;
+            options.load_queue_depth = queue_depth;
+            options.load_threads = 3;
+            vec.SetOptions(options);
+            ASSERT_EQ(vec.Init(), SC_RET_OK);
+            ASSERT_EQ(vec.Load(), SC_RET_OK);
+            ASSERT_EQ(vec.size(), in.size());
+            EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+        }
+    }
+    // page aligned destination, read in place
+    {
+        size_t len = 3 * 4096 + 100;
+        std::vector<char> out(len + 4096);
+        char *dst = (char*)(((size_t)out.data() + 4095) / 4096 * 4096);
+        std::ifstream fin(name, std::ios::in | std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+        for (uint32_t queue_depth : {0U, 2U}) {
+            memset(dst, 0, len);
+            ASSERT_TRUE(DirectPread(name, dst, len, 4096, 4096, queue_depth, 2));
+            EXPECT_EQ(memcmp(dst, content.data() + 4096, len), 0);
+        }
+    }
+    // truncated file
+    {
+        std::string name = "./direct_load_truncated.dat";
+        ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+        ASSERT_EQ(truncate(name.c_str(), sizeof(SharedFileHeader) + 10000), 0);
+        levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+        ContainerOptions options;
+        options.load_direct = true;
+        options.load_io_size = 4096;
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_EQ(vec.Load(), SC_RET_LOAD_FAIL);
+    }
+}
+
+TEST_F(SharedBaseTest, test_warmup) {
+    std::string name = "./warmup_vec.dat";
+    std::vector<uint64_t> in(1000000, 7);
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    {
+        levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+        EXPECT_EQ(vec.Warmup(), SC_RET_ERR_STATUS);
+    }
+    for (auto policy : {WarmupPolicy::None, WarmupPolicy::Sequential,
+                WarmupPolicy::Parallel, WarmupPolicy::Populate}) {
+        levin::SharedVector<uint64_t, levin::MappedFileMemory> vec(name);
+        ContainerOptions options;
+        options.warmup = policy;
+        options.warmup_lock = (policy == WarmupPolicy::Sequential);
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_EQ(vec.Warmup(), SC_RET_OK);
+        EXPECT_TRUE(vec.IsWarm());
+        EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    }
+    // warm up in background, destroyed while warming
+    for (int i = 0; i < 2; ++i) {
+        levin::SharedVector<uint64_t, levin::HeapMemory> vec(name);
+        ContainerOptions options;
+        options.warmup = WarmupPolicy::Parallel;
+        options.warmup_async = true;
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_EQ(vec.Warmup(), SC_RET_OK);
+        if (i == 0) {
+            vec._stop_warmup();
+            vec.Warmup();
+            vec.Destroy();
+        }
+    }
+}
+
+// @brief simulate loader crashed halfway: Loading state, chunks after loaded offset never read
+static void BreakLoad(levin::SharedVector<uint64_t> &vec, size_t loaded_offset) {
+    vec._info->_meta->state = LoadState::Loading;
+    vec._info->_meta->loaded_offset = loaded_offset;
+    size_t pos = loaded_offset - sizeof(SharedFileHeader);
+    memset((char*)vec._object + pos, 0, vec._info->_header->container_size - pos);
+}
+
+TEST_F(SharedBaseTest, test_resume_load) {
+    std::string name = "./resume_load.dat";
+    std::vector<uint64_t> in(100000);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = i * 7;
+    }
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    size_t half = sizeof(SharedFileHeader) + in.size() * sizeof(uint64_t) / 2;
+    // serial and parallel load resumed from loaded offset
+    for (uint32_t threads : {1U, 4U}) {
+        ContainerOptions options;
+        options.load_chunk_size = 64UL << 10;
+        options.load_threads = threads;
+        {
+            levin::SharedVector<uint64_t> vec(name);
+            vec.SetOptions(options);
+            ASSERT_EQ(vec.Init(), SC_RET_OK);
+            ASSERT_EQ(vec.Load(), SC_RET_OK);
+            EXPECT_EQ(vec._info->_meta->state, LoadState::Ready);
+            EXPECT_EQ(vec._info->_meta->loaded_offset, sizeof(SharedFileHeader) + vec._info->_header->container_size);
+            BreakLoad(vec, half);
+            // no vec.Destroy();
+        }
+        levin::SharedVector<uint64_t> vec(name);
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_FALSE(vec.IsExist());
+        EXPECT_EQ(vec._info->_resume_offset, half);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_EQ(vec._info->_meta->state, LoadState::Ready);
+        EXPECT_EQ(vec._info->_meta->generation, 2);
+        ASSERT_EQ(vec.size(), in.size());
+        EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+        vec.Destroy();
+    }
+    // binfile changed since: partial region recycled, full load
+    {
+        levin::SharedVector<uint64_t> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        BreakLoad(vec, half);
+    }
+    struct timespec times[2] = {{0, UTIME_OMIT}, {12345, 0}};
+    ASSERT_EQ(utimensat(AT_FDCWD, name.c_str(), times, 0), 0);
+    levin::SharedVector<uint64_t> vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_EQ(vec._info->_resume_offset, 0);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_EQ(vec._info->_meta->generation, 1);
+    EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+    vec.Destroy();
+}
+
+TEST_F(SharedBaseTest, test_load_md5) {
+    std::string name = "./md5_load.dat";
+    std::vector<uint64_t> in(100000);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = i * 3;
+    }
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    std::string md5;
+    ASSERT_TRUE(GetFileMD5(name, md5));
+    std::vector<ContainerOptions> options_list(4);
+    options_list[1].load_threads = 4;
+    options_list[1].load_chunk_size = 10000;
+    options_list[2].load_direct = true;
+    options_list[2].load_io_size = 4096;
+    options_list[3].load_chunk_size = 4096;
+    for (auto &options : options_list) {
+        options.load_md5 = md5;
+        levin::SharedVector<uint64_t> vec(name);
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_TRUE(std::equal(vec.begin(), vec.end(), in.begin()));
+        vec.Destroy();
+        // mismatched, shm removed before published
+        options.load_md5 = "0123456789abcdef0123456789abcdef";
+        levin::SharedVector<uint64_t> bad(name);
+        bad.SetOptions(options);
+        ASSERT_EQ(bad.Init(), SC_RET_OK);
+        EXPECT_EQ(bad.Load(), SC_RET_FILE_CHECK);
+        int shmid = 0;
+        EXPECT_FALSE(IdManager::GetInstance().GetId(name, shmid));
+    }
+    // resumed load: loaded prefix fed into digest from memory
+    ContainerOptions options;
+    options.load_chunk_size = 4096;
+    options.load_md5 = md5;
+    {
+        levin::SharedVector<uint64_t> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        BreakLoad(vec, sizeof(SharedFileHeader) + 30000);
+    }
+    {
+        levin::SharedVector<uint64_t> vec(name);
+        vec.SetOptions(options);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_GT(vec._info->_resume_offset, 0);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        vec.Destroy();
+    }
+    // bytes beyond container, mapped binfile
+    {
+        std::ofstream fout(name, std::ios::out | std::ios::binary | std::ios::app);
+        fout << "tail";
+    }
+    ASSERT_TRUE(GetFileMD5(name, options.load_md5));
+    EXPECT_NE(options.load_md5, md5);
+    levin::SharedVector<uint64_t> vec(name);
+    vec.SetOptions(options);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    vec.Destroy();
+    levin::SharedVector<uint64_t, levin::MappedFileMemory> mapped(name);
+    mapped.SetOptions(options);
+    ASSERT_EQ(mapped.Init(), SC_RET_OK);
+    ASSERT_EQ(mapped.Load(), SC_RET_OK);
+    options.load_md5 = md5;
+    levin::SharedVector<uint64_t, levin::MappedFileMemory> bad(name);
+    bad.SetOptions(options);
+    ASSERT_EQ(bad.Init(), SC_RET_OK);
+    EXPECT_EQ(bad.Load(), SC_RET_FILE_CHECK);
+}
+
+TEST_F(SharedBaseTest, test_block_crc32c_checker) {
+    // check value of CRC32C
+    EXPECT_EQ(Crc32c(0, "123456789", 9), 0xe3069283);
+    EXPECT_EQ(Crc32c(Crc32c(0, "1234", 4), "56789", 5), 0xe3069283);
+    // digest independent of thread num, dependent of block size
+    std::vector<char> data(10000019);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = (char)(i * 131);
+    }
+    std::string digest, other;
+    ASSERT_TRUE(BlockCrc32c(data.data(), data.size(), 1UL << 20, 1, digest));
+    ASSERT_TRUE(BlockCrc32c(data.data(), data.size(), 1UL << 20, 4, other));
+    EXPECT_EQ(digest, other);
+    ASSERT_TRUE(BlockCrc32c(data.data(), data.size(), 4096, 4, other));
+    EXPECT_NE(digest, other);
+
+    std::string name = "./crc32c_vec.dat";
+    std::vector<uint64_t> in(1000000, 9);
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    {
+        levin::SharedVector<uint64_t, levin::SharedMemory, levin::BlockCrc32cChecker> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        ASSERT_EQ(vec.Load(), SC_RET_OK);
+        EXPECT_STRNE(vec._info->_meta->checksum, "");
+        // no vec.Destroy();
+    }
+    {
+        levin::SharedVector<uint64_t, levin::SharedMemory, levin::BlockCrc32cChecker> vec(name);
+        ASSERT_EQ(vec.Init(), SC_RET_OK);
+        EXPECT_TRUE(vec.IsExist());
+        // one byte corrupted
+        const_cast<uint64_t&>(vec[777777]) = 8;
+        EXPECT_FALSE(vec._check(vec._object));
+        vec.Destroy();
+    }
+}
+
+TEST_F(SharedBaseTest, test_verify_lazy) {
+    typedef levin::SharedVector<uint64_t, levin::SharedMemory, levin::BlockCrc32cChecker> CrcVec;
+    std::string name = "./lazy_vec.dat";
+    std::vector<uint64_t> in(1000000, 5);
+    ASSERT_TRUE(levin::SharedVector<uint64_t>::Dump(name, in));
+    ContainerOptions options;
+    options.verify_lazy = true;
+    CrcVec vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_TRUE(vec.IsVerified());
+    {
+        // readable right after attached, verified in background
+        CrcVec other(name);
+        other.SetOptions(options);
+        ASSERT_EQ(other.Init(), SC_RET_OK);
+        EXPECT_TRUE(other.IsExist());
+        EXPECT_EQ(other[999999], 5);
+        other._stop_verify();
+        EXPECT_TRUE(other.IsVerified());
+        EXPECT_FALSE(other.IsCorrupted());
+    }
+    // corrupted: quarantined and callback called, mapping still readable
+    const_cast<uint64_t&>(vec[777777]) = 8;
+    boost::atomic<int> called(0);
+    CrcVec other(name);
+    other.SetOptions(options);
+    other.SetCorruptCallback([&called]() { ++called; });
+    ASSERT_EQ(other.Init(), SC_RET_OK);
+    EXPECT_TRUE(other.IsExist());
+    other._stop_verify();
+    EXPECT_FALSE(other.IsVerified());
+    EXPECT_TRUE(other.IsCorrupted());
+    EXPECT_EQ(called, 1);
+    EXPECT_EQ(other[777777], 8);
+    CatalogEntry entry;
+    EXPECT_FALSE(ShmCatalog::GetInstance().Find(name, entry));
+    // reloaded into a new region by later Init
+    {
+        CrcVec reload(name);
+        ASSERT_EQ(reload.Init(), SC_RET_OK);
+        EXPECT_FALSE(reload.IsExist());
+        ASSERT_EQ(reload.Load(), SC_RET_OK);
+        EXPECT_EQ(reload[777777], 5);
+        reload.Destroy();
+    }
+    other.Destroy();
+    vec.Destroy();
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
@@ -1,6 +1,8 @@
 #include "snested_hashmap.hpp"
 #include "shashmap.hpp"
 #include <vector>
+#include <fstream>
+#include <iterator>
 #include <map>
 #include <unordered_map>
 #include <gtest/gtest.h>
@@ -250,6 +252,211 @@ protected:
     const size_t fixed_len = SharedBase::MetaSize() + SharedBase::HeaderSize();
 };
 
+TEST_F(SharedMapTest, test_FastMod64) {
+    std::vector<uint64_t> divisors = {1, 2, 3, 7, 97, 1000, getPrime(100000), 4294967311UL,
+            (1UL << 63) + 5, UINT64_MAX};
+    std::vector<uint64_t> xs = {0, 1, 2, 96, 97, 98, UINT32_MAX, (1UL << 63), UINT64_MAX - 1, UINT64_MAX};
+    uint64_t x = 88172645463325252UL;
+    for (int i = 0; i < 1000; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        xs.push_back(x);
+    }
+    for (uint64_t n : divisors) {
+        BucketReducer reducer(BucketReduce::Mod, n);
+        for (uint64_t x : xs) {
+            ASSERT_EQ(reducer(x), x % n) << "x=" << x << ", n=" << n;
+        }
+    }
+    BucketReducer pow2(BucketReduce::Pow2, 1024);
+    for (uint64_t x : xs) {
+        ASSERT_LT(pow2(x), 1024);
+    }
+}
+
+TEST_F(SharedMapTest, test_bucket_options) {
+    std::unordered_map<uint64_t, uint64_t> kvs;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        kvs[i * 64] = i;
+    }
+    EXPECT_EQ(BucketCountOf(BucketOptions(BucketReduce::Pow2, 0.5), 10000, 1), 32768);
+    EXPECT_EQ(BucketCountOf(BucketOptions(BucketReduce::Mod, 2.0), 10000, 1), 5000);
+    EXPECT_EQ(BucketCountOf(BucketOptions(BucketReduce::Mod, 2.0, 77), 10000, 1), 77);
+    EXPECT_EQ(BucketCountOf(BucketOptions(), 10000, 10007), 10007);
+
+    std::vector<BucketOptions> options = {BucketOptions(BucketReduce::Pow2), BucketOptions(BucketReduce::Pow2, 0.5),
+            BucketOptions(BucketReduce::Mod, 2.0), BucketOptions(BucketReduce::Mod, 0, 1)};
+    for (const auto &option : options) {
+        std::string name = "./hashmap_bucket_options.dat";
+        ASSERT_TRUE((SharedHashMap<uint64_t, uint64_t>::Dump(name, kvs, option)));
+        SharedHashMap<uint64_t, uint64_t> map(name);
+        ASSERT_EQ(map.Init(), SC_RET_OK);
+        ASSERT_EQ(map.Load(), SC_RET_OK);
+        EXPECT_EQ(map.bucket_reduce(), option.reduce);
+        EXPECT_EQ(map.bucket_size(), BucketCountOf(option, kvs.size(), getPrime(kvs.size())));
+        ASSERT_EQ(map.size(), kvs.size());
+        for (const auto &kv : kvs) {
+            ASSERT_EQ(map.at(kv.first), kv.second);
+        }
+        EXPECT_EQ(map.count(1), 0);
+        EXPECT_TRUE(map.find(63) == map.end());
+        size_t n = 0;
+        for (auto it = map.begin(); it != map.end(); ++it) {
+            ASSERT_EQ(kvs.at(it->first), it->second);
+            ++n;
+        }
+        EXPECT_EQ(n, kvs.size());
+        map.Destroy();
+    }
+}
+
+TEST_F(SharedMapTest, test_Load_unknown_reduce) {
+    std::string name = "./hashmap_unknown_reduce.dat";
+    ASSERT_TRUE((SharedHashMap<uint64_t, uint64_t>::Dump(name, map_kv64)));
+    // low byte of header flags
+    std::fstream file(name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offsetof(SharedFileHeader, flags));
+    file.put(7);
+    file.close();
+    SharedHashMap<uint64_t, uint64_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    EXPECT_EQ(map.Load(), SC_RET_LOAD_FAIL);
+    map.Destroy();
+}
+
+TEST_F(SharedMapTest, test_find_batch) {
+    std::unordered_map<uint64_t, uint64_t> kvs;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        kvs[i * 3] = i;
+    }
+    // hits and misses, not a multiple of batch group
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 1001; ++i) {
+        keys.push_back(i * 7);
+    }
+    for (auto reduce : {BucketReduce::Mod, BucketReduce::Pow2}) {
+        std::string name = "./hashmap_find_batch.dat";
+        ASSERT_TRUE((SharedHashMap<uint64_t, uint64_t>::Dump(name, kvs, BucketOptions(reduce))));
+        SharedHashMap<uint64_t, uint64_t> map(name);
+        ASSERT_EQ(map.Init(), SC_RET_OK);
+        ASSERT_EQ(map.Load(), SC_RET_OK);
+        std::vector<const uint64_t*> values(keys.size());
+        size_t expect_found = 0;
+        for (auto key : keys) {
+            expect_found += kvs.count(key);
+        }
+        EXPECT_EQ(map.find_batch(keys.data(), keys.size(), values.data()), expect_found);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            map.prefetch(keys[i]);
+            if (kvs.count(keys[i])) {
+                ASSERT_TRUE(values[i] != nullptr);
+                ASSERT_EQ(*values[i], kvs[keys[i]]);
+                ASSERT_EQ(values[i], &map.at(keys[i]));
+            } else {
+                ASSERT_TRUE(values[i] == nullptr);
+            }
+        }
+        EXPECT_EQ(map.find_batch(keys.data(), 0, values.data()), 0);
+        map.Destroy();
+    }
+}
+
+TEST_F(SharedMapTest, test_bucket_layout) {
+    // key narrower than value: keys, alignment pad and values, zero padded to records of pair layout
+    const uint64_t num = DUMP_ELEMS_PER_THREAD * 2 + 3;
+    std::vector<std::pair<uint32_t, uint64_t> > kvs;
+    for (uint64_t i = 0; i < num; ++i) {
+        kvs.emplace_back(i * 3, i * i);
+    }
+    uint32_t thread_num = GetDumpThreads();
+    for (auto reduce : {BucketReduce::Mod, BucketReduce::Pow2}) {
+        BucketOptions options(reduce, 0, 0, BucketLayout::Split);
+        std::vector<std::string> names = {"./hashmap_split_t1.dat", "./hashmap_split_t4.dat"};
+        std::vector<uint32_t> threads = {1, 4};
+        for (size_t t = 0; t < threads.size(); ++t) {
+            SetDumpThreads(threads[t]);
+            ASSERT_TRUE((SharedHashMap<uint32_t, uint64_t>::Dump(names[t], kvs, options)));
+        }
+        SetDumpThreads(thread_num);
+        EXPECT_TRUE(read_file(names[0]) == read_file(names[1]));
+        // the same size as pair layout
+        std::string pair_name = "./hashmap_pair.dat";
+        ASSERT_TRUE((SharedHashMap<uint32_t, uint64_t>::Dump(pair_name, kvs, BucketOptions(reduce))));
+        EXPECT_EQ(read_file(names[0]).size(), read_file(pair_name).size());
+
+        SharedHashMap<uint32_t, uint64_t> map(names[0]);
+        ASSERT_EQ(map.Init(), SC_RET_OK);
+        ASSERT_EQ(map.Load(), SC_RET_OK);
+        EXPECT_EQ(map.bucket_layout(), BucketLayout::Split);
+        EXPECT_EQ(map.bucket_reduce(), reduce);
+        ASSERT_EQ(map.size(), num);
+        for (const auto &kv : kvs) {
+            ASSERT_EQ(map.at(kv.first), kv.second);
+            ASSERT_EQ(map[kv.first], kv.second);
+            auto it = map.find(kv.first);
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(it->first, kv.first);
+            ASSERT_EQ((*it).second, kv.second);
+        }
+        EXPECT_EQ(map.count(1), 0);
+        EXPECT_TRUE(map.find(1) == map.end());
+        EXPECT_THROW(map.at(1), std::out_of_range);
+        // iterated in the same order as pair layout
+        SharedHashMap<uint32_t, uint64_t> pair_map(pair_name);
+        ASSERT_EQ(pair_map.Init(), SC_RET_OK);
+        ASSERT_EQ(pair_map.Load(), SC_RET_OK);
+        EXPECT_EQ(pair_map.bucket_layout(), BucketLayout::Pair);
+        auto pit = pair_map.begin();
+        size_t n = 0;
+        for (auto it = map.begin(); it != map.end(); ++it, ++pit, ++n) {
+            ASSERT_TRUE(pit != pair_map.end());
+            ASSERT_EQ(it->first, pit->first);
+            ASSERT_EQ(it->second, pit->second);
+        }
+        EXPECT_EQ(n, num);
+        std::vector<uint32_t> keys = {0, 1, 3, 5, 6, (uint32_t)(num * 3 - 3), (uint32_t)(num * 3)};
+        std::vector<const uint64_t*> values(keys.size());
+        EXPECT_EQ(map.find_batch(keys.data(), keys.size(), values.data()), 4);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] % 3 == 0 && keys[i] < num * 3) {
+                ASSERT_EQ(values[i], &map.at(keys[i]));
+            } else {
+                ASSERT_TRUE(values[i] == nullptr);
+            }
+        }
+        pair_map.Destroy();
+
+        // layout kept by Build and Export, byte identical to Dump
+        SharedHashMapBuilder<uint32_t, uint64_t> builder(options);
+        for (const auto &kv : kvs) {
+            builder.Add(kv.first, kv.second);
+        }
+        SharedHashMap<uint32_t, uint64_t> built("./build_hashmap_split");
+        ASSERT_EQ(built.Build(builder), SC_RET_OK);
+        EXPECT_EQ(built.bucket_layout(), BucketLayout::Split);
+        EXPECT_EQ(built.at(kvs.back().first), kvs.back().second);
+        ASSERT_TRUE(built.Export("./build_hashmap_split.dat"));
+        EXPECT_TRUE(read_file(names[0]) == read_file("./build_hashmap_split.dat"));
+        built.Destroy();
+        map.Destroy();
+    }
+}
+
+TEST_F(SharedMapTest, test_Load_unknown_layout) {
+    std::string name = "./hashmap_unknown_layout.dat";
+    ASSERT_TRUE((SharedHashMap<uint64_t, uint64_t>::Dump(name, map_kv64)));
+    // 2nd low byte of header flags
+    std::fstream file(name, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(offsetof(SharedFileHeader, flags) + 1);
+    file.put(7);
+    file.close();
+    SharedHashMap<uint64_t, uint64_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    EXPECT_EQ(map.Load(), SC_RET_LOAD_FAIL);
+    map.Destroy();
+}
+
 TEST_F(SharedNestedHashMapTest, test_type_traits_assert) {
     // error type, compile error is expected
 //    std::map<uint32_t, std::vector<Cat> > nmap_cat;
@@ -385,6 +592,235 @@ TEST_F(SharedNestedHashMapTest, test_snmap_diff) {
     mymap.Destroy();
 }
 
+TEST_F(SharedMapTest, test_builder) {
+    // more records than one block of builder
+    std::vector<std::pair<uint64_t, uint64_t> > kvs;
+    for (uint64_t i = 0; i < 200000; ++i) {
+        kvs.emplace_back(i * 7919, i);
+    }
+    std::string name = "./builder_map.dat";
+    SharedHashMapBuilder<uint64_t, uint64_t> builder;
+    for (const auto &kv : kvs) {
+        builder.Add(kv.first, kv.second);
+    }
+    EXPECT_EQ(builder.size(), kvs.size());
+    ASSERT_TRUE(builder.Dump(name));
+    EXPECT_EQ(builder.size(), 0);
+
+    // the same layout as bucket vectors dumped
+    std::string expect_name = "./builder_map_expect.dat";
+    size_t bucket_count = getPrime(kvs.size());
+    std::vector<std::vector<std::pair<uint64_t, uint64_t> > > datas(bucket_count);
+    for (const auto &kv : kvs) {
+        datas[std::hash<uint64_t>()(kv.first) % bucket_count].push_back(kv);
+    }
+    std::ofstream fout(expect_name, std::ios::out | std::ios::binary);
+    ASSERT_TRUE((SharedHashMap<uint64_t, uint64_t>::dump(expect_name, kvs.size(), datas, fout)));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+
+    SharedHashMap<uint64_t, uint64_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    ASSERT_EQ(map.size(), kvs.size());
+    for (const auto &kv : kvs) {
+        ASSERT_EQ(map.at(kv.first), kv.second);
+    }
+    EXPECT_TRUE(map.find(1) == map.end());
+    map.Destroy();
+}
+
+TEST_F(SharedNestedHashMapTest, test_builder) {
+    std::string name = "./builder_nmap.dat";
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> builder;
+    std::vector<std::vector<std::pair<uint64_t, size_t> > > index(getPrime(100000));
+    std::vector<std::vector<uint32_t> > datas;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        std::vector<uint32_t> values(i % 5, i);
+        ASSERT_TRUE(builder.Add(i * 31, values));
+        index[std::hash<uint64_t>()(i * 31) % index.size()].emplace_back(i * 31, i);
+        datas.push_back(values);
+    }
+    ASSERT_TRUE(builder.Dump(name));
+
+    std::string expect_name = "./builder_nmap_expect.dat";
+    std::ofstream fout(expect_name, std::ios::out | std::ios::binary);
+    ASSERT_TRUE((SharedNestedHashMap<uint64_t, uint32_t>::dump(expect_name, index, datas, fout)));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+
+    SharedNestedHashMap<uint64_t, uint32_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    ASSERT_EQ(map.size(), datas.size());
+    for (uint64_t i = 0; i < datas.size(); ++i) {
+        auto it = map.find(i * 31);
+        ASSERT_TRUE(it != map.end());
+        ASSERT_TRUE(std::equal(it->second->begin(), it->second->end(), datas[i].begin()));
+    }
+    map.Destroy();
+}
+
+TEST_F(SharedMapTest, test_builder_threads) {
+    // enough records for several partitions per thread
+    const uint64_t num = DUMP_ELEMS_PER_THREAD * 8;
+    uint32_t thread_num = GetDumpThreads();
+    std::vector<std::string> names = {"./builder_map_t1.dat", "./builder_map_t4.dat"};
+    std::vector<std::string> nested_names = {"./builder_nmap_t1.dat", "./builder_nmap_t4.dat"};
+    std::vector<uint32_t> threads = {1, 4};
+    for (size_t t = 0; t < threads.size(); ++t) {
+        SetDumpThreads(threads[t]);
+        EXPECT_EQ(DumpThreadNum(num), threads[t]);
+        SharedHashMapBuilder<uint64_t, uint64_t> builder;
+        SharedNestedHashMapBuilder<uint64_t, uint32_t> nested_builder;
+        for (uint64_t i = 0; i < num; ++i) {
+            builder.Add(i * 7919, i);
+            std::vector<uint32_t> values(i % 3, i);
+            ASSERT_TRUE(nested_builder.Add(i * 31, values));
+        }
+        ASSERT_TRUE(builder.Dump(names[t]));
+        ASSERT_TRUE(nested_builder.Dump(nested_names[t]));
+    }
+    SetDumpThreads(thread_num);
+    // layout is the same whatever threads
+    EXPECT_TRUE(read_file(names[0]) == read_file(names[1]));
+    EXPECT_TRUE(read_file(nested_names[0]) == read_file(nested_names[1]));
+
+    SharedHashMap<uint64_t, uint64_t> map(names[1]);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    ASSERT_EQ(map.size(), num);
+    for (uint64_t i = 0; i < num; i += 97) {
+        ASSERT_EQ(map.at(i * 7919), i);
+    }
+    map.Destroy();
+}
+
+TEST_F(SharedNestedHashMapTest, test_Build) {
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> builder;
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> dump_builder;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        std::vector<uint32_t> values(i % 4, i);
+        ASSERT_TRUE(builder.Add(i, values));
+        ASSERT_TRUE(dump_builder.Add(i, values));
+    }
+    SharedNestedHashMap<uint64_t, uint32_t> map("./build_nmap");
+    ASSERT_EQ(map.Build(builder), SC_RET_OK);
+    EXPECT_EQ(builder.size(), 0);
+    ASSERT_EQ(map.size(), 1000);
+    auto it = map.find(7);
+    ASSERT_TRUE(it != map.end());
+    EXPECT_EQ(it->second->size(), 3);
+    EXPECT_EQ((*it->second)[2], 7);
+    // exported the same as dumped
+    ASSERT_TRUE(dump_builder.Dump("./build_nmap_dump.dat"));
+    ASSERT_TRUE(map.Export("./build_nmap_export.dat"));
+    EXPECT_TRUE(read_file("./build_nmap_dump.dat") == read_file("./build_nmap_export.dat"));
+    map.Destroy();
+}
+
+TEST_F(SharedNestedHashMapTest, test_bucket_options) {
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> builder(BucketOptions(BucketReduce::Pow2, 4.0));
+    for (uint64_t i = 0; i < 1000; ++i) {
+        std::vector<uint32_t> values(i % 4, i);
+        ASSERT_TRUE(builder.Add(i, values));
+    }
+    EXPECT_EQ(builder.bucket_count(), 256);
+    SharedNestedHashMap<uint64_t, uint32_t> map("./build_nmap_pow2");
+    ASSERT_EQ(map.Build(builder), SC_RET_OK);
+    EXPECT_EQ(map.bucket_reduce(), BucketReduce::Pow2);
+    EXPECT_EQ(map.bucket_size(), 256);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        auto it = map.find(i);
+        ASSERT_TRUE(it != map.end());
+        ASSERT_EQ(it->second->size(), i % 4);
+    }
+    EXPECT_EQ(map.count(1000), 0);
+    // reduction kept by Export, as Dump
+    ASSERT_TRUE(map.Export("./build_nmap_pow2.dat"));
+    map.Destroy();
+    SharedNestedHashMap<uint64_t, uint32_t> loaded("./build_nmap_pow2.dat");
+    ASSERT_EQ(loaded.Init(), SC_RET_OK);
+    ASSERT_EQ(loaded.Load(), SC_RET_OK);
+    EXPECT_EQ(loaded.bucket_reduce(), BucketReduce::Pow2);
+    EXPECT_EQ((*loaded[999])[0], 999);
+    loaded.Destroy();
+}
+
+TEST_F(SharedNestedHashMapTest, test_find_batch) {
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> builder;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        std::vector<uint32_t> values(i % 4, i);
+        ASSERT_TRUE(builder.Add(i * 2, values));
+    }
+    SharedNestedHashMap<uint64_t, uint32_t> map("./build_nmap_batch");
+    ASSERT_EQ(map.Build(builder), SC_RET_OK);
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 333; ++i) {
+        keys.push_back(i * 5);
+    }
+    std::vector<const SharedNestedHashMap<uint64_t, uint32_t>::data_array_type*> arrays(keys.size());
+    EXPECT_EQ(map.find_batch(keys.data(), keys.size(), arrays.data()), 167);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        map.prefetch(keys[i]);
+        auto it = map.find(keys[i]);
+        if (it == map.end()) {
+            ASSERT_TRUE(arrays[i] == nullptr);
+        } else {
+            ASSERT_EQ(arrays[i], it->second);
+            ASSERT_EQ(arrays[i]->size(), keys[i] / 2 % 4);
+        }
+    }
+    map.Destroy();
+}
+
+TEST_F(SharedNestedHashMapTest, test_bucket_layout) {
+    BucketOptions options(BucketReduce::Mod, 0, 0, BucketLayout::Split);
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> builder(options);
+    SharedNestedHashMapBuilder<uint64_t, uint32_t> pair_builder;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        std::vector<uint32_t> values(i % 4, i);
+        ASSERT_TRUE(builder.Add(i * 2, values));
+        ASSERT_TRUE(pair_builder.Add(i * 2, values));
+    }
+    ASSERT_TRUE(pair_builder.Dump("./nmap_pair.dat"));
+    SharedNestedHashMap<uint64_t, uint32_t> map("./build_nmap_split");
+    ASSERT_EQ(map.Build(builder), SC_RET_OK);
+    EXPECT_EQ(map.bucket_layout(), BucketLayout::Split);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        auto it = map.find(i * 2);
+        ASSERT_TRUE(it != map.end());
+        ASSERT_EQ(it->first, i * 2);
+        ASSERT_EQ(it->second->size(), i % 4);
+        ASSERT_EQ(map[i * 2], it->second);
+    }
+    EXPECT_EQ(map.count(1), 0);
+    std::vector<uint64_t> keys = {0, 1, 2, 1998, 2000};
+    std::vector<const SharedNestedHashMap<uint64_t, uint32_t>::data_array_type*> arrays(keys.size());
+    EXPECT_EQ(map.find_batch(keys.data(), keys.size(), arrays.data()), 3);
+    EXPECT_EQ(arrays[2], map[2]);
+    EXPECT_TRUE(arrays[1] == nullptr);
+    ASSERT_TRUE(map.Export("./build_nmap_split.dat"));
+    map.Destroy();
+
+    SharedNestedHashMap<uint64_t, uint32_t> loaded("./build_nmap_split.dat");
+    ASSERT_EQ(loaded.Init(), SC_RET_OK);
+    ASSERT_EQ(loaded.Load(), SC_RET_OK);
+    EXPECT_EQ(loaded.bucket_layout(), BucketLayout::Split);
+    SharedNestedHashMap<uint64_t, uint32_t> pair_map("./nmap_pair.dat");
+    ASSERT_EQ(pair_map.Init(), SC_RET_OK);
+    ASSERT_EQ(pair_map.Load(), SC_RET_OK);
+    // iterated in the same order as pair layout
+    auto pit = pair_map.begin();
+    size_t n = 0;
+    for (auto it = loaded.begin(); it != loaded.end(); ++it, ++pit, ++n) {
+        ASSERT_TRUE(pit != pair_map.end());
+        ASSERT_EQ(it->first, pit->first);
+        ASSERT_EQ(*it->second, *pit->second);
+    }
+    EXPECT_EQ(n, 1000);
+    pair_map.Destroy();
+    loaded.Destroy();
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <set>
 #include <unordered_map>
+#include <sched.h>
 #include "test_header.h"
 #include "benchmark_header.h"
 #include "shared_base.hpp"
@@ -9,11 +10,16 @@
 #include "smap.hpp"
 #include "shashmap.hpp"
 #include "snested_hashmap.hpp"
+#include "sflat_hashmap.hpp"
+#include "sperfect_hashmap.hpp"
+#include "numa_utils.h"
 
 namespace levin {
 
 static const size_t count = 1000000;
 static const size_t col_count = 100;
+// keys found together by find_batch, as keys of a request
+static const size_t batch_size = 256;
 
 void make_mapdata(std::vector<size_t> &vec_key) {
     srand((unsigned)time(NULL));
@@ -66,17 +72,17 @@ void test_shared_map(const std::vector<size_t> &vec_key) {
     mymap.Destroy();
 }
 
-void dump_shared_hashmap() {
+void dump_shared_hashmap(const BucketOptions &options = BucketOptions()) {
     std::string name = "./shashmap_bench.dat";
     std::unordered_map<uint64_t, uint32_t> map_data;
     for (size_t i = 0; i < count; ++i) {
         map_data[i] = i + 100;
     }
-    levin::SharedHashMap<uint64_t, uint32_t>::Dump(name, map_data);
+    levin::SharedHashMap<uint64_t, uint32_t>::Dump(name, map_data, options);
     std::unordered_map<uint64_t, uint32_t>().swap(map_data);
 }
 
-void test_shared_hashmap(const std::vector<size_t> &vec_key) {
+void test_shared_hashmap(const std::vector<size_t> &vec_key, const std::string &label = "shm_hashmap") {
     MemDiffer differ;
     std::string name = "./shashmap_bench.dat";
     levin::SharedHashMap<uint64_t, uint32_t> mymap(name);
@@ -93,7 +99,86 @@ void test_shared_hashmap(const std::vector<size_t> &vec_key) {
             std::cout << tmp << std::endl;
         }
     }
-    std::cout << "shm_hashmap get time:" << rtimer.get_time_us() << std::endl;
+    std::cout << label << " get time:" << rtimer.get_time_us() << std::endl;
+
+    // bucket by 64-bit division, as before reduction recorded in binfile
+    if (mymap.bucket_reduce() == BucketReduce::Mod && mymap.bucket_layout() == BucketLayout::Pair) {
+        levin::Timer div_timer;
+        for (size_t i = 0; i < count; ++i) {
+            auto &tmp = mymap._object->find(vec_key[i])->second;
+            if (tmp == count){
+                std::cout << tmp << std::endl;
+            }
+        }
+        std::cout << label << " get time(division):" << div_timer.get_time_us() << std::endl;
+    }
+
+    // keys of a request found together
+    std::vector<const uint32_t*> values(count);
+    levin::Timer batch_timer;
+    size_t found = 0;
+    for (size_t i = 0; i < count; i += batch_size) {
+        found += mymap.find_batch(&vec_key[i], std::min(batch_size, count - i), &values[i]);
+    }
+    std::cout << label << " find_batch(" << batch_size << ") time:" << batch_timer.get_time_us()
+              << ", found=" << found << std::endl;
+
+    levin::Timer miss_timer;
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hits += mymap.count(vec_key[i] + count);
+    }
+    std::cout << label << " miss time:" << miss_timer.get_time_us() << ", hits=" << hits << std::endl;
+
+    levin::Timer traversal_timer;
+    for(auto item : mymap){
+        auto key = item.first;
+        auto value = item.second;
+        if (key == count){
+            std::cout << key << " ===== " << value << std::endl;
+        }
+    }
+    std::cout << label << " traversal_time:" << traversal_timer.get_time_us() << std::endl;
+    std::cout << label << " bucket_count=" << mymap.bucket_size() << std::endl;
+
+    mymap.Destroy();
+}
+
+void dump_shared_flat_hashmap() {
+    std::string name = "./sflat_hashmap_bench.dat";
+    std::unordered_map<uint64_t, uint32_t> map_data;
+    for (size_t i = 0; i < count; ++i) {
+        map_data[i] = i + 100;
+    }
+    levin::SharedFlatHashMap<uint64_t, uint32_t>::Dump(name, map_data);
+    std::unordered_map<uint64_t, uint32_t>().swap(map_data);
+}
+
+void test_shared_flat_hashmap(const std::vector<size_t> &vec_key) {
+    MemDiffer differ;
+    std::string name = "./sflat_hashmap_bench.dat";
+    levin::SharedFlatHashMap<uint64_t, uint32_t> mymap(name);
+    if (mymap.Init() != SC_RET_OK || mymap.Load() != SC_RET_OK) {
+        std::cout << "init or load failed.";
+        return;
+    }
+    std::cout << differ.get_diff_report_kb() << std::endl;
+
+    levin::Timer rtimer;
+    for (size_t i = 0; i < count; ++i) {
+        auto &tmp = mymap[vec_key[i]];
+        if (tmp == count){
+            std::cout << tmp << std::endl;
+        }
+    }
+    std::cout << "shm_flat_hashmap get time:" << rtimer.get_time_us() << std::endl;
+
+    levin::Timer miss_timer;
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hits += mymap.count(vec_key[i] + count);
+    }
+    std::cout << "shm_flat_hashmap miss time:" << miss_timer.get_time_us() << ", hits=" << hits << std::endl;
 
     levin::Timer traversal_timer;
     for(auto item : mymap){
@@ -103,8 +188,52 @@ void test_shared_hashmap(const std::vector<size_t> &vec_key) {
             std::cout << key << " ===== " << value << std::endl;
         }
     }
-    std::cout << "shm_hashmap traversal_time:" << traversal_timer.get_time_us() << std::endl;
-    std::cout << "shm_hashmap bucket_count=" << mymap.bucket_size() << std::endl;
+    std::cout << "shm_flat_hashmap traversal_time:" << traversal_timer.get_time_us() << std::endl;
+    std::cout << "shm_flat_hashmap group_count=" << mymap.group_count()
+              << ", load_factor=" << mymap.load_factor() << std::endl;
+
+    mymap.Destroy();
+}
+
+void dump_shared_perfect_hashmap() {
+    std::string name = "./sperfect_hashmap_bench.dat";
+    std::unordered_map<uint64_t, uint32_t> map_data;
+    for (size_t i = 0; i < count; ++i) {
+        map_data[i] = i + 100;
+    }
+    levin::Timer dump_timer;
+    levin::SharedPerfectHashMap<uint64_t, uint32_t>::Dump(name, map_data);
+    std::cout << "shm_perfect_hashmap dump time:" << dump_timer.get_time_us() << std::endl;
+    std::unordered_map<uint64_t, uint32_t>().swap(map_data);
+}
+
+void test_shared_perfect_hashmap(const std::vector<size_t> &vec_key) {
+    MemDiffer differ;
+    std::string name = "./sperfect_hashmap_bench.dat";
+    levin::SharedPerfectHashMap<uint64_t, uint32_t> mymap(name);
+    if (mymap.Init() != SC_RET_OK || mymap.Load() != SC_RET_OK) {
+        std::cout << "init or load failed.";
+        return;
+    }
+    std::cout << differ.get_diff_report_kb() << std::endl;
+
+    levin::Timer rtimer;
+    for (size_t i = 0; i < count; ++i) {
+        auto &tmp = mymap[vec_key[i]];
+        if (tmp == count){
+            std::cout << tmp << std::endl;
+        }
+    }
+    std::cout << "shm_perfect_hashmap get time:" << rtimer.get_time_us() << std::endl;
+
+    levin::Timer miss_timer;
+    size_t hits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hits += mymap.count(vec_key[i] + count);
+    }
+    std::cout << "shm_perfect_hashmap miss time:" << miss_timer.get_time_us() << ", hits=" << hits << std::endl;
+    std::cout << "shm_perfect_hashmap index bits per key=" << mymap.bits_per_key()
+              << ", fingerprint bits=" << mymap.fingerprint_bits() << std::endl;
 
     mymap.Destroy();
 }
@@ -214,11 +343,63 @@ void compare_map() {
     test_shared_map(vec_key);
     dump_shared_hashmap();
     test_shared_hashmap(vec_key);
+    dump_shared_hashmap(BucketOptions(BucketReduce::Pow2));
+    test_shared_hashmap(vec_key, "shm_hashmap_pow2");
+    dump_shared_hashmap(BucketOptions(BucketReduce::Mod, 4.0, 0, BucketLayout::Split));
+    test_shared_hashmap(vec_key, "shm_hashmap_split_lf4");
+    dump_shared_hashmap(BucketOptions(BucketReduce::Mod, 4.0));
+    test_shared_hashmap(vec_key, "shm_hashmap_lf4");
+    dump_shared_hashmap();
+    dump_shared_flat_hashmap();
+    test_shared_flat_hashmap(vec_key);
+    dump_shared_perfect_hashmap();
+    test_shared_perfect_hashmap(vec_key);
     test_std_hashmap(vec_key);
     test_interprocess_map(vec_key);
     test_std_map(vec_key);
 }
 
+// ************************* numa ************************* //
+void test_numa_hashmap(const std::vector<size_t> &vec_key, int node) {
+    std::string name = "./shashmap_bench.dat";
+    levin::SharedHashMap<uint64_t, uint32_t, std::hash<uint64_t>, HeapMemory> mymap(name);
+    ContainerOptions options;
+    options.numa_policy = NumaPolicy::Bind;
+    options.numa_node = node;
+    mymap.SetOptions(options);
+    if (mymap.Init() != SC_RET_OK || mymap.Load() != SC_RET_OK) {
+        std::cout << "init or load failed.";
+        return;
+    }
+
+    levin::Timer rtimer;
+    for (size_t i = 0; i < count; ++i) {
+        auto &tmp = mymap[vec_key[i]];
+        if (tmp == count){
+            std::cout << tmp << std::endl;
+        }
+    }
+    std::cout << "shm_hashmap on node " << node
+              << (node == CurrentNumaNode() ? "(local)" : "(remote)")
+              << " get time:" << rtimer.get_time_us() << std::endl;
+}
+
+void compare_numa_map() {
+    // pin lookup thread to current cpu, then compare hashmap bound to local/remote node
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(sched_getcpu(), &cpu_set);
+    sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+    std::cout << "numa node num=" << NumaNodeNum() << ", current node=" << CurrentNumaNode() << std::endl;
+
+    std::vector<size_t> vec_key;
+    make_mapdata(vec_key);
+    dump_shared_hashmap();
+    for (int node = 0; node < NumaNodeNum(); ++node) {
+        test_numa_hashmap(vec_key, node);
+    }
+}
+
 // ************************* nested map ************************* //
 void make_nested_mapdata(std::vector<std::pair<size_t, size_t> > &vec_key) {
     srand((unsigned)time(NULL)); 
@@ -254,6 +435,19 @@ void test_shared_nested_map(const std::vector<std::pair<size_t, size_t> > &vec_k
     }
     std::cout << "shm nested map get time:" << rtimer.get_time_us() << std::endl;
 
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back(vec_key[i].first);
+    }
+    std::vector<const levin::SharedNestedHashMap<uint64_t, uint32_t>::data_array_type*> arrays(count);
+    levin::Timer batch_timer;
+    size_t found = 0;
+    for (size_t i = 0; i < count; i += batch_size) {
+        found += mymap.find_batch(&keys[i], std::min(batch_size, count - i), &arrays[i]);
+    }
+    std::cout << "shm nested map find_batch(" << batch_size << ") time:" << batch_timer.get_time_us()
+              << ", found=" << found << std::endl;
+
     levin::Timer traversal_timer;
     for (auto item : mymap) {
         auto key = item.first;
@@ -343,6 +537,8 @@ int main() {
     levin::compare_map();
     std::cout << "---------------------" << std::endl;
     levin::compare_nested_map();
+    std::cout << "---------------------" << std::endl;
+    levin::compare_numa_map();
 
     return 0;
 }
@@ -239,6 +239,60 @@ protected:
     }
 };
 
+TEST_F(SharedHashSetTest, test_bucket_options) {
+    std::unordered_set<uint64_t> in;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        in.insert(i << 10);
+    }
+    std::vector<BucketOptions> options = {BucketOptions(), BucketOptions(BucketReduce::Mod, 0.75),
+            BucketOptions(BucketReduce::Pow2, 1.0)};
+    for (const auto &option : options) {
+        std::string name = "./hashset_bucket_options.dat";
+        ASSERT_TRUE(SharedHashSet<uint64_t>::Dump(name, in, option));
+        SharedHashSet<uint64_t> set(name);
+        ASSERT_EQ(set.Init(), SC_RET_OK);
+        ASSERT_EQ(set.Load(), SC_RET_OK);
+        EXPECT_EQ(set.bucket_reduce(), option.reduce);
+        EXPECT_EQ(set.bucket_count(), BucketCountOf(option, in.size(), in.bucket_count()));
+        ASSERT_EQ(set.size(), in.size());
+        for (const auto &key : in) {
+            ASSERT_EQ(set.count(key), 1);
+            ASSERT_EQ(*set.find(key), key);
+        }
+        EXPECT_EQ(set.count(1), 0);
+        set.Destroy();
+    }
+}
+
+TEST_F(SharedHashSetTest, test_find_batch) {
+    std::unordered_set<uint64_t> in;
+    for (uint64_t i = 0; i < 3000; ++i) {
+        in.insert(i * 2);
+    }
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 500; ++i) {
+        keys.push_back(i * 3);
+    }
+    for (auto reduce : {BucketReduce::Mod, BucketReduce::Pow2}) {
+        std::string name = "./hashset_find_batch.dat";
+        ASSERT_TRUE(SharedHashSet<uint64_t>::Dump(name, in, BucketOptions(reduce)));
+        SharedHashSet<uint64_t> set(name);
+        ASSERT_EQ(set.Init(), SC_RET_OK);
+        ASSERT_EQ(set.Load(), SC_RET_OK);
+        std::vector<const uint64_t*> results(keys.size());
+        EXPECT_EQ(set.find_batch(keys.data(), keys.size(), results.data()), 250);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            set.prefetch(keys[i]);
+            if (in.count(keys[i])) {
+                ASSERT_EQ(results[i], set.find(keys[i]));
+            } else {
+                ASSERT_TRUE(results[i] == nullptr);
+            }
+        }
+        set.Destroy();
+    }
+}
+
 TEST_F(HashSetTest, test_default_construct) {
     // default construct
     {
@@ -8,6 +8,7 @@ namespace levin {
 
 static const size_t COUNT = 1000000;
 static const int    RUN_TIMES = 1;
+static const size_t BATCH_SIZE = 256;
 
 void gen_keys(std::vector<int32_t> &access_keys) {
     srand(time(nullptr));
@@ -45,6 +46,18 @@ void test_shared_hashset(const std::vector<int32_t> &keys, const std::vector<int
     }
     std::cout << "SharedHashSet set hit:" << hit << std::endl;
     std::cout << "SharedHashSet find time:" << rtimer.get_time_us() << std::endl;
+
+    // keys of a request found together
+    std::vector<const int32_t*> results(COUNT);
+    levin::Timer btimer;
+    hit = 0;
+    for (int times = 0; times < RUN_TIMES; ++times) {
+        for (size_t i = 0; i < COUNT; i += BATCH_SIZE) {
+            hit += hst.find_batch(&access_keys[i], std::min(BATCH_SIZE, COUNT - i), &results[i]);
+        }
+    }
+    std::cout << "SharedHashSet find_batch(" << BATCH_SIZE << ") hit:" << hit
+              << ", time:" << btimer.get_time_us() << std::endl;
     levin::Timer ttimer;
     for (int times = 0; times < RUN_TIMES; ++times) {
         for (auto &elem : hst) {
@@ -76,6 +76,34 @@ TEST_F(ShmTest, test_existed_shm) {
     EXPECT_TRUE(flag);
 }
 
+// 大页创建共享内存, 无大页时回退普通页
+TEST_F(ShmTest, test_huge_page) {
+    std::string file = "/tmp";
+    const size_t memsize = 6000;
+    SharedMemory shm(file, 4, memsize);
+    ContainerOptions options;
+    options.huge_page_size = 2UL << 20;
+    shm.set_options(options);
+    uint32_t res = shm.init(fixed_len);
+    EXPECT_EQ(res, SC_RET_OK);
+    EXPECT_EQ(shm.get_size(), memsize + fixed_len);
+    EXPECT_TRUE(shm.reserved_size() == (2UL << 20) || shm.reserved_size() == memsize + fixed_len);
+    memset(shm.get_address(), 1, shm.get_size());
+    EXPECT_TRUE(shm.remove());
+}
+
+// 只读模式不创建共享内存
+TEST_F(ShmTest, test_read_only) {
+    std::string file = "/tmp";
+    const size_t memsize = 6000;
+    SharedMemory shm(file, 5, memsize);
+    ContainerOptions options;
+    options.read_only = true;
+    shm.set_options(options);
+    EXPECT_EQ(shm.init(fixed_len), SC_RET_SHM_NOEXIST);
+    EXPECT_EQ(shm.get_address(), nullptr);
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
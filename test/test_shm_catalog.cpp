@@ -0,0 +1,220 @@
+#include "shm_catalog.h"
+#include "svec.hpp"
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class ShmCatalogTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+    }
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(ShmCatalogTest, test_insert_find_erase) {
+    ShmCatalog &catalog = ShmCatalog::GetInstance();
+    ASSERT_TRUE(catalog.IsValid());
+    std::string path = "/tmp/levin_catalog_test.dat";
+    CatalogEntry entry(path, "test_group", 123456789, 7, 4096);
+    EXPECT_TRUE(catalog.Insert(entry));
+
+    CatalogEntry found;
+    ASSERT_TRUE(catalog.Find(path, found));
+    EXPECT_EQ(found.shmid, 123456789);
+    EXPECT_EQ(found.appid, 7);
+    EXPECT_EQ(found.size, 4096);
+    EXPECT_EQ(found.state, CatalogState::Loading);
+    EXPECT_STREQ(found.group, "test_group");
+
+    EXPECT_TRUE(catalog.Update(path, 123456789, CatalogState::Ready, 2));
+    EXPECT_FALSE(catalog.Update(path, 1, CatalogState::Ready, 2));
+    ASSERT_TRUE(catalog.FindById(123456789, found));
+    EXPECT_EQ(found.state, CatalogState::Ready);
+    EXPECT_EQ(found.version, 2);
+
+    // replaced by entry of the same path
+    entry.shmid = 987654321;
+    EXPECT_TRUE(catalog.Insert(entry));
+    EXPECT_FALSE(catalog.FindById(123456789, found));
+    EXPECT_FALSE(catalog.Erase(path, 123456789));
+    EXPECT_TRUE(catalog.Erase(path, 987654321));
+    EXPECT_FALSE(catalog.Find(path, found));
+}
+
+TEST_F(ShmCatalogTest, test_stale_entry) {
+    ShmCatalog &catalog = ShmCatalog::GetInstance();
+    std::string path = "/tmp/levin_catalog_stale.dat";
+    // shm removed out of levin
+    EXPECT_TRUE(catalog.Insert(CatalogEntry(path, "test_group", 123456788, 1, 4096)));
+    std::vector<SharedMidInfo> shmid_info;
+    EXPECT_TRUE(SharedMemory::get_all_shmid(shmid_info, false));
+    for (const auto &info : shmid_info) {
+        EXPECT_NE(info.path, path);
+    }
+    CatalogEntry found;
+    EXPECT_FALSE(catalog.Find(path, found));
+}
+
+TEST_F(ShmCatalogTest, test_container) {
+    std::string name = "./catalog_vec.dat";
+    std::vector<int> in = {1, 2, 3};
+    EXPECT_TRUE(SharedVector<int>::Dump(name, in));
+    SharedVector<int> vec(name, "catalog_group", 3);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    CatalogEntry found;
+    ASSERT_TRUE(ShmCatalog::GetInstance().Find(name, found));
+    EXPECT_EQ(found.state, CatalogState::Loading);
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    ASSERT_TRUE(ShmCatalog::GetInstance().Find(name, found));
+    EXPECT_EQ(found.state, CatalogState::Ready);
+    EXPECT_EQ(found.appid, 3);
+    EXPECT_STREQ(found.group, "catalog_group");
+    EXPECT_EQ(VersionOfFlags(found.version), (uint8_t)SharedBase::SC_VERSION);
+
+    // listed without attach
+    std::vector<SharedMidInfo> shmid_info;
+    EXPECT_TRUE(SharedMemory::get_all_shmid(shmid_info, false));
+    bool is_listed = false;
+    for (const auto &info : shmid_info) {
+        if (info.path == name) {
+            is_listed = true;
+            EXPECT_EQ(info.mid, found.shmid);
+            EXPECT_EQ(info.groupid, "catalog_group");
+        }
+    }
+    EXPECT_TRUE(is_listed);
+    vec.Destroy();
+    EXPECT_FALSE(ShmCatalog::GetInstance().Find(name, found));
+}
+
+TEST_F(ShmCatalogTest, test_load_once) {
+    std::string name = "./catalog_load.dat";
+    std::vector<uint64_t> in(1 << 20, 5);
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, in));
+    // concurrent processes: exactly one loads, others wait and attach
+    const int num = 4;
+    std::vector<pid_t> pids;
+    for (int i = 0; i < num; ++i) {
+        pid_t pid = fork();
+        ASSERT_NE(pid, -1);
+        if (pid == 0) {
+            SharedVector<uint64_t> vec(name);
+            if (vec.Init() != SC_RET_OK) {
+                _exit(2);
+            }
+            bool is_exist = vec.IsExist();
+            if (vec.Load() != SC_RET_OK || vec.size() != in.size() || vec[100] != 5) {
+                _exit(2);
+            }
+            _exit(is_exist ? 1 : 0);
+        }
+        pids.push_back(pid);
+    }
+    int loaded = 0;
+    for (auto pid : pids) {
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_NE(WEXITSTATUS(status), 2);
+        loaded += (WEXITSTATUS(status) == 0);
+    }
+    EXPECT_EQ(loaded, 1);
+    SharedVector<uint64_t> vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_TRUE(vec.IsExist());
+    vec.Destroy();
+}
+
+TEST_F(ShmCatalogTest, test_loader_died) {
+    std::string name = "./catalog_load.dat";
+    std::vector<uint64_t> in(1000, 6);
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, in));
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        // created but never loaded
+        SharedVector<uint64_t> vec(name);
+        _exit(vec.Init() == SC_RET_OK ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    CatalogEntry found;
+    ASSERT_TRUE(ShmCatalog::GetInstance().Find(name, found));
+    EXPECT_EQ(found.state, CatalogState::Loading);
+    EXPECT_EQ(found.loader_pid, pid);
+
+    // reader never takes over
+    ContainerOptions options;
+    options.read_only = true;
+    SharedVector<uint64_t> reader(name);
+    reader.SetOptions(options);
+    EXPECT_EQ(reader.Init(), SC_RET_SHM_NOEXIST);
+
+    SharedVector<uint64_t> vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_FALSE(vec.IsExist());
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_EQ(vec.size(), in.size());
+    ASSERT_TRUE(ShmCatalog::GetInstance().Find(name, found));
+    EXPECT_EQ(found.state, CatalogState::Ready);
+    EXPECT_EQ(found.shmid, static_cast<SharedMemory*>(vec._info->_mem.get())->get_shmid());
+    vec.Destroy();
+}
+
+TEST_F(ShmCatalogTest, test_wait_loading) {
+    std::string name = "./catalog_load.dat";
+    std::vector<uint64_t> in(1000, 7);
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, in));
+    int inited[2], resumed[2];
+    ASSERT_EQ(pipe(inited), 0);
+    ASSERT_EQ(pipe(resumed), 0);
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        SharedVector<uint64_t> vec(name);
+        char c = (vec.Init() == SC_RET_OK ? 1 : 0);
+        if (write(inited[1], &c, 1) != 1 || read(resumed[0], &c, 1) != 1) {
+            _exit(1);
+        }
+        usleep(100000);
+        _exit(vec.Load() == SC_RET_OK ? 0 : 1);
+    }
+    char c = 0;
+    ASSERT_EQ(read(inited[0], &c, 1), 1);
+    ASSERT_EQ(c, 1);
+    // loader alive and loading: wait timeout
+    ContainerOptions options;
+    options.load_wait_timeout_ms = 200;
+    {
+        SharedVector<uint64_t> vec(name);
+        vec.SetOptions(options);
+        EXPECT_EQ(vec.Init(), SC_RET_LOADING);
+    }
+    // wait until published Ready, then attach
+    ASSERT_EQ(write(resumed[1], &c, 1), 1);
+    SharedVector<uint64_t> vec(name);
+    ASSERT_EQ(vec.Init(), SC_RET_OK);
+    EXPECT_TRUE(vec.IsExist());
+    ASSERT_EQ(vec.Load(), SC_RET_OK);
+    EXPECT_EQ(vec[999], 7);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    vec.Destroy();
+    for (int fd : {inited[0], inited[1], resumed[0], resumed[1]}) {
+        close(fd);
+    }
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
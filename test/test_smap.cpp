@@ -181,6 +181,41 @@ TEST_F(SharedMapTest, test_smap_diff) {
     mymap.Destroy();
 }
 
+TEST_F(SharedMapTest, test_static_DumpSorted) {
+    std::string expect_name = "./smap_sorted_expect.dat";
+    std::string name = "./smap_sorted.dat";
+    EXPECT_TRUE((SharedMap<uint64_t, uint64_t>::Dump(expect_name, map_kv64)));
+    std::vector<std::pair<uint64_t, uint64_t> > sorted(map_kv64.begin(), map_kv64.end());
+    EXPECT_TRUE((SharedMap<uint64_t, uint64_t>::DumpSorted(name, sorted.begin(), sorted.end())));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+    size_t idx = 0;
+    EXPECT_TRUE((SharedMap<uint64_t, uint64_t>::DumpSorted(name,
+            [&sorted, &idx](std::pair<uint64_t, uint64_t> &kv) {
+        if (idx == sorted.size()) {
+            return false;
+        }
+        kv = sorted[idx++];
+        return true;
+    })));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+
+    // NOT ordered or NOT unique: fail and file removed
+    std::vector<std::pair<uint64_t, uint64_t> > unsorted = {{1, 1}, {3, 3}, {2, 2}};
+    EXPECT_FALSE((SharedMap<uint64_t, uint64_t>::DumpSorted(name, unsorted.begin(), unsorted.end())));
+    EXPECT_NE(access(name.c_str(), F_OK), 0);
+    std::vector<std::pair<uint64_t, uint64_t> > duplicated = {{1, 1}, {1, 2}};
+    EXPECT_FALSE((SharedMap<uint64_t, uint64_t>::DumpSorted(name, duplicated.begin(), duplicated.end())));
+
+    std::vector<std::pair<uint64_t, uint64_t> > desc = {{3, 3}, {2, 2}, {1, 1}};
+    EXPECT_TRUE((SharedMap<uint64_t, uint64_t, std::greater<uint64_t> >::DumpSorted(
+            name, desc.begin(), desc.end())));
+    SharedMap<uint64_t, uint64_t, std::greater<uint64_t> > map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    EXPECT_EQ(map.at(2), 2);
+    map.Destroy();
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
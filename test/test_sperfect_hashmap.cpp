@@ -0,0 +1,183 @@
+#include "sperfect_hashmap.hpp"
+#include <map>
+#include <unordered_map>
+#include <gtest/gtest.h>
+#include "test_header.h"
+
+namespace levin {
+
+class SharedPerfectHashMapTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+    }
+    virtual void TearDown() {
+    }
+};
+
+TEST_F(SharedPerfectHashMapTest, test_BuildPartition) {
+    std::vector<uint64_t> hashes;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        hashes.push_back(HashMix64(i));
+    }
+    std::vector<uint16_t> pilots;
+    std::vector<uint32_t> free;
+    std::vector<uint32_t> indexes;
+    ASSERT_TRUE((PerfectHashMap<uint64_t, uint64_t>::BuildPartition(hashes, pilots, free, indexes)));
+    EXPECT_EQ(pilots.size(), PerfectKeyHash::BucketCount(hashes.size()));
+    EXPECT_EQ(free.size(), PerfectKeyHash::TableSize(hashes.size()) - hashes.size());
+    // minimal perfect: indexes are a permutation of [0, size)
+    std::vector<bool> used(hashes.size(), false);
+    for (auto idx : indexes) {
+        ASSERT_LT(idx, hashes.size());
+        EXPECT_FALSE(used[idx]);
+        used[idx] = true;
+    }
+}
+
+TEST_F(SharedPerfectHashMapTest, test_static_Dump_Load_empty) {
+    std::string name = "./perfect_hashmap_empty.dat";
+    std::unordered_map<uint64_t, uint32_t> in;
+    EXPECT_TRUE((SharedPerfectHashMap<uint64_t, uint32_t>::Dump(name, in)));
+    SharedPerfectHashMap<uint64_t, uint32_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.begin() == map.end());
+    EXPECT_TRUE(map.find(1) == nullptr);
+    EXPECT_EQ(map.count(1), 0);
+    EXPECT_THROW(map.at(1), std::out_of_range);
+    map.Destroy();
+}
+
+TEST_F(SharedPerfectHashMapTest, test_Dump_Load) {
+    std::string name = "./perfect_hashmap.dat";
+    // several partitions
+    const uint64_t num = PERFECT_PARTITION_KEYS * 3;
+    std::unordered_map<uint64_t, uint32_t> in;
+    for (uint64_t i = 0; i < num; ++i) {
+        in[i * 7919] = i;
+    }
+    ASSERT_TRUE((SharedPerfectHashMap<uint64_t, uint32_t>::Dump(name, in)));
+    SharedPerfectHashMap<uint64_t, uint32_t> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    LEVIN_CDEBUG_LOG("%s", map.layout().c_str());
+    ASSERT_EQ(map.size(), num);
+    EXPECT_EQ(map.fingerprint_bits(), 16);
+    EXPECT_LT(map.bits_per_key(), 3.2);
+    for (const auto &kv : in) {
+        const uint32_t *value = map.find(kv.first);
+        ASSERT_TRUE(value != nullptr);
+        ASSERT_EQ(*value, kv.second);
+        ASSERT_EQ(map.at(kv.first), kv.second);
+        ASSERT_EQ(map[kv.first], kv.second);
+    }
+    // absent keys rejected by fingerprint but ~1/65536
+    size_t false_positive = 0;
+    for (uint64_t i = 0; i < num; ++i) {
+        false_positive += map.count(i * 7919 + 1);
+    }
+    EXPECT_LT(false_positive, num / 10000);
+    // values in order of index
+    std::vector<bool> visited(num, false);
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        ASSERT_LT(*it, num);
+        EXPECT_FALSE(visited[*it]);
+        visited[*it] = true;
+    }
+    map.Destroy();
+}
+
+TEST_F(SharedPerfectHashMapTest, test_fingerprint_bits) {
+    std::map<int, int> in;
+    for (int i = 0; i < 1000; ++i) {
+        in[i] = -i;
+    }
+    EXPECT_FALSE((SharedPerfectHashMap<int, int>::Dump("./perfect_hashmap_fp.dat", in, 12)));
+    for (uint32_t bits : {0, 8, 32}) {
+        std::string name = "./perfect_hashmap_fp" + std::to_string(bits) + ".dat";
+        ASSERT_TRUE((SharedPerfectHashMap<int, int>::Dump(name, in, bits)));
+        SharedPerfectHashMap<int, int> map(name);
+        ASSERT_EQ(map.Init(), SC_RET_OK);
+        ASSERT_EQ(map.Load(), SC_RET_OK);
+        EXPECT_EQ(map.fingerprint_bits(), bits);
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(map.at(i), -i);
+        }
+        // without fingerprint, absent key mapped to value of some key
+        if (bits == 0) {
+            ASSERT_TRUE(map.find(1000) != nullptr);
+            EXPECT_LT(map.index(1000), map.size());
+        }
+        map.Destroy();
+    }
+}
+
+TEST_F(SharedPerfectHashMapTest, test_Dump_duplicated) {
+    std::vector<std::pair<int, int> > in = {{1, 10}, {2, 20}, {1, 30}};
+    EXPECT_FALSE((SharedPerfectHashMap<int, int>::Dump("./perfect_hashmap_dup.dat", in)));
+}
+
+TEST_F(SharedPerfectHashMapTest, test_type_hash) {
+    std::string name = "./perfect_hashmap_type.dat";
+    std::map<int, int> in = {{1, 1}};
+    ASSERT_TRUE((SharedPerfectHashMap<int, int>::Dump(name, in)));
+    SharedPerfectHashMap<int, long> map(name);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    EXPECT_EQ(map.Load(), SC_RET_LOAD_FAIL);
+}
+
+TEST_F(SharedPerfectHashMapTest, test_builder_threads) {
+    // enough records for several partitions per thread
+    const uint64_t num = PERFECT_PARTITION_KEYS * 8;
+    uint32_t thread_num = GetDumpThreads();
+    std::vector<std::string> names = {"./perfect_hashmap_t1.dat", "./perfect_hashmap_t4.dat"};
+    std::vector<uint32_t> threads = {1, 4};
+    for (size_t t = 0; t < threads.size(); ++t) {
+        SetDumpThreads(threads[t]);
+        SharedPerfectHashMapBuilder<uint64_t, uint64_t> builder;
+        for (uint64_t i = 0; i < num; ++i) {
+            builder.Add(i * 31, i);
+        }
+        ASSERT_TRUE(builder.Dump(names[t]));
+        EXPECT_EQ(builder.size(), 0);
+    }
+    SetDumpThreads(thread_num);
+    // layout is the same whatever threads
+    EXPECT_TRUE(read_file(names[0]) == read_file(names[1]));
+
+    SharedPerfectHashMap<uint64_t, uint64_t> map(names[1]);
+    ASSERT_EQ(map.Init(), SC_RET_OK);
+    ASSERT_EQ(map.Load(), SC_RET_OK);
+    ASSERT_EQ(map.size(), num);
+    for (uint64_t i = 0; i < num; i += 97) {
+        ASSERT_EQ(map.at(i * 31), i);
+    }
+    map.Destroy();
+}
+
+TEST_F(SharedPerfectHashMapTest, test_Build) {
+    SharedPerfectHashMapBuilder<uint64_t, uint32_t> builder(8);
+    SharedPerfectHashMapBuilder<uint64_t, uint32_t> dump_builder(8);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        builder.Add(i, i * 2);
+        dump_builder.Add(i, i * 2);
+    }
+    SharedPerfectHashMap<uint64_t, uint32_t> map("./build_perfect_hashmap");
+    ASSERT_EQ(map.Build(builder), SC_RET_OK);
+    EXPECT_EQ(builder.size(), 0);
+    ASSERT_EQ(map.size(), 1000);
+    EXPECT_EQ(map.at(7), 14);
+    // exported the same as dumped
+    ASSERT_TRUE(dump_builder.Dump("./build_perfect_hashmap_dump.dat"));
+    ASSERT_TRUE(map.Export("./build_perfect_hashmap_export.dat"));
+    EXPECT_TRUE(read_file("./build_perfect_hashmap_dump.dat") == read_file("./build_perfect_hashmap_export.dat"));
+    map.Destroy();
+}
+
+}  // namespace levin
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -269,6 +269,19 @@ TEST_F(CustomSetTest, test_default_construct) {
     }
 }
 
+TEST_F(SharedSetTest, test_static_DumpSorted) {
+    std::string expect_name = "./sset_sorted_expect.dat";
+    std::string name = "./sset_sorted.dat";
+    std::set<int> st = {1, 5, 9, 100};
+    EXPECT_TRUE(SharedSet<int>::Dump(expect_name, st));
+    std::vector<int> sorted(st.begin(), st.end());
+    EXPECT_TRUE(SharedSet<int>::DumpSorted(name, sorted.begin(), sorted.end()));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+    std::vector<int> duplicated = {1, 5, 5, 9};
+    EXPECT_FALSE(SharedSet<int>::DumpSorted(name, duplicated.begin(), duplicated.end()));
+    EXPECT_NE(access(name.c_str(), F_OK), 0);
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {
@@ -1,5 +1,6 @@
 #include "svec.hpp"
 #include <vector>
+#include <list>
 #include <gtest/gtest.h>
 #include "test_header.h"
 
@@ -232,6 +233,58 @@ TEST_F(SharedNestedVectorTest, test_diff) {
     vec.Destroy();
 }
 
+TEST_F(SharedVectorTest, test_static_Dump_range) {
+    std::vector<uint64_t> in;
+    for (uint64_t i = 0; i < 300000; ++i) {
+        in.push_back(i * 3);
+    }
+    std::string expect_name = "./vec_range_expect.dat";
+    std::string name = "./vec_range.dat";
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(expect_name, in));
+    // input range NOT random access, written by a bounded buffer
+    std::list<uint64_t> lst(in.begin(), in.end());
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, lst.begin(), lst.end()));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+    uint64_t next = 0;
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, [&next](uint64_t &elem) {
+        elem = next * 3;
+        return next++ < 300000;
+    }));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+    // empty range
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(name, lst.end(), lst.end()));
+    EXPECT_TRUE(SharedVector<uint64_t>::Dump(expect_name, std::vector<uint64_t>()));
+    EXPECT_TRUE(read_file(name) == read_file(expect_name));
+}
+
+TEST_F(SharedNestedVectorTest, test_Build) {
+    std::vector<std::vector<uint64_t> > in = {{1, 2, 3}, {}, {100, 101}, {777}};
+    // built in place, the same image as loaded from binfile
+    levin::SharedNestedVector<uint64_t> vec("./nestvec_build");
+    ASSERT_EQ(vec.Build(in), SC_RET_OK);
+    EXPECT_TRUE(vec.IsVerified());
+    ASSERT_EQ(vec.size(), in.size());
+    EXPECT_EQ(vec[2][1], 101);
+    EXPECT_TRUE(vec[1].empty());
+    std::string dump_name = "./nestvec_build_dump.dat";
+    std::string export_name = "./nestvec_build_export.dat";
+    EXPECT_TRUE(levin::SharedNestedVector<uint64_t>::Dump(dump_name, in));
+    EXPECT_TRUE(vec.Export(export_name));
+    EXPECT_TRUE(read_file(dump_name) == read_file(export_name));
+
+    // rebuilt: region of the same name replaced
+    levin::SharedVector<int, levin::HeapMemory> heap_vec("./vec_build");
+    ASSERT_EQ(heap_vec.Build(std::vector<int>{5, 6}), SC_RET_OK);
+    EXPECT_EQ(heap_vec[1], 6);
+    levin::SharedNestedVector<uint64_t> rebuilt("./nestvec_build");
+    ASSERT_EQ(rebuilt.Build(std::vector<std::vector<uint64_t> >{{9}}), SC_RET_OK);
+    EXPECT_EQ(rebuilt[0][0], 9);
+    EXPECT_EQ(vec[2][1], 101);
+    rebuilt.Destroy();
+    vec.Destroy();
+    heap_vec.Destroy();
+}
+
 }  // namespace levin
 
 int main(int argc, char** argv) {